@@ -0,0 +1,171 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ActorPool.h"
+#include "PrincessPig.h"
+#include "PooledActor.h"
+#include "Components/SceneComponent.h"
+#include "GameFramework/Pawn.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "WorldActorCache.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pool Hits"), STAT_PPPoolHits, STATGROUP_PrincessPig);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pool Misses"), STAT_PPPoolMisses, STATGROUP_PrincessPig);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pooled Actors Free"), STAT_PPPooledActorsFree, STATGROUP_PrincessPig);
+DECLARE_CYCLE_STAT(TEXT("Pool Acquire"), STAT_PPPoolAcquire, STATGROUP_PrincessPig);
+
+AActorPool::AActorPool()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	bReplicates = false;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>("Root");
+
+	MaxFreePerClass = 16;
+}
+
+AActorPool* AActorPool::GetActorPool(const UObject* WorldContextObject)
+{
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::ReturnNull);
+	if (nullptr == World || World->IsNetMode(NM_Client))
+	{
+		return nullptr;
+	}
+
+	if (AActorPool* Existing = TPPWorldActorCache<AActorPool>::Find(World))
+	{
+		return Existing;
+	}
+
+	// Cached now as well as in BeginPlay, in case play hasn't begun yet
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.ObjectFlags |= RF_Transient;
+	AActorPool* Pool = World->SpawnActor<AActorPool>(SpawnParams);
+	if (Pool)
+	{
+		TPPWorldActorCache<AActorPool>::Add(Pool);
+	}
+	return Pool;
+}
+
+void AActorPool::BeginPlay()
+{
+	Super::BeginPlay();
+
+	TPPWorldActorCache<AActorPool>::Add(this);
+
+	for (const FPPActorPoolPrewarm& Entry : Prewarm)
+	{
+		PrewarmClass(Entry.ActorClass.LoadSynchronous(), Entry.Count);
+	}
+}
+
+void AActorPool::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	TPPWorldActorCache<AActorPool>::Remove(this);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+APooledActor* AActorPool::SpawnPooledActor(UClass* ActorClass, const FTransform& Transform, bool bInUse)
+{
+	APooledActor* Actor = GetWorld()->SpawnActorDeferred<APooledActor>(ActorClass, Transform, nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+	if (Actor)
+	{
+		Actor->OwningPool = this;
+		if (!bInUse)
+		{
+			// Hidden and without collision before its components are even registered
+			Actor->InitReturnedToPool();
+		}
+		Actor->FinishSpawning(Transform);
+	}
+	return Actor;
+}
+
+void AActorPool::PrewarmClass(TSubclassOf<APooledActor> ActorClass, int32 Count)
+{
+	if (nullptr == *ActorClass)
+	{
+		return;
+	}
+
+	FPPActorPoolBucket& Bucket = Buckets.FindOrAdd(*ActorClass);
+	const FTransform Hidden(GetActorLocation());
+	while (Bucket.Free.Num() < Count)
+	{
+		APooledActor* Actor = SpawnPooledActor(*ActorClass, Hidden, false);
+		if (nullptr == Actor)
+		{
+			break;
+		}
+		Bucket.Free.Add(Actor);
+		INC_DWORD_STAT(STAT_PPPooledActorsFree);
+	}
+}
+
+APooledActor* AActorPool::AcquireActor(TSubclassOf<APooledActor> ActorClass, const FTransform& Transform, AActor* NewOwner, APawn* NewInstigator)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PPPoolAcquire);
+
+	if (nullptr == *ActorClass)
+	{
+		return nullptr;
+	}
+
+	APooledActor* Actor = nullptr;
+	FPPActorPoolBucket& Bucket = Buckets.FindOrAdd(*ActorClass);
+	while (Bucket.Free.Num() > 0 && nullptr == Actor)
+	{
+		Actor = Bucket.Free.Pop(false);
+		DEC_DWORD_STAT(STAT_PPPooledActorsFree);
+
+		// Destroyed by something else while it waited
+		if (Actor && Actor->IsPendingKillPending())
+		{
+			Actor = nullptr;
+		}
+	}
+
+	if (Actor)
+	{
+		INC_DWORD_STAT(STAT_PPPoolHits);
+		Actor->SetActorTransform(Transform, false, nullptr, ETeleportType::TeleportPhysics);
+	}
+	else
+	{
+		INC_DWORD_STAT(STAT_PPPoolMisses);
+		Actor = SpawnPooledActor(*ActorClass, Transform, true);
+		if (nullptr == Actor)
+		{
+			return nullptr;
+		}
+	}
+
+	Actor->SetOwner(NewOwner);
+	Actor->Instigator = NewInstigator;
+	Actor->OnAcquiredFromPool();
+	return Actor;
+}
+
+void AActorPool::ReleaseActor(APooledActor* Actor)
+{
+	if (nullptr == Actor || !Actor->IsInUse())
+	{
+		return;
+	}
+
+	FPPActorPoolBucket& Bucket = Buckets.FindOrAdd(Actor->GetClass());
+	if (Bucket.Free.Num() >= MaxFreePerClass)
+	{
+		Actor->Destroy();
+		return;
+	}
+
+	Actor->OnReturnedToPool();
+	Actor->SetOwner(nullptr);
+	Actor->Instigator = nullptr;
+	Bucket.Free.Add(Actor);
+	INC_DWORD_STAT(STAT_PPPooledActorsFree);
+}
@@ -0,0 +1,84 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "ActorPool.generated.h"
+
+class APooledActor;
+
+/** Actors of one class waiting to be reused */
+USTRUCT()
+struct FPPActorPoolBucket
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Transient)
+	TArray<APooledActor*> Free;
+};
+
+USTRUCT()
+struct FPPActorPoolPrewarm
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, Category = "Pool")
+	TSoftClassPtr<APooledActor> ActorClass;
+
+	UPROPERTY(EditAnywhere, Category = "Pool")
+	int32 Count;
+
+	FPPActorPoolPrewarm()
+		: Count(0)
+	{}
+};
+
+/**
+ * Server-side pool of APooledActors, so that smoke bombs, smoke clouds and other short-lived
+ * gameplay actors don't open a new actor channel, register components and create garbage every use.
+ *
+ * Spawned by the game mode when play starts, which also prewarms the classes listed in
+ * DefaultGame.ini under [/Script/PrincessPig.ActorPool].
+ */
+UCLASS(NotPlaceable, Transient, Config = Game)
+class PRINCESSPIG_API AActorPool : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AActorPool();
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/** Find or spawn the pool for this world. Returns null on clients */
+	UFUNCTION(BlueprintCallable, Category = "Pool", meta = (WorldContext = "WorldContextObject"))
+	static AActorPool* GetActorPool(const UObject* WorldContextObject);
+
+	/** Classes to spawn into the pool when play starts */
+	UPROPERTY(Config, EditAnywhere, Category = "Pool")
+	TArray<FPPActorPoolPrewarm> Prewarm;
+
+	/** Free actors kept per class. Anything returned past this is destroyed */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Pool")
+	int32 MaxFreePerClass;
+
+	/** Take an actor of ActorClass from the pool, or spawn one if none are free */
+	UFUNCTION(BlueprintCallable, Category = "Pool", meta = (DeterminesOutputType = "ActorClass"))
+	APooledActor* AcquireActor(TSubclassOf<APooledActor> ActorClass, const FTransform& Transform, AActor* NewOwner = nullptr, APawn* NewInstigator = nullptr);
+
+	/** Put Actor back in the pool. Prefer APooledActor::ReturnToPool */
+	void ReleaseActor(APooledActor* Actor);
+
+	/** Make sure at least Count actors of ActorClass are free */
+	UFUNCTION(BlueprintCallable, Category = "Pool")
+	void PrewarmClass(TSubclassOf<APooledActor> ActorClass, int32 Count);
+
+protected:
+	UPROPERTY(Transient)
+	TMap<UClass*, FPPActorPoolBucket> Buckets;
+
+	/** Spawn a new actor for the pool, either in use or already returned and never started up */
+	APooledActor* SpawnPooledActor(UClass* ActorClass, const FTransform& Transform, bool bInUse);
+};
@@ -0,0 +1,362 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "AvoidanceSolver.h"
+#include "PrincessPig.h"
+#include "PPCharacterMovementComponent.h"
+#include "Components/SceneComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "Async/ParallelFor.h"
+
+DECLARE_CYCLE_STAT(TEXT("Avoidance Gather"), STAT_PPAvoidanceGather, STATGROUP_PrincessPig);
+DECLARE_CYCLE_STAT(TEXT("Avoidance Solve"), STAT_PPAvoidanceSolve, STATGROUP_PrincessPig);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Avoidance Agents"), STAT_PPAvoidanceAgents, STATGROUP_PrincessPig);
+
+/** Directions tried either side of the desired one, in degrees */
+static const float AvoidanceSampleAngles[] = { 0.f, 15.f, -15.f, 30.f, -30.f, 50.f, -50.f, 75.f, -75.f, 100.f, -100.f };
+
+/** Speeds tried, as a fraction of the desired speed */
+static const float AvoidanceSampleSpeeds[] = { 1.f, 0.6f, 0.25f };
+
+AAvoidanceSolver::AAvoidanceSolver()
+{
+	// Solve after everyone has moved, results are used by next frame's moves
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickGroup = TG_PostPhysics;
+
+	bReplicates = false;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>("Root");
+
+	bEnabled = true;
+	TimeHorizon = 0.5f;
+	MaxNeighbours = 10;
+	MinAgentsForParallel = 64;
+	CellSize = 200.f;
+}
+
+AAvoidanceSolver* AAvoidanceSolver::GetAvoidanceSolver(const UObject* WorldContextObject)
+{
+	if (!GetDefault<AAvoidanceSolver>()->bEnabled)
+	{
+		return nullptr;
+	}
+
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::ReturnNull);
+	if (nullptr == World || World->IsNetMode(NM_Client))
+	{
+		return nullptr;
+	}
+
+	if (AAvoidanceSolver* Existing = FindAvoidanceSolver(World))
+	{
+		return Existing;
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.ObjectFlags |= RF_Transient;
+	return World->SpawnActor<AAvoidanceSolver>(SpawnParams);
+}
+
+AAvoidanceSolver* AAvoidanceSolver::FindAvoidanceSolver(const UObject* WorldContextObject)
+{
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::ReturnNull);
+	if (nullptr == World)
+	{
+		return nullptr;
+	}
+
+	for (TActorIterator<AAvoidanceSolver> It(World); It; ++It)
+	{
+		if (!It->IsPendingKill())
+		{
+			return *It;
+		}
+	}
+	return nullptr;
+}
+
+void AAvoidanceSolver::RegisterAgent(UPPCharacterMovementComponent* Agent)
+{
+	if (Agent && !Agents.Contains(Agent))
+	{
+		Agents.Add(Agent);
+		Agent->AvoidanceSolverIndex = INDEX_NONE;
+	}
+}
+
+void AAvoidanceSolver::UnregisterAgent(UPPCharacterMovementComponent* Agent)
+{
+	// Cleared rather than removed, so indices handed out this frame stay valid. Gather compacts
+	const int32 Index = Agents.IndexOfByKey(Agent);
+	if (Index != INDEX_NONE)
+	{
+		Agents[Index] = nullptr;
+		Agent->AvoidanceSolverIndex = INDEX_NONE;
+	}
+}
+
+void AAvoidanceSolver::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	Gather();
+
+	const int32 NumAgents = Agents.Num();
+	SET_DWORD_STAT(STAT_PPAvoidanceAgents, NumAgents);
+	if (NumAgents == 0)
+	{
+		return;
+	}
+
+	BuildGrid();
+
+	SCOPE_CYCLE_COUNTER(STAT_PPAvoidanceSolve);
+
+	// Every agent only writes its own result, so they can be solved in any order
+	ParallelFor(NumAgents, [this](int32 Index)
+	{
+		SolveAgent(Index);
+	}, NumAgents < MinAgentsForParallel);
+}
+
+void AAvoidanceSolver::Gather()
+{
+	SCOPE_CYCLE_COUNTER(STAT_PPAvoidanceGather);
+
+	Agents.RemoveAll([](const TWeakObjectPtr<UPPCharacterMovementComponent>& Agent) { return !Agent.IsValid(); });
+
+	const int32 NumAgents = Agents.Num();
+	PositionX.SetNumUninitialized(NumAgents, false);
+	PositionY.SetNumUninitialized(NumAgents, false);
+	VelocityX.SetNumUninitialized(NumAgents, false);
+	VelocityY.SetNumUninitialized(NumAgents, false);
+	DesiredX.SetNumUninitialized(NumAgents, false);
+	DesiredY.SetNumUninitialized(NumAgents, false);
+	Radius.SetNumUninitialized(NumAgents, false);
+	ConsiderationRadius.SetNumUninitialized(NumAgents, false);
+	GroupMask.SetNumUninitialized(NumAgents, false);
+	GroupsToAvoid.SetNumUninitialized(NumAgents, false);
+	GroupsToIgnore.SetNumUninitialized(NumAgents, false);
+	ResultX.SetNumUninitialized(NumAgents, false);
+	ResultY.SetNumUninitialized(NumAgents, false);
+
+	for (int32 i = 0; i < NumAgents; i++)
+	{
+		UPPCharacterMovementComponent* Agent = Agents[i].Get();
+		Agent->AvoidanceSolverIndex = i;
+
+		const FVector Origin = Agent->GetRVOAvoidanceOrigin();
+		const FVector Velocity = Agent->GetVelocityForRVOConsideration();
+		PositionX[i] = Origin.X;
+		PositionY[i] = Origin.Y;
+		VelocityX[i] = Velocity.X;
+		VelocityY[i] = Velocity.Y;
+		DesiredX[i] = Agent->DesiredAvoidanceVelocity.X;
+		DesiredY[i] = Agent->DesiredAvoidanceVelocity.Y;
+
+		// Agents between moves with avoidance switched off still get avoided, they just don't avoid anything
+		Radius[i] = Agent->GetRVOAvoidanceRadius();
+		ConsiderationRadius[i] = Agent->bUseRVOAvoidance ? Agent->GetRVOAvoidanceConsiderationRadius() : 0.f;
+		GroupMask[i] = Agent->GetAvoidanceGroupMask();
+		GroupsToAvoid[i] = Agent->GetGroupsToAvoidMask();
+		GroupsToIgnore[i] = Agent->GetGroupsToIgnoreMask();
+	}
+}
+
+void AAvoidanceSolver::BuildGrid()
+{
+	// Cells at least as big as anyone looks, so the 3x3 around an agent covers everything it considers
+	float LargestConsideration = 0.f;
+	for (float Consideration : ConsiderationRadius)
+	{
+		LargestConsideration = FMath::Max(LargestConsideration, Consideration);
+	}
+	CellSize = FMath::Max(LargestConsideration, 100.f);
+
+	const int32 NumAgents = Agents.Num();
+	AgentCells.SetNumUninitialized(NumAgents, false);
+	SortedAgents.SetNumUninitialized(NumAgents, false);
+	for (int32 i = 0; i < NumAgents; i++)
+	{
+		AgentCells[i] = GetCellKey(FMath::FloorToInt(PositionX[i] / CellSize), FMath::FloorToInt(PositionY[i] / CellSize));
+		SortedAgents[i] = i;
+	}
+	SortedAgents.Sort([this](int32 A, int32 B) { return AgentCells[A] < AgentCells[B]; });
+
+	CellStarts.Reset();
+	for (int32 i = 0; i < NumAgents; i++)
+	{
+		if (i == 0 || AgentCells[SortedAgents[i]] != AgentCells[SortedAgents[i - 1]])
+		{
+			CellStarts.Add(AgentCells[SortedAgents[i]], i);
+		}
+	}
+}
+
+void AAvoidanceSolver::SolveAgent(int32 Index)
+{
+	const float DesiredVX = DesiredX[Index];
+	const float DesiredVY = DesiredY[Index];
+	ResultX[Index] = DesiredVX;
+	ResultY[Index] = DesiredVY;
+
+	const float DesiredSpeed = FMath::Sqrt(DesiredVX * DesiredVX + DesiredVY * DesiredVY);
+	const float Consideration = ConsiderationRadius[Index];
+	if (DesiredSpeed < KINDA_SMALL_NUMBER || Consideration <= 0.f)
+	{
+		return;
+	}
+
+	// Neighbours we care about, as flat arrays relative to us
+	TArray<float, TInlineAllocator<32>> RelX, RelY, OtherVX, OtherVY, CombinedRadiusSq, DistanceSq;
+	const float X = PositionX[Index];
+	const float Y = PositionY[Index];
+	const int32 CellX = FMath::FloorToInt(X / CellSize);
+	const int32 CellY = FMath::FloorToInt(Y / CellSize);
+	for (int32 DX = -1; DX <= 1; DX++)
+	{
+		for (int32 DY = -1; DY <= 1; DY++)
+		{
+			const uint64 Cell = GetCellKey(CellX + DX, CellY + DY);
+			const int32* Start = CellStarts.Find(Cell);
+			if (nullptr == Start)
+			{
+				continue;
+			}
+
+			for (int32 s = *Start; s < SortedAgents.Num() && AgentCells[SortedAgents[s]] == Cell; s++)
+			{
+				const int32 Other = SortedAgents[s];
+				if (Other == Index ||
+					0 == (GroupMask[Other] & GroupsToAvoid[Index]) ||
+					0 != (GroupMask[Other] & GroupsToIgnore[Index]))
+				{
+					continue;
+				}
+
+				const float RX = PositionX[Other] - X;
+				const float RY = PositionY[Other] - Y;
+				const float DistSq = RX * RX + RY * RY;
+				if (DistSq > Consideration * Consideration)
+				{
+					continue;
+				}
+
+				RelX.Add(RX);
+				RelY.Add(RY);
+				OtherVX.Add(VelocityX[Other]);
+				OtherVY.Add(VelocityY[Other]);
+				CombinedRadiusSq.Add(FMath::Square(Radius[Index] + Radius[Other]));
+				DistanceSq.Add(DistSq);
+			}
+		}
+	}
+
+	// Drop all but the closest
+	while (RelX.Num() > MaxNeighbours)
+	{
+		int32 Furthest = 0;
+		for (int32 n = 1; n < DistanceSq.Num(); n++)
+		{
+			if (DistanceSq[n] > DistanceSq[Furthest])
+			{
+				Furthest = n;
+			}
+		}
+		RelX.RemoveAtSwap(Furthest, 1, false);
+		RelY.RemoveAtSwap(Furthest, 1, false);
+		OtherVX.RemoveAtSwap(Furthest, 1, false);
+		OtherVY.RemoveAtSwap(Furthest, 1, false);
+		CombinedRadiusSq.RemoveAtSwap(Furthest, 1, false);
+		DistanceSq.RemoveAtSwap(Furthest, 1, false);
+	}
+
+	const int32 NumNeighbours = RelX.Num();
+	if (NumNeighbours == 0)
+	{
+		return;
+	}
+
+	const float OwnVX = VelocityX[Index];
+	const float OwnVY = VelocityY[Index];
+	const float DirX = DesiredVX / DesiredSpeed;
+	const float DirY = DesiredVY / DesiredSpeed;
+
+	// Try velocities around the desired one, and keep whichever collides latest for the least deviation
+	float BestCost = BIG_NUMBER;
+	for (float SpeedScale : AvoidanceSampleSpeeds)
+	{
+		for (float Angle : AvoidanceSampleAngles)
+		{
+			float Sin, Cos;
+			FMath::SinCos(&Sin, &Cos, FMath::DegreesToRadians(Angle));
+			const float CandidateVX = (DirX * Cos - DirY * Sin) * DesiredSpeed * SpeedScale;
+			const float CandidateVY = (DirX * Sin + DirY * Cos) * DesiredSpeed * SpeedScale;
+
+			// Reciprocal: assume each side takes half the effort, so test 2 * candidate - own velocity
+			const float TestVX = 2.f * CandidateVX - OwnVX;
+			const float TestVY = 2.f * CandidateVY - OwnVY;
+
+			// Earliest time to collision with any neighbour. Branch-free over flat arrays so it vectorises
+			float EarliestCollision = TimeHorizon;
+			for (int32 n = 0; n < NumNeighbours; n++)
+			{
+				const float WX = TestVX - OtherVX[n];
+				const float WY = TestVY - OtherVY[n];
+				const float A = WX * WX + WY * WY + KINDA_SMALL_NUMBER;
+				const float B = RelX[n] * WX + RelY[n] * WY;
+				const float C = DistanceSq[n] - CombinedRadiusSq[n];
+				const float Discriminant = B * B - A * C;
+				const float T = (B - FMath::Sqrt(FMath::Max(Discriminant, 0.f))) / A;
+
+				// Already overlapping counts as colliding now, unless moving apart
+				const bool bHits = (C < 0.f) ? (B > 0.f) : (Discriminant > 0.f && B > 0.f && T < TimeHorizon);
+				const float HitTime = (C < 0.f) ? 0.f : T;
+				EarliestCollision = bHits ? FMath::Min(EarliestCollision, HitTime) : EarliestCollision;
+			}
+
+			const float DeviationX = CandidateVX - DesiredVX;
+			const float DeviationY = CandidateVY - DesiredVY;
+			const float Cost = (TimeHorizon - EarliestCollision) / TimeHorizon * 4.f + FMath::Sqrt(DeviationX * DeviationX + DeviationY * DeviationY) / DesiredSpeed;
+			if (Cost < BestCost)
+			{
+				BestCost = Cost;
+				ResultX[Index] = CandidateVX;
+				ResultY[Index] = CandidateVY;
+			}
+		}
+
+		// Nothing in the way at this speed, no need to slow down
+		if (BestCost < 1.f)
+		{
+			break;
+		}
+	}
+}
+
+bool AAvoidanceSolver::GetAvoidanceVelocity(const UPPCharacterMovementComponent* Agent, const FVector& DesiredVelocity, FVector& OutVelocity) const
+{
+	const int32 Index = Agent->AvoidanceSolverIndex;
+	if (!ResultX.IsValidIndex(Index) || Agents[Index].Get() != Agent)
+	{
+		return false;
+	}
+
+	// Solved for a different heading, the result doesn't apply any more
+	const FVector2D SolvedFor(DesiredX[Index], DesiredY[Index]);
+	const FVector2D Desired(DesiredVelocity);
+	const float DesiredSpeed = Desired.Size();
+	const float SolvedSpeed = SolvedFor.Size();
+	if (DesiredSpeed < KINDA_SMALL_NUMBER || SolvedSpeed < KINDA_SMALL_NUMBER ||
+		FVector2D::DotProduct(SolvedFor / SolvedSpeed, Desired / DesiredSpeed) < 0.9f)
+	{
+		return false;
+	}
+
+	// Keep the solved direction and slowdown, at the speed asked for now
+	const float Scale = DesiredSpeed / SolvedSpeed;
+	OutVelocity = FVector(ResultX[Index] * Scale, ResultY[Index] * Scale, DesiredVelocity.Z);
+	return true;
+}
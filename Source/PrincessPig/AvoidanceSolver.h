@@ -0,0 +1,97 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "AvoidanceSolver.generated.h"
+
+class UPPCharacterMovementComponent;
+
+/**
+ * Server-side RVO avoidance for every AI character at once.
+ *
+ * The stock avoidance manager works out each agent's velocity separately when it moves.
+ * Instead, once per frame after movement this gathers the position, velocity, radius and
+ * group masks of every registered agent into flat arrays, finds neighbours with a grid, and
+ * solves all agents together (across threads when there are enough of them). The next frame,
+ * each agent's movement component picks up its result in CalcAvoidanceVelocity.
+ *
+ * Agents avoid each other following the same group rules as the stock manager: another agent
+ * is avoided if it is in one of our GroupsToAvoid and none of our GroupsToIgnore.
+ *
+ * Settings can be changed in DefaultGame.ini under [/Script/PrincessPig.AvoidanceSolver].
+ */
+UCLASS(NotPlaceable, Transient, Config = Game)
+class PRINCESSPIG_API AAvoidanceSolver : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AAvoidanceSolver();
+
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Find or spawn the solver for this world. Returns null on clients, or if bEnabled is off */
+	static AAvoidanceSolver* GetAvoidanceSolver(const UObject* WorldContextObject);
+
+	/** Find the solver without spawning one */
+	static AAvoidanceSolver* FindAvoidanceSolver(const UObject* WorldContextObject);
+
+	/** Use this instead of the stock avoidance manager */
+	UPROPERTY(Config, EditAnywhere, Category = "Avoidance")
+	bool bEnabled;
+
+	/** Seconds ahead to look for collisions */
+	UPROPERTY(Config, EditAnywhere, Category = "Avoidance")
+	float TimeHorizon;
+
+	/** Closest neighbours considered per agent */
+	UPROPERTY(Config, EditAnywhere, Category = "Avoidance")
+	int32 MaxNeighbours;
+
+	/** Solve on worker threads once there are at least this many agents */
+	UPROPERTY(Config, EditAnywhere, Category = "Avoidance")
+	int32 MinAgentsForParallel;
+
+	void RegisterAgent(UPPCharacterMovementComponent* Agent);
+	void UnregisterAgent(UPPCharacterMovementComponent* Agent);
+
+	/**
+	 * Avoiding velocity for Agent, solved last frame, if it was solved for a velocity close to
+	 * DesiredVelocity. Returns false if there is no usable result.
+	 */
+	bool GetAvoidanceVelocity(const UPPCharacterMovementComponent* Agent, const FVector& DesiredVelocity, FVector& OutVelocity) const;
+
+protected:
+	TArray<TWeakObjectPtr<UPPCharacterMovementComponent>> Agents;
+
+	/** Agent state, one entry per agent in Agents order */
+	TArray<float> PositionX;
+	TArray<float> PositionY;
+	TArray<float> VelocityX;
+	TArray<float> VelocityY;
+	TArray<float> DesiredX;
+	TArray<float> DesiredY;
+	TArray<float> Radius;
+	TArray<float> ConsiderationRadius;
+	TArray<int32> GroupMask;
+	TArray<int32> GroupsToAvoid;
+	TArray<int32> GroupsToIgnore;
+
+	/** Solver output */
+	TArray<float> ResultX;
+	TArray<float> ResultY;
+
+	/** Agent indices sorted by grid cell, and where each cell starts in that list */
+	TArray<int32> SortedAgents;
+	TArray<uint64> AgentCells;
+	TMap<uint64, int32> CellStarts;
+	float CellSize;
+
+	void Gather();
+	void BuildGrid();
+	void SolveAgent(int32 Index);
+
+	uint64 GetCellKey(int32 X, int32 Y) const { return ((uint64)(uint32)X << 32) | (uint32)Y; }
+};
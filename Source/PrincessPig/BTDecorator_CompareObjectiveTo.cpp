@@ -0,0 +1,54 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BTDecorator_CompareObjectiveTo.h"
+#include "GuardAIController.h"
+#include "BehaviorTree/BehaviorTreeComponent.h"
+
+UBTDecorator_CompareObjectiveTo::UBTDecorator_CompareObjectiveTo()
+{
+	NodeName = "Compare Objective To";
+	bNotifyBecomeRelevant = true;
+	bNotifyTick = true;
+
+	Comparison = EPPObjectiveComparison::IsEqualTo;
+	ObjectiveType = EObjectiveType::None;
+}
+
+bool UBTDecorator_CompareObjectiveTo::CalculateRawConditionValue(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) const
+{
+	AGuardAIController* GuardAI = Cast<AGuardAIController>(OwnerComp.GetAIOwner());
+	if (nullptr == GuardAI)
+	{
+		return false;
+	}
+
+	// No objective object yet counts as no objective
+	const uint8 Current = (uint8)(GuardAI->CurrentObjective ? GuardAI->CurrentObjective->Type : EObjectiveType::None);
+	const uint8 Other = (uint8)ObjectiveType;
+	switch (Comparison)
+	{
+	case EPPObjectiveComparison::IsLessThan:	return Current < Other;
+	case EPPObjectiveComparison::IsAtMost:		return Current <= Other;
+	case EPPObjectiveComparison::IsEqualTo:		return Current == Other;
+	case EPPObjectiveComparison::IsNotEqualTo:	return Current != Other;
+	case EPPObjectiveComparison::IsAtLeast:		return Current >= Other;
+	case EPPObjectiveComparison::IsGreaterThan:	return Current > Other;
+	}
+	return false;
+}
+
+void UBTDecorator_CompareObjectiveTo::OnBecomeRelevant(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	reinterpret_cast<FBTDecoratorCompareObjectiveToMemory*>(NodeMemory)->bLastResult = CalculateRawConditionValue(OwnerComp, NodeMemory);
+}
+
+void UBTDecorator_CompareObjectiveTo::TickNode(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory, float DeltaSeconds)
+{
+	FBTDecoratorCompareObjectiveToMemory* Memory = reinterpret_cast<FBTDecoratorCompareObjectiveToMemory*>(NodeMemory);
+	const bool bResult = CalculateRawConditionValue(OwnerComp, NodeMemory);
+	if (bResult != Memory->bLastResult)
+	{
+		Memory->bLastResult = bResult;
+		OwnerComp.RequestExecution(this);
+	}
+}
@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BehaviorTree/BTDecorator.h"
+#include "Objective.h"
+#include "BTDecorator_CompareObjectiveTo.generated.h"
+
+/** How the current objective type is compared. Types are ordered by urgency, None lowest and Chase highest */
+UENUM()
+enum class EPPObjectiveComparison : uint8
+{
+	IsLessThan,
+	IsAtMost,
+	IsEqualTo,
+	IsNotEqualTo,
+	IsAtLeast,
+	IsGreaterThan
+};
+
+struct FBTDecoratorCompareObjectiveToMemory
+{
+	bool bLastResult;
+};
+
+/**
+ * Compare the guard's current objective type to ObjectiveType. Checked again every tick while
+ * relevant, so the tree can abort as soon as the objective changes.
+ */
+UCLASS()
+class PRINCESSPIG_API UBTDecorator_CompareObjectiveTo : public UBTDecorator
+{
+	GENERATED_BODY()
+
+	UBTDecorator_CompareObjectiveTo();
+
+	virtual bool CalculateRawConditionValue(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) const override;
+
+	virtual void OnBecomeRelevant(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+
+	virtual void TickNode(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory, float DeltaSeconds) override;
+
+	virtual uint16 GetInstanceMemorySize() const override { return sizeof(FBTDecoratorCompareObjectiveToMemory); }
+
+public:
+	UPROPERTY(EditAnywhere, Category = "Objective")
+	EPPObjectiveComparison Comparison;
+
+	UPROPERTY(EditAnywhere, Category = "Objective")
+	EObjectiveType ObjectiveType;
+};
@@ -0,0 +1,22 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BTDecorator_HasPatrol.h"
+#include "PrincessPigCharacter.h"
+#include "PatrolRoute.h"
+#include "AIController.h"
+
+UBTDecorator_HasPatrol::UBTDecorator_HasPatrol()
+{
+	NodeName = "Has Patrol";
+}
+
+bool UBTDecorator_HasPatrol::CalculateRawConditionValue(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) const
+{
+	AAIController* AIController = OwnerComp.GetAIOwner();
+	APrincessPigCharacter* PPCharacter = AIController ? Cast<APrincessPigCharacter>(AIController->GetPawn()) : nullptr;
+	if (PPCharacter && PPCharacter->PatrolRoute)
+	{
+		return PPCharacter->PatrolRoute->PatrolPoints.Num() > 0;
+	}
+	return false;
+}
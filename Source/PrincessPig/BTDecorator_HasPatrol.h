@@ -0,0 +1,20 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BehaviorTree/BTDecorator.h"
+#include "BTDecorator_HasPatrol.generated.h"
+
+/**
+ * Does the pawn have a patrol route with at least one patrol point?
+ */
+UCLASS()
+class PRINCESSPIG_API UBTDecorator_HasPatrol : public UBTDecorator
+{
+	GENERATED_BODY()
+
+	UBTDecorator_HasPatrol();
+
+	virtual bool CalculateRawConditionValue(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) const override;
+};
@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BTDecorator_IsPreoccupied.h"
+#include "PrincessPigCharacter.h"
+#include "AIController.h"
+#include "BehaviorTree/BehaviorTreeComponent.h"
+
+UBTDecorator_IsPreoccupied::UBTDecorator_IsPreoccupied()
+{
+	NodeName = "Is Preoccupied";
+	bNotifyBecomeRelevant = true;
+	bNotifyTick = true;
+}
+
+bool UBTDecorator_IsPreoccupied::CalculateRawConditionValue(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) const
+{
+	AAIController* AIController = OwnerComp.GetAIOwner();
+	APrincessPigCharacter* PPCharacter = AIController ? Cast<APrincessPigCharacter>(AIController->GetPawn()) : nullptr;
+	if (PPCharacter)
+	{
+		return PPCharacter->IsSubdued() || PPCharacter->IsOffBalance() || PPCharacter->IsDistracted();
+	}
+	return false;
+}
+
+void UBTDecorator_IsPreoccupied::OnBecomeRelevant(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	reinterpret_cast<FBTDecoratorIsPreoccupiedMemory*>(NodeMemory)->bLastResult = CalculateRawConditionValue(OwnerComp, NodeMemory);
+}
+
+void UBTDecorator_IsPreoccupied::TickNode(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory, float DeltaSeconds)
+{
+	FBTDecoratorIsPreoccupiedMemory* Memory = reinterpret_cast<FBTDecoratorIsPreoccupiedMemory*>(NodeMemory);
+	const bool bResult = CalculateRawConditionValue(OwnerComp, NodeMemory);
+	if (bResult != Memory->bLastResult)
+	{
+		Memory->bLastResult = bResult;
+		OwnerComp.RequestExecution(this);
+	}
+}
@@ -0,0 +1,32 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BehaviorTree/BTDecorator.h"
+#include "BTDecorator_IsPreoccupied.generated.h"
+
+struct FBTDecoratorIsPreoccupiedMemory
+{
+	bool bLastResult;
+};
+
+/**
+ * Is the pawn subdued, off balance or distracted? Checked again every tick while relevant,
+ * so the tree can abort as soon as it changes.
+ */
+UCLASS()
+class PRINCESSPIG_API UBTDecorator_IsPreoccupied : public UBTDecorator
+{
+	GENERATED_BODY()
+
+	UBTDecorator_IsPreoccupied();
+
+	virtual bool CalculateRawConditionValue(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) const override;
+
+	virtual void OnBecomeRelevant(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+
+	virtual void TickNode(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory, float DeltaSeconds) override;
+
+	virtual uint16 GetInstanceMemorySize() const override { return sizeof(FBTDecoratorIsPreoccupiedMemory); }
+};
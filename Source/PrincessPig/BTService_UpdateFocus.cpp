@@ -2,6 +2,7 @@
 
 #include "BTService_UpdateFocus.h"
 #include "GuardAIController.h"
+#include "SmokeGrid.h"
 #include "AIController.h"
 #include "BehaviorTree/BlackboardComponent.h"
 
@@ -29,7 +30,10 @@ void UBTService_UpdateFocus::TickNode(UBehaviorTreeComponent & OwnerComp, uint8
 	if (TargetActor)
 	{
 		// Set focus if we have line of sight, or if we don't need it
-		if (!bRequireLineOfSight || OwnerAIController->LineOfSightTo(TargetActor))
+		// Smoke is checked first since it is much cheaper than the trace
+		if (!bRequireLineOfSight || 
+			(!ASmokeGrid::IsSightBlockedBySmoke(OwnerAIController, OwnerPawn->GetPawnViewLocation(), TargetActor->GetActorLocation()) && 
+			OwnerAIController->LineOfSightTo(TargetActor)))
 		{
 			if (MaxFocusDistance == 0.0 || FVector::Distance(TargetActor->GetActorLocation(), OwnerPawn->GetActorLocation()) < MaxFocusDistance)
 			{
@@ -0,0 +1,59 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BTT_BeDistracted.h"
+#include "GuardAIController.h"
+#include "PrincessPigCharacter.h"
+
+UBTT_BeDistracted::UBTT_BeDistracted()
+{
+	NodeName = "Be Distracted";
+	bNotifyTick = true;
+
+	DistractedDuration = 3.f;
+}
+
+EBTNodeResult::Type UBTT_BeDistracted::ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	FBTBeDistractedMemory* Memory = reinterpret_cast<FBTBeDistractedMemory*>(NodeMemory);
+	AGuardAIController* GuardAI = Cast<AGuardAIController>(OwnerComp.GetAIOwner());
+	APrincessPigCharacter* PPCharacter = GuardAI ? Cast<APrincessPigCharacter>(GuardAI->GetPawn()) : nullptr;
+	if (nullptr == PPCharacter)
+	{
+		return EBTNodeResult::Failed;
+	}
+
+	if (GuardAI->CurrentObjective && GuardAI->CurrentObjective->TargetActor)
+	{
+		GuardAI->SetFocus(GuardAI->CurrentObjective->TargetActor, EAIFocusPriority::Gameplay);
+	}
+
+	PPCharacter->Server_SetDistractedFor(DistractedDuration);
+	Memory->TimeRemaining = DistractedDuration;
+	return EBTNodeResult::InProgress;
+}
+
+void UBTT_BeDistracted::TickTask(UBehaviorTreeComponent & OwnerComp, uint8 * NodeMemory, float DeltaSeconds)
+{
+	FBTBeDistractedMemory* Memory = reinterpret_cast<FBTBeDistractedMemory*>(NodeMemory);
+	Memory->TimeRemaining -= DeltaSeconds;
+	if (Memory->TimeRemaining <= 0.f)
+	{
+		OwnerComp.GetAIOwner()->ClearFocus(EAIFocusPriority::Gameplay);
+		FinishLatentTask(OwnerComp, EBTNodeResult::Succeeded);
+	}
+}
+
+EBTNodeResult::Type UBTT_BeDistracted::AbortTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	AAIController* AIController = OwnerComp.GetAIOwner();
+	AIController->ClearFocus(EAIFocusPriority::Gameplay);
+
+	// Snap out of it if something more important came up
+	APrincessPigCharacter* PPCharacter = Cast<APrincessPigCharacter>(AIController->GetPawn());
+	if (PPCharacter && PPCharacter->IsDistracted())
+	{
+		PPCharacter->Server_SetDistractedDirectly(false);
+	}
+
+	return EBTNodeResult::Aborted;
+}
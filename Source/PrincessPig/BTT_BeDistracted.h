@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BehaviorTree/BTTaskNode.h"
+#include "BTT_BeDistracted.generated.h"
+
+struct FBTBeDistractedMemory
+{
+	float TimeRemaining;
+};
+
+/**
+ * Stare at the objective's distraction for DistractedDuration seconds, distracted the whole time
+ */
+UCLASS()
+class PRINCESSPIG_API UBTT_BeDistracted : public UBTTaskNode
+{
+	GENERATED_BODY()
+
+	UBTT_BeDistracted();
+
+	virtual EBTNodeResult::Type ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+
+	virtual EBTNodeResult::Type AbortTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+
+	virtual void TickTask(UBehaviorTreeComponent & OwnerComp, uint8 * NodeMemory, float DeltaSeconds) override;
+
+	virtual uint16 GetInstanceMemorySize() const override { return sizeof(FBTBeDistractedMemory); }
+
+public:
+	UPROPERTY(EditAnywhere, Category = "Distracted")
+	float DistractedDuration;
+};
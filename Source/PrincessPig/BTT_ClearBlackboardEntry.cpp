@@ -0,0 +1,20 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BTT_ClearBlackboardEntry.h"
+#include "BehaviorTree/BlackboardComponent.h"
+
+UBTT_ClearBlackboardEntry::UBTT_ClearBlackboardEntry()
+{
+	NodeName = "Clear Blackboard Entry";
+}
+
+EBTNodeResult::Type UBTT_ClearBlackboardEntry::ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	UBlackboardComponent* BlackboardComp = OwnerComp.GetBlackboardComponent();
+	if (BlackboardComp)
+	{
+		BlackboardComp->ClearValue(GetSelectedBlackboardKey());
+		return EBTNodeResult::Succeeded;
+	}
+	return EBTNodeResult::Failed;
+}
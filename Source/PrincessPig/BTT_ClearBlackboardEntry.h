@@ -0,0 +1,20 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BehaviorTree/Tasks/BTTask_BlackboardBase.h"
+#include "BTT_ClearBlackboardEntry.generated.h"
+
+/**
+ * Clear the value of BlackboardKey
+ */
+UCLASS()
+class PRINCESSPIG_API UBTT_ClearBlackboardEntry : public UBTTask_BlackboardBase
+{
+	GENERATED_BODY()
+
+	UBTT_ClearBlackboardEntry();
+
+	virtual EBTNodeResult::Type ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+};
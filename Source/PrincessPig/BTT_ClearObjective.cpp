@@ -0,0 +1,20 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BTT_ClearObjective.h"
+#include "GuardAIController.h"
+
+UBTT_ClearObjective::UBTT_ClearObjective()
+{
+	NodeName = "Clear Objective";
+}
+
+EBTNodeResult::Type UBTT_ClearObjective::ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	AGuardAIController* GuardAI = Cast<AGuardAIController>(OwnerComp.GetAIOwner());
+	if (GuardAI)
+	{
+		GuardAI->ClearObjective();
+		return EBTNodeResult::Succeeded;
+	}
+	return EBTNodeResult::Failed;
+}
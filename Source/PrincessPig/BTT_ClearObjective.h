@@ -0,0 +1,20 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BehaviorTree/BTTaskNode.h"
+#include "BTT_ClearObjective.generated.h"
+
+/**
+ * Drop the guard's current objective
+ */
+UCLASS()
+class PRINCESSPIG_API UBTT_ClearObjective : public UBTTaskNode
+{
+	GENERATED_BODY()
+
+	UBTT_ClearObjective();
+
+	virtual EBTNodeResult::Type ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+};
@@ -0,0 +1,156 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BTT_FollowLeaderTrail.h"
+#include "PrincessPig.h"
+#include "PrincessPigCharacter.h"
+#include "LeaderTrailComponent.h"
+#include "FormationComponent.h"
+#include "NavQueryService.h"
+#include "AIController.h"
+#include "Navigation/PathFollowingComponent.h"
+#include "BehaviorTree/BlackboardComponent.h"
+#include "Engine/World.h"
+#include "NavigationSystem.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Follower Path Queries"), STAT_PPFollowerPathQueries, STATGROUP_PrincessPig);
+DECLARE_CYCLE_STAT(TEXT("Follow Leader Trail"), STAT_PPFollowLeaderTrail, STATGROUP_PrincessPig);
+
+UBTT_FollowLeaderTrail::UBTT_FollowLeaderTrail()
+{
+	NodeName = "Follow Leader Trail";
+	bNotifyTick = true;
+
+	LeaderKey.AddObjectFilter(this, TEXT("LeaderKey"), APrincessPigCharacter::StaticClass());
+	LeaderKey.SelectedKeyName = "FollowTarget";
+
+	FirstSlotDistance = 150.f;
+	SlotSpacing = 100.f;
+	AcceptanceRadius = 40.f;
+	SlowdownDistance = 150.f;
+	LookAheadDistance = 150.f;
+	OffTrailDistance = 300.f;
+	PathQueryInterval = 1.f;
+}
+
+EBTNodeResult::Type UBTT_FollowLeaderTrail::ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	FBTFollowLeaderTrailMemory* Memory = reinterpret_cast<FBTFollowLeaderTrailMemory*>(NodeMemory);
+	Memory->LastPathQueryTime = -BIG_NUMBER;
+	Memory->NavQueryService = ANavQueryService::GetNavQueryService(OwnerComp.GetAIOwner());
+
+	APrincessPigCharacter* Leader = Cast<APrincessPigCharacter>(OwnerComp.GetBlackboardComponent()->GetValueAsObject(LeaderKey.SelectedKeyName));
+	if (Leader && Leader->LeaderTrail && OwnerComp.GetAIOwner() && OwnerComp.GetAIOwner()->GetPawn())
+	{
+		return EBTNodeResult::InProgress;
+	}
+	return EBTNodeResult::Failed;
+}
+
+void UBTT_FollowLeaderTrail::TickTask(UBehaviorTreeComponent & OwnerComp, uint8 * NodeMemory, float DeltaSeconds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PPFollowLeaderTrail);
+
+	FBTFollowLeaderTrailMemory* Memory = reinterpret_cast<FBTFollowLeaderTrailMemory*>(NodeMemory);
+	AAIController* AIController = OwnerComp.GetAIOwner();
+	APrincessPigCharacter* Follower = AIController ? Cast<APrincessPigCharacter>(AIController->GetPawn()) : nullptr;
+	APrincessPigCharacter* Leader = Cast<APrincessPigCharacter>(OwnerComp.GetBlackboardComponent()->GetValueAsObject(LeaderKey.SelectedKeyName));
+
+	// No longer following this leader
+	if (nullptr == Follower || nullptr == Leader || Follower->Leader != Leader)
+	{
+		if (AIController)
+		{
+			if (ANavQueryService* NavQueries = Memory->NavQueryService.Get())
+			{
+				NavQueries->CancelMove(AIController);
+			}
+			AIController->StopMovement();
+		}
+		FinishLatentTask(OwnerComp, EBTNodeResult::Succeeded);
+		return;
+	}
+
+	ULeaderTrailComponent* Trail = Leader->LeaderTrail;
+	const FVector FollowerLocation = Follower->GetActorLocation();
+
+	// Take our slot in the leader's formation, or failing that queue up along the trail in the order we joined
+	FVector SlotLocation;
+	if (nullptr == Leader->Formation || !Leader->Formation->GetSlotLocation(Follower, SlotLocation))
+	{
+		const int32 Slot = FMath::Max(Leader->Followers.Find(Follower), 0);
+		Trail->GetPointBehind(FirstSlotDistance + Slot * SlotSpacing, SlotLocation);
+	}
+
+	// Lost the trail: pathfind back to it, but not every tick
+	FVector ClosestCrumb = SlotLocation;
+	const float OffTrailDistanceSquared = FMath::Square(OffTrailDistance);
+	if (FVector::DistSquared(FollowerLocation, SlotLocation) > OffTrailDistanceSquared &&
+		Trail->GetDistanceSquaredToTrail(FollowerLocation, ClosestCrumb) > OffTrailDistanceSquared)
+	{
+		const float Now = Follower->GetWorld()->GetTimeSeconds();
+		if (Now - Memory->LastPathQueryTime > PathQueryInterval)
+		{
+			Memory->LastPathQueryTime = Now;
+			if (ANavQueryService* NavQueries = Memory->NavQueryService.Get())
+			{
+				NavQueries->RequestMove(AIController, ClosestCrumb, AcceptanceRadius);
+			}
+			else
+			{
+				AIController->MoveToLocation(ClosestCrumb, AcceptanceRadius);
+			}
+			INC_DWORD_STAT(STAT_PPFollowerPathQueries);
+		}
+		return;
+	}
+
+	// Back on the trail, hand over from path following to steering
+	ANavQueryService* NavQueries = Memory->NavQueryService.Get();
+	if (NavQueries && NavQueries->HasPendingMove(AIController))
+	{
+		NavQueries->CancelMove(AIController);
+	}
+	if (AIController->GetMoveStatus() != EPathFollowingStatus::Idle)
+	{
+		AIController->StopMovement();
+	}
+
+	const float DistanceToSlot = FVector::Dist2D(SlotLocation, FollowerLocation);
+	if (DistanceToSlot <= AcceptanceRadius)
+	{
+		return;
+	}
+
+	// Head straight for the slot only if we can walk there in a line. Otherwise keep to the trail
+	FVector SteerLocation = SlotLocation;
+	FVector HitLocation;
+	if (UNavigationSystemV1::NavigationRaycast(Follower, FollowerLocation, SlotLocation, HitLocation))
+	{
+		const int32 FollowerCrumb = Trail->FindClosestCrumb(FollowerLocation);
+		const int32 SlotCrumb = Trail->FindClosestCrumb(SlotLocation);
+		if (FollowerCrumb != INDEX_NONE && SlotCrumb != INDEX_NONE)
+		{
+			SteerLocation = Trail->GetPointAlongTrail(FollowerCrumb, SlotCrumb, LookAheadDistance);
+		}
+	}
+
+	FVector ToSteer = SteerLocation - FollowerLocation;
+	ToSteer.Z = 0.f;
+	if (!ToSteer.IsNearlyZero())
+	{
+		const float Speed = FMath::Clamp((DistanceToSlot - AcceptanceRadius) / FMath::Max(SlowdownDistance, 1.f), 0.2f, 1.f);
+		Follower->AddMovementInput(ToSteer.GetSafeNormal(), Speed);
+	}
+}
+
+EBTNodeResult::Type UBTT_FollowLeaderTrail::AbortTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	FBTFollowLeaderTrailMemory* Memory = reinterpret_cast<FBTFollowLeaderTrailMemory*>(NodeMemory);
+	if (ANavQueryService* NavQueries = Memory->NavQueryService.Get())
+	{
+		NavQueries->CancelMove(OwnerComp.GetAIOwner());
+	}
+	OwnerComp.GetAIOwner()->StopMovement();
+
+	return EBTNodeResult::Aborted;
+}
@@ -0,0 +1,72 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BehaviorTree/BTTaskNode.h"
+#include "BTT_FollowLeaderTrail.generated.h"
+
+class ANavQueryService;
+
+struct FBTFollowLeaderTrailMemory
+{
+	float LastPathQueryTime;
+
+	/** Paths back to the trail are found through this when there is one */
+	TWeakObjectPtr<ANavQueryService> NavQueryService;
+};
+
+/**
+ * Follow the leader in LeaderKey to our slot in its formation, which is laid out along its
+ * breadcrumb trail. Without a formation, queue up along the trail one slot further back for each
+ * follower ahead of us. Steers straight at the slot when nothing is in the way, and otherwise
+ * along the trail a little ahead of us towards it, so corners are walked round rather than into.
+ * Only pathfinds when too far from the trail to steer back onto it. Runs until the leader
+ * changes or goes away.
+ */
+UCLASS()
+class PRINCESSPIG_API UBTT_FollowLeaderTrail : public UBTTaskNode
+{
+	GENERATED_BODY()
+
+	UBTT_FollowLeaderTrail();
+
+	virtual EBTNodeResult::Type ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+
+	virtual EBTNodeResult::Type AbortTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+
+	virtual void TickTask(UBehaviorTreeComponent & OwnerComp, uint8 * NodeMemory, float DeltaSeconds) override;
+
+	virtual uint16 GetInstanceMemorySize() const override { return sizeof(FBTFollowLeaderTrailMemory); }
+
+public:
+	UPROPERTY(EditAnywhere, Category = "Follow")
+	FBlackboardKeySelector LeaderKey;
+
+	/** Distance along the trail from the leader to the first follower, if the leader has no formation */
+	UPROPERTY(EditAnywhere, Category = "Follow")
+	float FirstSlotDistance;
+
+	/** Distance along the trail between followers */
+	UPROPERTY(EditAnywhere, Category = "Follow")
+	float SlotSpacing;
+
+	UPROPERTY(EditAnywhere, Category = "Follow")
+	float AcceptanceRadius;
+
+	/** Start slowing down this far from the slot */
+	UPROPERTY(EditAnywhere, Category = "Follow")
+	float SlowdownDistance;
+
+	/** How far ahead along the trail to steer when the slot is round a corner */
+	UPROPERTY(EditAnywhere, Category = "Follow")
+	float LookAheadDistance;
+
+	/** Further than this from both the trail and the slot, pathfind back to the trail */
+	UPROPERTY(EditAnywhere, Category = "Follow")
+	float OffTrailDistance;
+
+	/** Seconds between path queries while off the trail */
+	UPROPERTY(EditAnywhere, Category = "Follow")
+	float PathQueryInterval;
+};
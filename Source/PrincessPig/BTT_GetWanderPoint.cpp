@@ -0,0 +1,128 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BTT_GetWanderPoint.h"
+#include "PrincessPig.h"
+#include "WanderPointCache.h"
+#include "DangerMap.h"
+#include "AIController.h"
+#include "GameFramework/Pawn.h"
+#include "BehaviorTree/BlackboardComponent.h"
+#include "NavigationSystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Get Wander Point"), STAT_PPGetWanderPoint, STATGROUP_PrincessPig);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Wander Point Nav Queries"), STAT_PPWanderPointNavQueries, STATGROUP_PrincessPig);
+
+UBTT_GetWanderPoint::UBTT_GetWanderPoint()
+{
+	NodeName = "Get Wander Point";
+
+	LocationKey.AddVectorFilter(this, TEXT("LocationKey"));
+	LocationKey.SelectedKeyName = "LocationToGo";
+
+	WanderRadius = 1000.f;
+	MinWanderDistance = 200.f;
+	MaxCandidates = 8;
+	RecentRegionSize = 400.f;
+	AcceptableDanger = 0.f;
+}
+
+void UBTT_GetWanderPoint::InitializeMemory(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory, EBTMemoryInit::Type InitType) const
+{
+	FBTGetWanderPointMemory* Memory = reinterpret_cast<FBTGetWanderPointMemory*>(NodeMemory);
+	for (FIntPoint& Region : Memory->RecentRegions)
+	{
+		Region = FIntPoint(MAX_int32, MAX_int32);
+	}
+	Memory->NextRecentRegion = 0;
+}
+
+EBTNodeResult::Type UBTT_GetWanderPoint::ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PPGetWanderPoint);
+
+	FBTGetWanderPointMemory* Memory = reinterpret_cast<FBTGetWanderPointMemory*>(NodeMemory);
+	AAIController* AIController = OwnerComp.GetAIOwner();
+	APawn* Pawn = AIController ? AIController->GetPawn() : nullptr;
+	UNavigationSystemV1* NavSys = UNavigationSystemV1::GetNavigationSystem(Pawn);
+	if (nullptr == Pawn || nullptr == NavSys)
+	{
+		return EBTNodeResult::Failed;
+	}
+
+	const FVector Origin = Pawn->GetNavAgentLocation();
+	AWanderPointCache* Cache = AWanderPointCache::GetWanderPointCache(Pawn);
+	ADangerMap* DangerMap = ADangerMap::FindDangerMap(Pawn);
+
+	// One query to find which island we are on, then candidates come from the cache
+	NavNodeRef OriginPoly = INVALID_NAVNODEREF;
+	const bool bUseCache = Cache && Cache->HasTriangles() && Cache->CanSampleRadius(WanderRadius);
+	if (bUseCache)
+	{
+		FNavLocation OriginNavLocation;
+		INC_DWORD_STAT(STAT_PPWanderPointNavQueries);
+		if (NavSys->ProjectPointToNavigation(Origin, OriginNavLocation))
+		{
+			OriginPoly = OriginNavLocation.NodeRef;
+		}
+	}
+
+	bool bFound = false;
+	FVector Best = FVector::ZeroVector;
+	float BestDanger = BIG_NUMBER;
+	for (int32 i = 0; i < MaxCandidates && BestDanger > AcceptableDanger; i++)
+	{
+		FVector Candidate;
+		if (bUseCache)
+		{
+			if (!Cache->SampleWanderPoint(Origin, WanderRadius, OriginPoly, Candidate))
+			{
+				continue;
+			}
+		}
+		else
+		{
+			FNavLocation NavLocation;
+			INC_DWORD_STAT(STAT_PPWanderPointNavQueries);
+			if (!NavSys->GetRandomReachablePointInRadius(Origin, WanderRadius, NavLocation))
+			{
+				continue;
+			}
+			Candidate = NavLocation.Location;
+		}
+
+		if (FVector::DistSquared2D(Candidate, Origin) < FMath::Square(MinWanderDistance))
+		{
+			continue;
+		}
+
+		const FIntPoint Region(FMath::FloorToInt(Candidate.X / RecentRegionSize), FMath::FloorToInt(Candidate.Y / RecentRegionSize));
+		bool bRecent = false;
+		for (const FIntPoint& RecentRegion : Memory->RecentRegions)
+		{
+			bRecent |= RecentRegion == Region;
+		}
+		if (bRecent)
+		{
+			continue;
+		}
+
+		const float Danger = DangerMap ? DangerMap->GetDanger(Candidate) : 0.f;
+		if (Danger < BestDanger)
+		{
+			BestDanger = Danger;
+			Best = Candidate;
+			bFound = true;
+		}
+	}
+
+	if (!bFound)
+	{
+		return EBTNodeResult::Failed;
+	}
+
+	Memory->RecentRegions[Memory->NextRecentRegion] = FIntPoint(FMath::FloorToInt(Best.X / RecentRegionSize), FMath::FloorToInt(Best.Y / RecentRegionSize));
+	Memory->NextRecentRegion = (Memory->NextRecentRegion + 1) % FBTGetWanderPointMemory::NumRecentRegions;
+
+	OwnerComp.GetBlackboardComponent()->SetValueAsVector(LocationKey.SelectedKeyName, Best);
+	return EBTNodeResult::Succeeded;
+}
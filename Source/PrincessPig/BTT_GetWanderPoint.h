@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BehaviorTree/BTTaskNode.h"
+#include "BTT_GetWanderPoint.generated.h"
+
+struct FBTGetWanderPointMemory
+{
+	enum { NumRecentRegions = 4 };
+
+	/** Regions we recently wandered to, oldest overwritten first */
+	FIntPoint RecentRegions[NumRecentRegions];
+	int32 NextRecentRegion;
+};
+
+/**
+ * Pick somewhere to wander to and write it to LocationKey.
+ *
+ * Points come from the wander point cache, so picking one is a few lookups rather than a
+ * navmesh query. Points in regions we wandered to recently are skipped, and if there is a
+ * danger map the least dangerous candidate is kept. Falls back to a navmesh query when there
+ * is no Recast navmesh to cache.
+ */
+UCLASS()
+class PRINCESSPIG_API UBTT_GetWanderPoint : public UBTTaskNode
+{
+	GENERATED_BODY()
+
+	UBTT_GetWanderPoint();
+
+	virtual EBTNodeResult::Type ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+
+	virtual void InitializeMemory(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory, EBTMemoryInit::Type InitType) const override;
+
+	virtual uint16 GetInstanceMemorySize() const override { return sizeof(FBTGetWanderPointMemory); }
+
+public:
+	UPROPERTY(EditAnywhere, Category = "Wander")
+	FBlackboardKeySelector LocationKey;
+
+	UPROPERTY(EditAnywhere, Category = "Wander")
+	float WanderRadius;
+
+	/** Candidates closer than this are too short a walk to bother with */
+	UPROPERTY(EditAnywhere, Category = "Wander")
+	float MinWanderDistance;
+
+	/** Candidates tried before settling for the best so far */
+	UPROPERTY(EditAnywhere, Category = "Wander")
+	int32 MaxCandidates;
+
+	/** Size of the regions remembered as recently visited */
+	UPROPERTY(EditAnywhere, Category = "Wander")
+	float RecentRegionSize;
+
+	/** Take the first candidate this safe or safer without trying the rest */
+	UPROPERTY(EditAnywhere, Category = "Wander", meta = (ClampMin = "0", ClampMax = "1"))
+	float AcceptableDanger;
+};
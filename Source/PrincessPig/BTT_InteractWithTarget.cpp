@@ -0,0 +1,28 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BTT_InteractWithTarget.h"
+#include "PrincessPigCharacter.h"
+#include "AIController.h"
+#include "BehaviorTree/BlackboardComponent.h"
+
+UBTT_InteractWithTarget::UBTT_InteractWithTarget()
+{
+	NodeName = "Interact With Target";
+
+	TargetKey.AddObjectFilter(this, TEXT("TargetKey"), AActor::StaticClass());
+	TargetKey.SelectedKeyName = "TargetActor";
+}
+
+EBTNodeResult::Type UBTT_InteractWithTarget::ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	AAIController* AIController = OwnerComp.GetAIOwner();
+	APrincessPigCharacter* PPCharacter = AIController ? Cast<APrincessPigCharacter>(AIController->GetPawn()) : nullptr;
+	AActor* Target = Cast<AActor>(OwnerComp.GetBlackboardComponent()->GetValueAsObject(TargetKey.SelectedKeyName));
+
+	if (PPCharacter && Target && PPCharacter->AvailableInteractions.Contains(Target))
+	{
+		PPCharacter->BPEvent_Interact(Target);
+		return EBTNodeResult::Succeeded;
+	}
+	return EBTNodeResult::Failed;
+}
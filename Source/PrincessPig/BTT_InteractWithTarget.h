@@ -0,0 +1,24 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BehaviorTree/BTTaskNode.h"
+#include "BTT_InteractWithTarget.generated.h"
+
+/**
+ * Interact with the actor in TargetKey, if it is one of our available interactions
+ */
+UCLASS()
+class PRINCESSPIG_API UBTT_InteractWithTarget : public UBTTaskNode
+{
+	GENERATED_BODY()
+
+	UBTT_InteractWithTarget();
+
+	virtual EBTNodeResult::Type ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+
+public:
+	UPROPERTY(EditAnywhere, Category = "Interaction")
+	FBlackboardKeySelector TargetKey;
+};
@@ -0,0 +1,96 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BTT_MoveToAsync.h"
+#include "PrincessPig.h"
+#include "NavQueryService.h"
+#include "AIController.h"
+#include "Navigation/PathFollowingComponent.h"
+#include "BehaviorTree/BlackboardComponent.h"
+#include "GameFramework/Pawn.h"
+
+DECLARE_CYCLE_STAT(TEXT("Move To Async"), STAT_PPMoveToAsync, STATGROUP_PrincessPig);
+
+UBTT_MoveToAsync::UBTT_MoveToAsync()
+{
+	NodeName = "Move To Async";
+	bNotifyTick = true;
+
+	LocationKey.AddVectorFilter(this, TEXT("LocationKey"));
+	LocationKey.SelectedKeyName = "ObjectiveLocation";
+
+	AcceptanceRadius = 50.f;
+	RepathDistance = 100.f;
+}
+
+EBTNodeResult::Type UBTT_MoveToAsync::ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	FBTMoveToAsyncMemory* Memory = reinterpret_cast<FBTMoveToAsyncMemory*>(NodeMemory);
+	AAIController* AIController = OwnerComp.GetAIOwner();
+	if (nullptr == AIController || nullptr == AIController->GetPawn())
+	{
+		return EBTNodeResult::Failed;
+	}
+
+	Memory->NavQueryService = ANavQueryService::GetNavQueryService(AIController);
+	RequestMove(AIController, Memory, OwnerComp.GetBlackboardComponent()->GetValueAsVector(LocationKey.SelectedKeyName));
+	return EBTNodeResult::InProgress;
+}
+
+void UBTT_MoveToAsync::TickTask(UBehaviorTreeComponent & OwnerComp, uint8 * NodeMemory, float DeltaSeconds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PPMoveToAsync);
+
+	FBTMoveToAsyncMemory* Memory = reinterpret_cast<FBTMoveToAsyncMemory*>(NodeMemory);
+	AAIController* AIController = OwnerComp.GetAIOwner();
+	APawn* Pawn = AIController ? AIController->GetPawn() : nullptr;
+	if (nullptr == Pawn)
+	{
+		FinishLatentTask(OwnerComp, EBTNodeResult::Failed);
+		return;
+	}
+
+	// Only repath when the goal has really moved
+	const FVector Goal = OwnerComp.GetBlackboardComponent()->GetValueAsVector(LocationKey.SelectedKeyName);
+	if (FVector::DistSquared(Goal, Memory->Goal) > FMath::Square(RepathDistance))
+	{
+		RequestMove(AIController, Memory, Goal);
+		return;
+	}
+
+	const ANavQueryService* NavQueries = Memory->NavQueryService.Get();
+	if (AIController->GetMoveStatus() != EPathFollowingStatus::Idle || (NavQueries && NavQueries->HasPendingMove(AIController)))
+	{
+		return;
+	}
+
+	// Stopped, either there or as far as the path went. Allow a radius more for goals off the navmesh
+	const float ReachDistance = AcceptanceRadius + 2.f * Pawn->GetSimpleCollisionRadius();
+	const bool bArrived = FVector::DistSquared2D(Pawn->GetNavAgentLocation(), Memory->Goal) <= FMath::Square(ReachDistance);
+	FinishLatentTask(OwnerComp, bArrived ? EBTNodeResult::Succeeded : EBTNodeResult::Failed);
+}
+
+EBTNodeResult::Type UBTT_MoveToAsync::AbortTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	FBTMoveToAsyncMemory* Memory = reinterpret_cast<FBTMoveToAsyncMemory*>(NodeMemory);
+	AAIController* AIController = OwnerComp.GetAIOwner();
+	if (ANavQueryService* NavQueries = Memory->NavQueryService.Get())
+	{
+		NavQueries->CancelMove(AIController);
+	}
+	AIController->StopMovement();
+
+	return EBTNodeResult::Aborted;
+}
+
+void UBTT_MoveToAsync::RequestMove(AAIController* AIController, FBTMoveToAsyncMemory* Memory, const FVector& Goal) const
+{
+	Memory->Goal = Goal;
+	if (ANavQueryService* NavQueries = Memory->NavQueryService.Get())
+	{
+		NavQueries->RequestMove(AIController, Goal, AcceptanceRadius);
+	}
+	else
+	{
+		AIController->MoveToLocation(Goal, AcceptanceRadius);
+	}
+}
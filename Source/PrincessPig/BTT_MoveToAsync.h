@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BehaviorTree/BTTaskNode.h"
+#include "BTT_MoveToAsync.generated.h"
+
+class ANavQueryService;
+
+struct FBTMoveToAsyncMemory
+{
+	/** Where we last asked to go */
+	FVector Goal;
+
+	TWeakObjectPtr<ANavQueryService> NavQueryService;
+};
+
+/**
+ * Move to the location in LocationKey, like the stock MoveTo, but with the path found
+ * asynchronously through ANavQueryService. Repaths when the location moves more than
+ * RepathDistance, rather than on every blackboard change. Succeeds on arrival, fails if the
+ * path runs out short of the goal. Without a service, paths are found on the spot.
+ */
+UCLASS()
+class PRINCESSPIG_API UBTT_MoveToAsync : public UBTTaskNode
+{
+	GENERATED_BODY()
+
+	UBTT_MoveToAsync();
+
+	virtual EBTNodeResult::Type ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+
+	virtual EBTNodeResult::Type AbortTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+
+	virtual void TickTask(UBehaviorTreeComponent & OwnerComp, uint8 * NodeMemory, float DeltaSeconds) override;
+
+	virtual uint16 GetInstanceMemorySize() const override { return sizeof(FBTMoveToAsyncMemory); }
+
+public:
+	UPROPERTY(EditAnywhere, Category = "AI")
+	FBlackboardKeySelector LocationKey;
+
+	UPROPERTY(EditAnywhere, Category = "AI")
+	float AcceptanceRadius;
+
+	UPROPERTY(EditAnywhere, Category = "AI")
+	float RepathDistance;
+
+protected:
+	void RequestMove(AAIController* AIController, FBTMoveToAsyncMemory* Memory, const FVector& Goal) const;
+};
@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BTT_ShoutForHelp.h"
+#include "GuardAIController.h"
+#include "PrincessPigCharacter.h"
+#include "Perception/AISense_Hearing.h"
+#include "Engine/World.h"
+
+UBTT_ShoutForHelp::UBTT_ShoutForHelp()
+{
+	NodeName = "Shout For Help";
+
+	MessageKey = "Help";
+	PaletteIndex = 0;
+	MessageDuration = 2.f;
+	Loudness = 1.f;
+	MaxRange = 0.f;
+	Cooldown = 5.f;
+}
+
+void UBTT_ShoutForHelp::InitializeMemory(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory, EBTMemoryInit::Type InitType) const
+{
+	reinterpret_cast<FBTShoutForHelpMemory*>(NodeMemory)->LastShoutTime = -BIG_NUMBER;
+}
+
+EBTNodeResult::Type UBTT_ShoutForHelp::ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	FBTShoutForHelpMemory* Memory = reinterpret_cast<FBTShoutForHelpMemory*>(NodeMemory);
+	AGuardAIController* GuardAI = Cast<AGuardAIController>(OwnerComp.GetAIOwner());
+	APrincessPigCharacter* PPCharacter = GuardAI ? Cast<APrincessPigCharacter>(GuardAI->GetPawn()) : nullptr;
+	if (nullptr == PPCharacter || nullptr == GuardAI->CurrentObjective || nullptr == GuardAI->CurrentObjective->TargetActor)
+	{
+		return EBTNodeResult::Failed;
+	}
+
+	const float Now = OwnerComp.GetWorld()->GetTimeSeconds();
+	if (Now - Memory->LastShoutTime < Cooldown)
+	{
+		return EBTNodeResult::Succeeded;
+	}
+	Memory->LastShoutTime = Now;
+
+	if (!MessageKey.IsNone())
+	{
+		PPCharacter->BroadcastOverheadMessageByKey(MessageKey, PaletteIndex, MessageDuration);
+	}
+
+	// Heard as the target itself, so listeners search for it rather than for us
+	UAISense_Hearing::ReportNoiseEvent(OwnerComp.GetWorld(), GuardAI->CurrentObjective->GetLastKnownLocation(), Loudness, GuardAI->CurrentObjective->TargetActor, MaxRange, "Help");
+
+	return EBTNodeResult::Succeeded;
+}
@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BehaviorTree/BTTaskNode.h"
+#include "BTT_ShoutForHelp.generated.h"
+
+struct FBTShoutForHelpMemory
+{
+	float LastShoutTime;
+};
+
+/**
+ * Shout a line from the guard's message table and make a noise where the objective target was
+ * last seen, so guards within earshot come and search for it. Won't shout again until Cooldown
+ * has passed, but still succeeds.
+ */
+UCLASS()
+class PRINCESSPIG_API UBTT_ShoutForHelp : public UBTTaskNode
+{
+	GENERATED_BODY()
+
+	UBTT_ShoutForHelp();
+
+	virtual EBTNodeResult::Type ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+
+	virtual void InitializeMemory(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory, EBTMemoryInit::Type InitType) const override;
+
+	virtual uint16 GetInstanceMemorySize() const override { return sizeof(FBTShoutForHelpMemory); }
+
+public:
+	/** Line in the guard's OverheadMessageTable. None for no message */
+	UPROPERTY(EditAnywhere, Category = "Shout")
+	FName MessageKey;
+
+	UPROPERTY(EditAnywhere, Category = "Shout")
+	uint8 PaletteIndex;
+
+	UPROPERTY(EditAnywhere, Category = "Shout")
+	float MessageDuration;
+
+	UPROPERTY(EditAnywhere, Category = "Shout")
+	float Loudness;
+
+	/** How far the shout carries. 0 leaves it to each listener's hearing range */
+	UPROPERTY(EditAnywhere, Category = "Shout")
+	float MaxRange;
+
+	UPROPERTY(EditAnywhere, Category = "Shout")
+	float Cooldown;
+};
@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "BTT_SubdueTarget.h"
+#include "PrincessPigCharacter.h"
+#include "AIController.h"
+#include "BehaviorTree/BlackboardComponent.h"
+
+UBTT_SubdueTarget::UBTT_SubdueTarget()
+{
+	NodeName = "Subdue Target";
+	bNotifyTick = true;
+
+	TargetKey.AddObjectFilter(this, TEXT("TargetKey"), APrincessPigCharacter::StaticClass());
+	TargetKey.SelectedKeyName = "TargetActor";
+
+	WindupTime = 0.25f;
+	RecoveryTime = 0.75f;
+}
+
+EBTNodeResult::Type UBTT_SubdueTarget::ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	FBTSubdueTargetMemory* Memory = reinterpret_cast<FBTSubdueTargetMemory*>(NodeMemory);
+	AAIController* AIController = OwnerComp.GetAIOwner();
+	APrincessPigCharacter* Target = Cast<APrincessPigCharacter>(OwnerComp.GetBlackboardComponent()->GetValueAsObject(TargetKey.SelectedKeyName));
+	if (nullptr == AIController || nullptr == AIController->GetPawn() || nullptr == Target || Target->IsSubdued() || Target->Replicated_IsDead)
+	{
+		return EBTNodeResult::Failed;
+	}
+
+	AIController->SetFocus(Target, EAIFocusPriority::Gameplay);
+	Memory->TimeRemaining = WindupTime;
+	Memory->bStruck = false;
+	return EBTNodeResult::InProgress;
+}
+
+void UBTT_SubdueTarget::TickTask(UBehaviorTreeComponent & OwnerComp, uint8 * NodeMemory, float DeltaSeconds)
+{
+	FBTSubdueTargetMemory* Memory = reinterpret_cast<FBTSubdueTargetMemory*>(NodeMemory);
+	Memory->TimeRemaining -= DeltaSeconds;
+	if (Memory->TimeRemaining > 0.f)
+	{
+		return;
+	}
+
+	AAIController* AIController = OwnerComp.GetAIOwner();
+	APrincessPigCharacter* PPCharacter = AIController ? Cast<APrincessPigCharacter>(AIController->GetPawn()) : nullptr;
+	if (Memory->bStruck || nullptr == PPCharacter)
+	{
+		if (AIController)
+		{
+			AIController->ClearFocus(EAIFocusPriority::Gameplay);
+		}
+		FinishLatentTask(OwnerComp, PPCharacter ? EBTNodeResult::Succeeded : EBTNodeResult::Failed);
+		return;
+	}
+
+	// Only swing at targets we can still reach, the server checks the actual hit
+	APrincessPigCharacter* Target = Cast<APrincessPigCharacter>(OwnerComp.GetBlackboardComponent()->GetValueAsObject(TargetKey.SelectedKeyName));
+	if (nullptr == Target || !PPCharacter->AvailableInteractions.Contains(Target))
+	{
+		AIController->ClearFocus(EAIFocusPriority::Gameplay);
+		FinishLatentTask(OwnerComp, EBTNodeResult::Failed);
+		return;
+	}
+
+	PPCharacter->Strike(Target);
+	Memory->bStruck = true;
+	Memory->TimeRemaining = RecoveryTime;
+}
+
+EBTNodeResult::Type UBTT_SubdueTarget::AbortTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory)
+{
+	OwnerComp.GetAIOwner()->ClearFocus(EAIFocusPriority::Gameplay);
+
+	return EBTNodeResult::Aborted;
+}
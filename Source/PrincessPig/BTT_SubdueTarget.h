@@ -0,0 +1,46 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BehaviorTree/BTTaskNode.h"
+#include "BTT_SubdueTarget.generated.h"
+
+struct FBTSubdueTargetMemory
+{
+	/** Counts down through the windup, then the recovery */
+	float TimeRemaining;
+	bool bStruck;
+};
+
+/**
+ * Turn to face the target in TargetKey, strike it, and wait to recover. Fails if the target is
+ * already subdued or out of reach when the windup ends.
+ */
+UCLASS()
+class PRINCESSPIG_API UBTT_SubdueTarget : public UBTTaskNode
+{
+	GENERATED_BODY()
+
+	UBTT_SubdueTarget();
+
+	virtual EBTNodeResult::Type ExecuteTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+
+	virtual EBTNodeResult::Type AbortTask(UBehaviorTreeComponent& OwnerComp, uint8* NodeMemory) override;
+
+	virtual void TickTask(UBehaviorTreeComponent & OwnerComp, uint8 * NodeMemory, float DeltaSeconds) override;
+
+	virtual uint16 GetInstanceMemorySize() const override { return sizeof(FBTSubdueTargetMemory); }
+
+public:
+	UPROPERTY(EditAnywhere, Category = "Subdue")
+	FBlackboardKeySelector TargetKey;
+
+	/** Seconds spent turning to face the target before striking */
+	UPROPERTY(EditAnywhere, Category = "Subdue")
+	float WindupTime;
+
+	/** Seconds after striking before the task finishes */
+	UPROPERTY(EditAnywhere, Category = "Subdue")
+	float RecoveryTime;
+};
@@ -0,0 +1,91 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CameraRelevancy.h"
+#include "PrincessPig.h"
+#include "GameFramework/Actor.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Camera Relevancy Checks"), STAT_PPCameraRelevancyChecks, STATGROUP_PrincessPig);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Culled By Camera Footprint"), STAT_PPCameraRelevancyCulled, STATGROUP_PrincessPig);
+
+FPPCameraRelevancy::FPPCameraRelevancy()
+{
+	bEnabled = true;
+	EnterMargin = 400.f;
+	ExitMargin = 800.f;
+
+	// Same as the camera boom in APrincessPigCharacter
+	CameraRotation = FRotator(280.f, 0.f, 0.f);
+	FieldOfView = 90.f;
+	AspectRatio = 16.f / 9.f;
+
+	bPlanesValid = false;
+}
+
+void FPPCameraRelevancy::UpdatePlanes() const
+{
+	const FRotationMatrix CameraMatrix(CameraRotation);
+	const FVector Forward = CameraMatrix.GetUnitAxis(EAxis::X);
+	const FVector Right = CameraMatrix.GetUnitAxis(EAxis::Y);
+	const FVector Up = CameraMatrix.GetUnitAxis(EAxis::Z);
+
+	const float HalfHorizontal = FMath::DegreesToRadians(FieldOfView * 0.5f);
+	const float HalfVertical = FMath::Atan(FMath::Tan(HalfHorizontal) / FMath::Max(AspectRatio, KINDA_SMALL_NUMBER));
+
+	float SinH, CosH, SinV, CosV;
+	FMath::SinCos(&SinH, &CosH, HalfHorizontal);
+	FMath::SinCos(&SinV, &CosV, HalfVertical);
+
+	PlaneNormals[0] = Forward * SinH - Right * CosH;
+	PlaneNormals[1] = Forward * SinH + Right * CosH;
+	PlaneNormals[2] = Forward * SinV - Up * CosV;
+	PlaneNormals[3] = Forward * SinV + Up * CosV;
+
+	bPlanesValid = true;
+}
+
+bool FPPCameraRelevancy::IsRelevant(const FVector& Location, const AActor* RealViewer, const FVector& ViewLocation) const
+{
+	INC_DWORD_STAT(STAT_PPCameraRelevancyChecks);
+
+	if (!bPlanesValid)
+	{
+		UpdatePlanes();
+	}
+
+	bool* Found = RelevantToViewer.Find(RealViewer);
+	if (nullptr == Found)
+	{
+		// Only grows when a viewer joins, so that's the time to forget the ones who left
+		for (auto It = RelevantToViewer.CreateIterator(); It; ++It)
+		{
+			if (!It.Key().IsValid())
+			{
+				It.RemoveCurrent();
+			}
+		}
+		Found = &RelevantToViewer.Add(RealViewer, false);
+	}
+
+	bool& bWasRelevant = *Found;
+	const float Margin = bWasRelevant ? ExitMargin : EnterMargin;
+
+	// Signed distance to each side plane, positive inside
+	const FVector ToLocation = Location - ViewLocation;
+	bool bIsRelevant = true;
+	for (const FVector& Normal : PlaneNormals)
+	{
+		if (FVector::DotProduct(ToLocation, Normal) < -Margin)
+		{
+			bIsRelevant = false;
+			break;
+		}
+	}
+
+	if (!bIsRelevant)
+	{
+		INC_DWORD_STAT(STAT_PPCameraRelevancyCulled);
+	}
+
+	bWasRelevant = bIsRelevant;
+	return bIsRelevant;
+}
@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/WeakObjectPtr.h"
+#include "CameraRelevancy.generated.h"
+
+/**
+ * Net relevancy based on what a top-down camera can actually see.
+ *
+ * The camera never rotates, so the visible area around a viewer is a fixed frustum.
+ * An actor is relevant while it is inside that frustum, grown by a margin. Actors that
+ * are already relevant use the bigger ExitMargin, so they don't flicker in and out
+ * while sitting on the edge of the screen.
+ */
+USTRUCT(BlueprintType)
+struct PRINCESSPIG_API FPPCameraRelevancy
+{
+	GENERATED_BODY()
+
+	/** Use the camera footprint instead of the default distance check */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Replication")
+	bool bEnabled;
+
+	/** Extra distance around the visible area before an actor becomes relevant */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Replication")
+	float EnterMargin;
+
+	/** Extra distance around the visible area before a relevant actor stops being relevant */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Replication")
+	float ExitMargin;
+
+	/** Should match the camera boom rotation */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Replication")
+	FRotator CameraRotation;
+
+	/** Horizontal field of view of the camera, in degrees */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Replication")
+	float FieldOfView;
+
+	/** Widest aspect ratio we expect a client to play at */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Replication")
+	float AspectRatio;
+
+	FPPCameraRelevancy();
+
+	/** Is Location inside the footprint of a camera at ViewLocation? Remembers the answer per viewer */
+	bool IsRelevant(const FVector& Location, const AActor* RealViewer, const FVector& ViewLocation) const;
+
+private:
+	/** Inward facing normals of the four side planes of the frustum */
+	mutable FVector PlaneNormals[4];
+	mutable bool bPlanesValid;
+
+	/** Whether we were relevant to each viewer last time we were asked. Viewers that have gone are dropped when a new one shows up */
+	mutable TMap<TWeakObjectPtr<const AActor>, bool> RelevantToViewer;
+
+	void UpdatePlanes() const;
+};
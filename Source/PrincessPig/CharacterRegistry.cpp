@@ -0,0 +1,229 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CharacterRegistry.h"
+#include "PrincessPig.h"
+#include "PrincessPigCharacter.h"
+#include "Components/SceneComponent.h"
+#include "GameFramework/PawnMovementComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "WorldActorCache.h"
+
+DECLARE_CYCLE_STAT(TEXT("Character Registry Gather"), STAT_PPCharacterRegistryGather, STATGROUP_PrincessPig);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Registered Characters"), STAT_PPRegisteredCharacters, STATGROUP_PrincessPig);
+
+ACharacterRegistry::ACharacterRegistry()
+{
+	// Snapshot after everyone has moved, read by next frame's AI
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickGroup = TG_PostPhysics;
+
+	bReplicates = false;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>("Root");
+
+	bEnabled = true;
+}
+
+void ACharacterRegistry::BeginPlay()
+{
+	Super::BeginPlay();
+
+	TPPWorldActorCache<ACharacterRegistry>::Add(this);
+}
+
+void ACharacterRegistry::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	TPPWorldActorCache<ACharacterRegistry>::Remove(this);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+ACharacterRegistry* ACharacterRegistry::GetCharacterRegistry(const UObject* WorldContextObject)
+{
+	if (!GetDefault<ACharacterRegistry>()->bEnabled)
+	{
+		return nullptr;
+	}
+
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::ReturnNull);
+	if (nullptr == World || World->IsNetMode(NM_Client))
+	{
+		return nullptr;
+	}
+
+	if (ACharacterRegistry* Existing = FindCharacterRegistry(World))
+	{
+		return Existing;
+	}
+
+	// Cached now as well as in BeginPlay, in case play hasn't begun yet
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.ObjectFlags |= RF_Transient;
+	ACharacterRegistry* Registry = World->SpawnActor<ACharacterRegistry>(SpawnParams);
+	if (Registry)
+	{
+		TPPWorldActorCache<ACharacterRegistry>::Add(Registry);
+	}
+	return Registry;
+}
+
+ACharacterRegistry* ACharacterRegistry::FindCharacterRegistry(const UObject* WorldContextObject)
+{
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::ReturnNull);
+	return TPPWorldActorCache<ACharacterRegistry>::Find(World);
+}
+
+const ACharacterRegistry* ACharacterRegistry::FindSlot(const AActor* Actor, int32& OutIndex)
+{
+	OutIndex = INDEX_NONE;
+
+	const APrincessPigCharacter* Character = Cast<APrincessPigCharacter>(Actor);
+	if (nullptr == Character || Character->CharacterRegistryIndex == INDEX_NONE)
+	{
+		return nullptr;
+	}
+
+	const ACharacterRegistry* Registry = Character->CharacterRegistry.Get();
+	if (Registry)
+	{
+		OutIndex = Character->CharacterRegistryIndex;
+	}
+	return Registry;
+}
+
+int32 ACharacterRegistry::FindIndex(const AActor* Actor, int32 LastIndex) const
+{
+	if (nullptr == Actor)
+	{
+		return INDEX_NONE;
+	}
+
+	if (SnapshotActors.IsValidIndex(LastIndex) && SnapshotActors[LastIndex] == Actor)
+	{
+		return LastIndex;
+	}
+
+	// Moved up since, or never found
+	const APrincessPigCharacter* Character = Cast<APrincessPigCharacter>(Actor);
+	const int32 Index = Character ? Character->CharacterRegistryIndex : INDEX_NONE;
+	return (SnapshotActors.IsValidIndex(Index) && SnapshotActors[Index] == Actor) ? Index : INDEX_NONE;
+}
+
+FVector ACharacterRegistry::GetLocationOf(const AActor* Actor)
+{
+	int32 Index;
+	const ACharacterRegistry* Registry = FindSlot(Actor, Index);
+	return Registry ? Registry->GetLocation(Index) : Actor->GetActorLocation();
+}
+
+uint8 ACharacterRegistry::GetStatusOf(const APrincessPigCharacter* Character)
+{
+	uint8 Bits = 0;
+	if (Character->Replicated_IsDead)
+	{
+		Bits |= EPPCharacterStatus::Dead;
+	}
+	if (Character->Replicated_IsSubdued)
+	{
+		Bits |= EPPCharacterStatus::Subdued;
+	}
+	if (Character->Replicated_IsOffBalance)
+	{
+		Bits |= EPPCharacterStatus::OffBalance;
+	}
+	if (Character->Replicated_IsBlinded)
+	{
+		Bits |= EPPCharacterStatus::Blinded;
+	}
+	if (Character->Replicated_IsDistracted)
+	{
+		Bits |= EPPCharacterStatus::Distracted;
+	}
+	return Bits;
+}
+
+void ACharacterRegistry::RegisterCharacter(APrincessPigCharacter* Character)
+{
+	if (Character && !Characters.Contains(Character))
+	{
+		Characters.Add(Character);
+		Character->CharacterRegistry = this;
+		Character->CharacterRegistryIndex = INDEX_NONE;
+	}
+}
+
+void ACharacterRegistry::UnregisterCharacter(APrincessPigCharacter* Character)
+{
+	// Cleared rather than removed, so indices handed out this frame stay valid. Gather compacts
+	const int32 Index = Characters.IndexOfByKey(Character);
+	if (Index != INDEX_NONE)
+	{
+		Characters[Index] = nullptr;
+		if (SnapshotActors.IsValidIndex(Character->CharacterRegistryIndex))
+		{
+			SnapshotActors[Character->CharacterRegistryIndex] = nullptr;
+		}
+		Character->CharacterRegistry = nullptr;
+		Character->CharacterRegistryIndex = INDEX_NONE;
+	}
+}
+
+void ACharacterRegistry::UpdateStatus(const APrincessPigCharacter* Character)
+{
+	const int32 Index = Character->CharacterRegistryIndex;
+	if (Status.IsValidIndex(Index))
+	{
+		Status[Index] = GetStatusOf(Character);
+	}
+}
+
+void ACharacterRegistry::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	Gather();
+}
+
+void ACharacterRegistry::Gather()
+{
+	SCOPE_CYCLE_COUNTER(STAT_PPCharacterRegistryGather);
+
+	Characters.RemoveAll([](const TWeakObjectPtr<APrincessPigCharacter>& Character) { return !Character.IsValid(); });
+
+	const int32 NumCharacters = Characters.Num();
+	SET_DWORD_STAT(STAT_PPRegisteredCharacters, NumCharacters);
+
+	PositionX.SetNumUninitialized(NumCharacters, false);
+	PositionY.SetNumUninitialized(NumCharacters, false);
+	PositionZ.SetNumUninitialized(NumCharacters, false);
+	VelocityX.SetNumUninitialized(NumCharacters, false);
+	VelocityY.SetNumUninitialized(NumCharacters, false);
+	VelocityZ.SetNumUninitialized(NumCharacters, false);
+	MaxSpeed.SetNumUninitialized(NumCharacters, false);
+	TeamId.SetNumUninitialized(NumCharacters, false);
+	Status.SetNumUninitialized(NumCharacters, false);
+	SnapshotActors.SetNumUninitialized(NumCharacters, false);
+
+	for (int32 i = 0; i < NumCharacters; i++)
+	{
+		APrincessPigCharacter* Character = Characters[i].Get();
+		Character->CharacterRegistryIndex = i;
+		SnapshotActors[i] = Character;
+
+		const FVector Location = Character->GetActorLocation();
+		const FVector Velocity = Character->GetVelocity();
+		PositionX[i] = Location.X;
+		PositionY[i] = Location.Y;
+		PositionZ[i] = Location.Z;
+		VelocityX[i] = Velocity.X;
+		VelocityY[i] = Velocity.Y;
+		VelocityZ[i] = Velocity.Z;
+
+		const UPawnMovementComponent* Movement = Character->GetMovementComponent();
+		MaxSpeed[i] = Movement ? Movement->GetMaxSpeed() : 0.f;
+
+		TeamId[i] = Character->GetGenericTeamId().GetId();
+		Status[i] = GetStatusOf(Character);
+	}
+}
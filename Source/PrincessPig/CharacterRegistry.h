@@ -0,0 +1,113 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "CharacterRegistry.generated.h"
+
+class APrincessPigCharacter;
+
+/** Status bits packed for each registered character */
+namespace EPPCharacterStatus
+{
+	enum Type : uint8
+	{
+		Dead = 1 << 0,
+		Subdued = 1 << 1,
+		OffBalance = 1 << 2,
+		Blinded = 1 << 3,
+		Distracted = 1 << 4,
+
+		/** Any of these and a guard can't see */
+		VisionImpaired = Dead | Blinded | Distracted
+	};
+}
+
+/**
+ * Server-side snapshot of every character's position, velocity, max speed, team and status,
+ * packed into flat arrays for the AI to read.
+ *
+ * Characters register on BeginPlay and unregister on EndPlay. Once per frame, after physics, the
+ * registry copies their state out and gives each character its index (CharacterRegistryIndex)
+ * into the arrays until the next copy. Readers next frame see positions up to a frame old: players
+ * have already moved again in ServerMove during the net tick, and AI characters that tick before
+ * the reader have moved in TG_PrePhysics. Code that needs exactly where an actor is now should read
+ * the actor. Status bits are rewritten as soon as a status changes, so they are never a frame late.
+ *
+ * Characters registered since the last copy have no index yet; callers fall back to the actor.
+ * Per-frame readers keep the index they last found and pass it back to FindIndex, which checks it
+ * with a pointer compare. Indices only move when someone unregisters, so that is nearly always a hit.
+ *
+ * Settings can be changed in DefaultGame.ini under [/Script/PrincessPig.CharacterRegistry].
+ */
+UCLASS(NotPlaceable, Transient, Config = Game)
+class PRINCESSPIG_API ACharacterRegistry : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ACharacterRegistry();
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Find or spawn the registry for this world. Returns null on clients, or if bEnabled is off */
+	static ACharacterRegistry* GetCharacterRegistry(const UObject* WorldContextObject);
+
+	/** Find the registry without spawning one */
+	static ACharacterRegistry* FindCharacterRegistry(const UObject* WorldContextObject);
+
+	/**
+	 * The registry Actor is packed in, and its index, if it is a character registered before the
+	 * last snapshot. Returns null otherwise. For occasional queries; per-frame readers use FindIndex
+	 */
+	static const ACharacterRegistry* FindSlot(const AActor* Actor, int32& OutIndex);
+
+	/** Actor's index in this registry, trying LastIndex first. INDEX_NONE if it isn't in the snapshot */
+	int32 FindIndex(const AActor* Actor, int32 LastIndex) const;
+
+	/** Actor's location, from the registry if it is packed there, otherwise from the actor */
+	static FVector GetLocationOf(const AActor* Actor);
+
+	/** Status bits for Character as it is now */
+	static uint8 GetStatusOf(const APrincessPigCharacter* Character);
+
+	/** Pack characters for AI queries instead of reading them one by one */
+	UPROPERTY(Config, EditAnywhere, Category = "AI")
+	bool bEnabled;
+
+	void RegisterCharacter(APrincessPigCharacter* Character);
+	void UnregisterCharacter(APrincessPigCharacter* Character);
+
+	/** Rewrite Character's status bits now, rather than waiting for the next snapshot */
+	void UpdateStatus(const APrincessPigCharacter* Character);
+
+	FVector GetLocation(int32 Index) const { return FVector(PositionX[Index], PositionY[Index], PositionZ[Index]); }
+	FVector GetVelocity(int32 Index) const { return FVector(VelocityX[Index], VelocityY[Index], VelocityZ[Index]); }
+	float GetMaxSpeed(int32 Index) const { return MaxSpeed[Index]; }
+	uint8 GetTeamId(int32 Index) const { return TeamId[Index]; }
+
+	/** Does the character have any of the EPPCharacterStatus bits in Mask? */
+	bool HasAnyStatus(int32 Index, uint8 Mask) const { return (Status[Index] & Mask) != 0; }
+
+protected:
+	TArray<TWeakObjectPtr<APrincessPigCharacter>> Characters;
+
+	/** Who each snapshot entry belongs to, for checking an index without resolving a weak pointer */
+	TArray<const AActor*> SnapshotActors;
+
+	/** Character state, one entry per character in Characters order */
+	TArray<float> PositionX;
+	TArray<float> PositionY;
+	TArray<float> PositionZ;
+	TArray<float> VelocityX;
+	TArray<float> VelocityY;
+	TArray<float> VelocityZ;
+	TArray<float> MaxSpeed;
+	TArray<uint8> TeamId;
+	TArray<uint8> Status;
+
+	void Gather();
+};
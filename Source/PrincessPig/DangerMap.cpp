@@ -0,0 +1,212 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DangerMap.h"
+#include "PrincessPig.h"
+#include "Guard.h"
+#include "GuardAIController.h"
+#include "Components/SceneComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "WorldActorCache.h"
+#include "NavigationSystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Danger Map Update"), STAT_PPDangerMapUpdate, STATGROUP_PrincessPig);
+DECLARE_CYCLE_STAT(TEXT("Danger Map Find Safe Point"), STAT_PPDangerMapFindSafePoint, STATGROUP_PrincessPig);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Danger Map Queries"), STAT_PPDangerMapQueries, STATGROUP_PrincessPig);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Danger Map Cells"), STAT_PPDangerMapCells, STATGROUP_PrincessPig);
+
+ADangerMap::ADangerMap()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = true;
+	PrimaryActorTick.TickGroup = TG_PostPhysics;
+
+	bReplicates = false;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>("Root");
+
+	UpdateInterval = 0.25f;
+	CellSize = 200.f;
+	PresenceRadius = 300.f;
+	SightEdgeDanger = 0.3f;
+}
+
+void ADangerMap::BeginPlay()
+{
+	Super::BeginPlay();
+
+	TPPWorldActorCache<ADangerMap>::Add(this);
+
+	SetActorTickInterval(UpdateInterval);
+
+	// Whoever spawned the map wants an answer now
+	UpdateMap();
+}
+
+void ADangerMap::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	TPPWorldActorCache<ADangerMap>::Remove(this);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ADangerMap::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	UpdateMap();
+}
+
+ADangerMap* ADangerMap::GetDangerMap(const UObject* WorldContextObject)
+{
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::ReturnNull);
+	if (nullptr == World || World->IsNetMode(NM_Client))
+	{
+		return nullptr;
+	}
+
+	if (ADangerMap* Existing = TPPWorldActorCache<ADangerMap>::Find(World))
+	{
+		return Existing;
+	}
+
+	// Cached now as well as in BeginPlay, in case play hasn't begun yet
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.ObjectFlags |= RF_Transient;
+	ADangerMap* DangerMap = World->SpawnActor<ADangerMap>(SpawnParams);
+	if (DangerMap)
+	{
+		TPPWorldActorCache<ADangerMap>::Add(DangerMap);
+	}
+	return DangerMap;
+}
+
+ADangerMap* ADangerMap::FindDangerMap(const UObject* WorldContextObject)
+{
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::ReturnNull);
+	return TPPWorldActorCache<ADangerMap>::Find(World);
+}
+
+float ADangerMap::GetDangerAt(const UObject* WorldContextObject, FVector Location)
+{
+	ADangerMap* DangerMap = FindDangerMap(WorldContextObject);
+	return DangerMap ? DangerMap->GetDanger(Location) : 0.f;
+}
+
+FIntPoint ADangerMap::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
+
+float ADangerMap::GetDanger(FVector Location) const
+{
+	INC_DWORD_STAT(STAT_PPDangerMapQueries);
+
+	const float* Found = Cells.Find(GetCell(Location));
+	return Found ? *Found : 0.f;
+}
+
+void ADangerMap::UpdateMap()
+{
+	SCOPE_CYCLE_COUNTER(STAT_PPDangerMapUpdate);
+
+	Cells.Reset();
+
+	for (TActorIterator<AGuard> It(GetWorld()); It; ++It)
+	{
+		AGuard* Guard = *It;
+		if (Guard->Replicated_IsDead)
+		{
+			continue;
+		}
+
+		// Guards without a perception setup still get their presence stamped
+		float SightRadius = 0.f;
+		float SightHalfAngle = 0.f;
+		AGuardAIController* GuardController = Cast<AGuardAIController>(Guard->GetController());
+		if (GuardController && GuardController->SightConfig)
+		{
+			SightRadius = GuardController->SightConfig->SightRadius;
+			SightHalfAngle = GuardController->SightConfig->PeripheralVisionAngleDegrees;
+		}
+
+		StampGuard(Guard->GetActorLocation(), Guard->GetActorForwardVector(), SightRadius, SightHalfAngle);
+	}
+
+	SET_DWORD_STAT(STAT_PPDangerMapCells, Cells.Num());
+}
+
+void ADangerMap::StampGuard(const FVector& Location, const FVector& Forward, float SightRadius, float SightHalfAngle)
+{
+	const float Reach = FMath::Max(SightRadius, PresenceRadius);
+	const FIntPoint Min = GetCell(Location - FVector(Reach, Reach, 0.f));
+	const FIntPoint Max = GetCell(Location + FVector(Reach, Reach, 0.f));
+
+	const FVector2D Origin(Location);
+	const FVector2D Facing = FVector2D(Forward).GetSafeNormal();
+	const float CosHalfAngle = FMath::Cos(FMath::DegreesToRadians(SightHalfAngle));
+
+	for (int32 X = Min.X; X <= Max.X; X++)
+	{
+		for (int32 Y = Min.Y; Y <= Max.Y; Y++)
+		{
+			const FVector2D ToCell = FVector2D((X + 0.5f) * CellSize, (Y + 0.5f) * CellSize) - Origin;
+			const float Distance = ToCell.Size();
+
+			float Danger = 0.f;
+			if (Distance < PresenceRadius)
+			{
+				Danger = 1.f - Distance / PresenceRadius;
+			}
+			if (Distance < SightRadius && (Distance < KINDA_SMALL_NUMBER || FVector2D::DotProduct(ToCell / Distance, Facing) >= CosHalfAngle))
+			{
+				Danger = FMath::Max(Danger, FMath::Lerp(1.f, SightEdgeDanger, Distance / SightRadius));
+			}
+
+			if (Danger > 0.f)
+			{
+				float& Cell = Cells.FindOrAdd(FIntPoint(X, Y));
+				Cell = FMath::Max(Cell, Danger);
+			}
+		}
+	}
+}
+
+bool ADangerMap::FindSafePoint(FVector Origin, float Radius, int32 NumSamples, FVector& OutLocation, FVector Avoid, bool bUseAvoid) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_PPDangerMapFindSafePoint);
+
+	UNavigationSystemV1* NavSys = UNavigationSystemV1::GetNavigationSystem(GetWorld());
+	if (nullptr == NavSys)
+	{
+		return false;
+	}
+
+	// Danger matters most, distance from Avoid breaks ties between similar points
+	bool bFound = false;
+	float BestScore = BIG_NUMBER;
+	for (int32 i = 0; i < NumSamples; i++)
+	{
+		FNavLocation NavLocation;
+		if (!NavSys->GetRandomPointInNavigableRadius(Origin, Radius, NavLocation))
+		{
+			continue;
+		}
+
+		float Score = GetDanger(NavLocation.Location);
+		if (bUseAvoid)
+		{
+			Score -= 0.25f * FMath::Min(FVector::Dist2D(NavLocation.Location, Avoid) / FMath::Max(Radius, 1.f), 2.f);
+		}
+
+		if (Score < BestScore)
+		{
+			BestScore = Score;
+			OutLocation = NavLocation.Location;
+			bFound = true;
+		}
+	}
+
+	return bFound;
+}
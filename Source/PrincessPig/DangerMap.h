@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "DangerMap.generated.h"
+
+/**
+ * Server-side 2D map of how likely a guard is to see each spot in the level.
+ *
+ * Every update the map is cleared and each living guard stamps the cells inside its sight
+ * cone, using the SightRadius and PeripheralVisionAngleDegrees of its perception, plus a small
+ * circle around it for anything it could hear or bump into. Danger is highest next to a guard
+ * and falls off towards the edge of its sight. Walls are ignored, so the map errs on the side
+ * of caution.
+ *
+ * Updates run at a fixed rate and cost depends only on the number of guards. Escapees read it
+ * with a single map lookup, so wander and flee point selection can weigh many candidates.
+ *
+ * Spawned by the game mode when play starts, so readers only ever look it up. Settings can be changed in DefaultGame.ini under
+ * [/Script/PrincessPig.DangerMap].
+ */
+UCLASS(NotPlaceable, Transient, Config = Game)
+class PRINCESSPIG_API ADangerMap : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ADangerMap();
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Find or spawn the map for this world. Returns null on clients */
+	UFUNCTION(BlueprintCallable, Category = "Danger", meta = (WorldContext = "WorldContextObject"))
+	static ADangerMap* GetDangerMap(const UObject* WorldContextObject);
+
+	/** The map for this world if there is one. Never spawns, so it is cheap enough to call per query */
+	static ADangerMap* FindDangerMap(const UObject* WorldContextObject);
+
+	/** Danger at Location from 0 (unseen) to 1 (right next to a guard), or 0 if there is no map */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Danger", meta = (WorldContext = "WorldContextObject"))
+	static float GetDangerAt(const UObject* WorldContextObject, FVector Location);
+
+	/** Seconds between updates */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Danger")
+	float UpdateInterval;
+
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Danger")
+	float CellSize;
+
+	/** Guards are dangerous this close whichever way they face */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Danger")
+	float PresenceRadius;
+
+	/** Danger at the far edge of a guard's sight, rising to 1 next to the guard */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Danger")
+	float SightEdgeDanger;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Danger")
+	float GetDanger(FVector Location) const;
+
+	/**
+	 * Sample NumSamples random navigable points around Origin and pick the least dangerous,
+	 * preferring those further from Avoid when it is set. False if none were found
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Danger")
+	bool FindSafePoint(FVector Origin, float Radius, int32 NumSamples, FVector& OutLocation, FVector Avoid = FVector::ZeroVector, bool bUseAvoid = false) const;
+
+	/** Stamp the cells now rather than waiting for the next update */
+	void UpdateMap();
+
+protected:
+	TMap<FIntPoint, float> Cells;
+
+	FIntPoint GetCell(const FVector& Location) const;
+	void StampGuard(const FVector& Location, const FVector& Forward, float SightRadius, float SightHalfAngle);
+};
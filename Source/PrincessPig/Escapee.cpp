@@ -5,7 +5,8 @@
 #include "Components/CapsuleComponent.h"
 
 
-AEscapee::AEscapee()
+AEscapee::AEscapee(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
 {
 	// Configure avoidance group
 	FNavAvoidanceMask DefaultAvoidanceGroup;
@@ -19,6 +20,10 @@ AEscapee::AEscapee()
 
 	RunSpeed = 500;
 
+	// There are lots of escapees, and they are slower than guards
+	NetUpdatePolicy.ActiveFrequency = 20.f;
+	NetUpdatePolicy.IdleFrequency = 3.f;
+
 	SetGenericTeamId(255);
 	Tags.AddUnique(FName("Escapee"));
 }
@@ -2,6 +2,7 @@
 
 #include "EscapeeAIController.h"
 #include "PrincessPigCharacter.h"
+#include "PPCharacterMovementComponent.h"
 #include "Escapee.h"
 
 
@@ -40,6 +41,9 @@ void AEscapeeAIController::Possess(APawn* Pawn)
 		// Enable collision avoidance
 		PPCharacter->SetCollisionAvoidanceEnabled(true);
 
+		// Walk on the navmesh when there is nothing around to bump into
+		PPCharacter->GetPPCharacterMovement()->SetNavWalkingAllowed(true);
+
 		// Configure avoidance group
 		FNavAvoidanceMask DefaultAvoidanceGroup;
 		DefaultAvoidanceGroup.ClearAll();
@@ -47,7 +51,7 @@ void AEscapeeAIController::Possess(APawn* Pawn)
 		PPCharacter->GetCharacterMovement()->SetAvoidanceGroupMask(DefaultAvoidanceGroup);
 
 		// Allow AI escapees to be lead
-		PPCharacter->Replicated_CanBecomeFollower = true;
+		PPCharacter->SetCanBecomeFollower(true);
 	}
 }
 
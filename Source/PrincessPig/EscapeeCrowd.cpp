@@ -0,0 +1,528 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "EscapeeCrowd.h"
+#include "PrincessPig.h"
+#include "PrincessPigCharacter.h"
+#include "Escapee.h"
+#include "Guard.h"
+#include "Components/SceneComponent.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "NavigationSystem.h"
+#include "Net/UnrealNetwork.h"
+
+DECLARE_CYCLE_STAT(TEXT("Crowd Simulate"), STAT_PPCrowdSimulate, STATGROUP_PrincessPig);
+DECLARE_CYCLE_STAT(TEXT("Crowd Instances"), STAT_PPCrowdInstances, STATGROUP_PrincessPig);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Crowd Agents"), STAT_PPCrowdAgents, STATGROUP_PrincessPig);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Crowd Nav Queries"), STAT_PPCrowdNavQueries, STATGROUP_PrincessPig);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Crowd Promotions"), STAT_PPCrowdPromotions, STATGROUP_PrincessPig);
+
+AEscapeeCrowd::AEscapeeCrowd()
+{
+	PrimaryActorTick.bCanEverTick = true;
+
+	// Agents are spread all over, and only a few bytes each
+	SetReplicates(true);
+	bAlwaysRelevant = true;
+	NetUpdateFrequency = 5.f;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>("Root");
+
+	Instances = CreateDefaultSubobject<UInstancedStaticMeshComponent>("Instances");
+	Instances->SetupAttachment(RootComponent);
+	Instances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Instances->SetCanEverAffectNavigation(false);
+
+	EscapeeClass = AEscapee::StaticClass();
+	NumAgents = 200;
+	SpawnRadius = 2000.f;
+	WanderRadius = 800.f;
+	WalkSpeed = 150.f;
+	FleeSpeed = 450.f;
+	SeparationRadius = 70.f;
+	FleeRadius = 600.f;
+	PlayerPromotionRadius = 300.f;
+	GuardPromotionRadius = 1200.f;
+	GuardPromotionAngle = 60.f;
+	MaxNavQueriesPerTick = 8;
+	MaxPromotionsPerCheck = 2;
+	QuantizationStep = 4.f;
+
+	DrawnBlendTime = 0.f;
+	NextTargetQuery = 0;
+	TimeSinceNetWrite = 0.f;
+	TimeSincePromotionCheck = 0.f;
+}
+
+void AEscapeeCrowd::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(AEscapeeCrowd, Replicated_Agents);
+}
+
+void AEscapeeCrowd::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (HasAuthority())
+	{
+		SpawnAgents();
+		WriteNetState();
+		OnRep_Agents();
+	}
+}
+
+int32 AEscapeeCrowd::GetNumActiveAgents() const
+{
+	int32 NumActive = 0;
+	for (const FPPCrowdAgentNet& Agent : Replicated_Agents)
+	{
+		NumActive += Agent.bActive ? 1 : 0;
+	}
+	return NumActive;
+}
+
+void AEscapeeCrowd::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	if (HasAuthority())
+	{
+		GatherThreats();
+		Simulate(DeltaSeconds);
+		UpdateTargets();
+
+		TimeSincePromotionCheck += DeltaSeconds;
+		if (TimeSincePromotionCheck > 0.25f)
+		{
+			TimeSincePromotionCheck = 0.f;
+			CheckPromotions();
+		}
+
+		TimeSinceNetWrite += DeltaSeconds;
+		if (TimeSinceNetWrite > 1.f / NetUpdateFrequency)
+		{
+			TimeSinceNetWrite = 0.f;
+			WriteNetState();
+		}
+	}
+
+	UpdateInstances(DeltaSeconds);
+}
+
+#pragma region Simulation
+
+void AEscapeeCrowd::SpawnAgents()
+{
+	UNavigationSystemV1* NavSys = UNavigationSystemV1::GetNavigationSystem(this);
+
+	Positions.SetNumUninitialized(NumAgents);
+	Velocities.SetNumZeroed(NumAgents);
+	Targets.SetNumUninitialized(NumAgents);
+	WaitTimes.SetNumUninitialized(NumAgents);
+	Fleeing.SetNumZeroed(NumAgents);
+	Active.SetNumUninitialized(NumAgents);
+	NeedsTarget.SetNumZeroed(NumAgents);
+
+	for (int32 i = 0; i < NumAgents; i++)
+	{
+		FNavLocation NavLocation;
+		Positions[i] = (NavSys && NavSys->GetRandomPointInNavigableRadius(GetActorLocation(), SpawnRadius, NavLocation)) ? NavLocation.Location : GetActorLocation();
+		Targets[i] = Positions[i];
+		WaitTimes[i] = FMath::FRandRange(0.f, 3.f);
+		Active[i] = 1;
+	}
+
+	SET_DWORD_STAT(STAT_PPCrowdAgents, NumAgents);
+}
+
+void AEscapeeCrowd::GatherThreats()
+{
+	Threats.Reset();
+	for (TActorIterator<APrincessPigCharacter> It(GetWorld()); It; ++It)
+	{
+		APrincessPigCharacter* Character = *It;
+		const bool bIsGuard = Character->IsA<AGuard>();
+		if (Character->Replicated_IsDead || (!bIsGuard && !Character->IsPlayerControlled()))
+		{
+			continue;
+		}
+
+		FPPCrowdThreat Threat;
+		Threat.Location = Character->GetActorLocation();
+		Threat.Forward = Character->GetActorForwardVector();
+		Threat.bIsGuard = bIsGuard;
+		Threats.Add(Threat);
+	}
+}
+
+void AEscapeeCrowd::BuildGrid()
+{
+	const int32 Num = Positions.Num();
+	AgentCells.SetNumUninitialized(Num, false);
+	SortedAgents.Reset(Num);
+	for (int32 i = 0; i < Num; i++)
+	{
+		AgentCells[i] = GetCellKey(FMath::FloorToInt(Positions[i].X / SeparationRadius), FMath::FloorToInt(Positions[i].Y / SeparationRadius));
+		if (Active[i])
+		{
+			SortedAgents.Add(i);
+		}
+	}
+	SortedAgents.Sort([this](int32 A, int32 B) { return AgentCells[A] < AgentCells[B]; });
+
+	CellStarts.Reset();
+	for (int32 s = 0; s < SortedAgents.Num(); s++)
+	{
+		if (s == 0 || AgentCells[SortedAgents[s]] != AgentCells[SortedAgents[s - 1]])
+		{
+			CellStarts.Add(AgentCells[SortedAgents[s]], s);
+		}
+	}
+}
+
+void AEscapeeCrowd::Simulate(float DeltaSeconds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PPCrowdSimulate);
+
+	BuildGrid();
+
+	const float FleeRadiusSquared = FMath::Square(FleeRadius);
+	const float CalmRadiusSquared = FMath::Square(FleeRadius * 1.5f);
+	const float SeparationRadiusSquared = FMath::Square(SeparationRadius);
+
+	for (int32 i = 0; i < Positions.Num(); i++)
+	{
+		if (!Active[i])
+		{
+			continue;
+		}
+		const FVector& Position = Positions[i];
+
+		// Run from anyone too close, calm down once well clear
+		float NearestThreatSquared = BIG_NUMBER;
+		for (const FPPCrowdThreat& Threat : Threats)
+		{
+			NearestThreatSquared = FMath::Min(NearestThreatSquared, FVector::DistSquared2D(Threat.Location, Position));
+		}
+		if (!Fleeing[i] && NearestThreatSquared < FleeRadiusSquared)
+		{
+			Fleeing[i] = 1;
+			NeedsTarget[i] = 1;
+			WaitTimes[i] = 0.f;
+		}
+		else if (Fleeing[i] && NearestThreatSquared > CalmRadiusSquared)
+		{
+			Fleeing[i] = 0;
+		}
+
+		// Head for the target, or wait there for a bit
+		FVector2D Desired = FVector2D::ZeroVector;
+		if (WaitTimes[i] > 0.f)
+		{
+			WaitTimes[i] -= DeltaSeconds;
+			if (WaitTimes[i] <= 0.f)
+			{
+				NeedsTarget[i] = 1;
+			}
+		}
+		else
+		{
+			const FVector2D ToTarget = FVector2D(Targets[i] - Position);
+			const float Distance = ToTarget.Size();
+			if (Distance < SeparationRadius * 0.5f)
+			{
+				if (Fleeing[i])
+				{
+					NeedsTarget[i] = 1;
+				}
+				else if (!NeedsTarget[i])
+				{
+					WaitTimes[i] = FMath::FRandRange(1.f, 4.f);
+				}
+			}
+			else
+			{
+				Desired = ToTarget / Distance * (Fleeing[i] ? FleeSpeed : WalkSpeed);
+			}
+		}
+
+		// Stay out of each other's way
+		FVector2D Separation = FVector2D::ZeroVector;
+		const int32 CellX = FMath::FloorToInt(Position.X / SeparationRadius);
+		const int32 CellY = FMath::FloorToInt(Position.Y / SeparationRadius);
+		for (int32 DX = -1; DX <= 1; DX++)
+		{
+			for (int32 DY = -1; DY <= 1; DY++)
+			{
+				const uint64 Cell = GetCellKey(CellX + DX, CellY + DY);
+				const int32* Start = CellStarts.Find(Cell);
+				for (int32 s = Start ? *Start : SortedAgents.Num(); s < SortedAgents.Num() && AgentCells[SortedAgents[s]] == Cell; s++)
+				{
+					const int32 Other = SortedAgents[s];
+					const FVector2D Away = FVector2D(Position - Positions[Other]);
+					const float DistanceSquared = Away.SizeSquared();
+					if (Other != i && DistanceSquared < SeparationRadiusSquared && DistanceSquared > KINDA_SMALL_NUMBER)
+					{
+						const float Distance = FMath::Sqrt(DistanceSquared);
+						Separation += Away / Distance * (1.f - Distance / SeparationRadius);
+					}
+				}
+			}
+		}
+		Desired += Separation * WalkSpeed;
+
+		Velocities[i] = FMath::Vector2DInterpTo(Velocities[i], Desired, DeltaSeconds, 6.f);
+		Positions[i].X += Velocities[i].X * DeltaSeconds;
+		Positions[i].Y += Velocities[i].Y * DeltaSeconds;
+		Positions[i].Z = FMath::FInterpTo(Position.Z, Targets[i].Z, DeltaSeconds, 2.f);
+	}
+}
+
+void AEscapeeCrowd::UpdateTargets()
+{
+	// A few navmesh queries a frame, taking turns
+	int32 Queries = 0;
+	for (int32 Checked = 0; Checked < Positions.Num() && Queries < MaxNavQueriesPerTick; Checked++)
+	{
+		const int32 i = NextTargetQuery;
+		NextTargetQuery = (NextTargetQuery + 1) % Positions.Num();
+		if (!Active[i] || !NeedsTarget[i])
+		{
+			continue;
+		}
+
+		// Fleeing agents pick somewhere on the far side from whoever is nearest
+		FVector Origin = Positions[i];
+		float Radius = WanderRadius;
+		if (Fleeing[i] && Threats.Num() > 0)
+		{
+			const FPPCrowdThreat* Nearest = &Threats[0];
+			for (const FPPCrowdThreat& Threat : Threats)
+			{
+				if (FVector::DistSquared2D(Threat.Location, Positions[i]) < FVector::DistSquared2D(Nearest->Location, Positions[i]))
+				{
+					Nearest = &Threat;
+				}
+			}
+			Origin += (Positions[i] - Nearest->Location).GetSafeNormal2D() * WanderRadius * 0.75f;
+			Radius = WanderRadius * 0.25f;
+		}
+
+		FindTarget(i, Origin, Radius);
+		Queries++;
+	}
+}
+
+bool AEscapeeCrowd::FindTarget(int32 Index, const FVector& Origin, float Radius)
+{
+	INC_DWORD_STAT(STAT_PPCrowdNavQueries);
+
+	UNavigationSystemV1* NavSys = UNavigationSystemV1::GetNavigationSystem(this);
+	FNavLocation NavLocation;
+	if (nullptr == NavSys || !NavSys->GetRandomPointInNavigableRadius(Origin, Radius, NavLocation))
+	{
+		return false;
+	}
+
+	// Agents walk in straight lines, so stop short of anything in the way
+	FVector Target = NavLocation.Location;
+	FVector HitLocation;
+	if (UNavigationSystemV1::NavigationRaycast(this, Positions[Index], Target, HitLocation))
+	{
+		Target = FMath::Lerp(Positions[Index], HitLocation, 0.9f);
+	}
+
+	Targets[Index] = Target;
+	NeedsTarget[Index] = 0;
+	return true;
+}
+
+void AEscapeeCrowd::CheckPromotions()
+{
+	const float PlayerRadiusSquared = FMath::Square(PlayerPromotionRadius);
+	const float GuardRadiusSquared = FMath::Square(GuardPromotionRadius);
+	const float GuardCosAngle = FMath::Cos(FMath::DegreesToRadians(GuardPromotionAngle));
+
+	int32 Promotions = 0;
+	for (int32 i = 0; i < Positions.Num() && Promotions < MaxPromotionsPerCheck; i++)
+	{
+		if (!Active[i])
+		{
+			continue;
+		}
+
+		for (const FPPCrowdThreat& Threat : Threats)
+		{
+			const FVector ToAgent = Positions[i] - Threat.Location;
+			const float DistanceSquared = ToAgent.SizeSquared2D();
+			const bool bPromote = Threat.bIsGuard
+				? DistanceSquared < GuardRadiusSquared && FVector::DotProduct(ToAgent.GetSafeNormal2D(), Threat.Forward) > GuardCosAngle
+				: DistanceSquared < PlayerRadiusSquared;
+			if (bPromote)
+			{
+				PromoteAgent(i);
+				Promotions++;
+				break;
+			}
+		}
+	}
+}
+
+AEscapee* AEscapeeCrowd::PromoteAgent(int32 Index)
+{
+	if (!HasAuthority() || !Active.IsValidIndex(Index) || !Active[Index] || nullptr == *EscapeeClass)
+	{
+		return nullptr;
+	}
+
+	// Capsule centre goes half its height above the floor the agent is on
+	const AEscapee* DefaultEscapee = EscapeeClass->GetDefaultObject<AEscapee>();
+	const float HalfHeight = DefaultEscapee->GetCapsuleComponent() ? DefaultEscapee->GetCapsuleComponent()->GetScaledCapsuleHalfHeight() : 96.f;
+	const FVector Location = Positions[Index] + FVector(0.f, 0.f, HalfHeight);
+	const FRotator Rotation(0.f, FMath::RadiansToDegrees(FMath::Atan2(Velocities[Index].Y, Velocities[Index].X)), 0.f);
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+	AEscapee* Escapee = GetWorld()->SpawnActor<AEscapee>(EscapeeClass, Location, Rotation, SpawnParams);
+	if (nullptr == Escapee)
+	{
+		return nullptr;
+	}
+	if (nullptr == Escapee->GetController())
+	{
+		Escapee->SpawnDefaultController();
+	}
+
+	Active[Index] = 0;
+	INC_DWORD_STAT(STAT_PPCrowdPromotions);
+	DEC_DWORD_STAT(STAT_PPCrowdAgents);
+
+	// Hide the instance straight away rather than at the next write
+	if (Replicated_Agents.IsValidIndex(Index))
+	{
+		Replicated_Agents[Index].bActive = false;
+	}
+	return Escapee;
+}
+
+#pragma endregion Simulation
+
+#pragma region Replication
+
+void AEscapeeCrowd::WriteNetState()
+{
+	Replicated_Agents.SetNum(Positions.Num());
+
+	const FVector Origin = GetActorLocation();
+	for (int32 i = 0; i < Positions.Num(); i++)
+	{
+		FPPCrowdAgentNet& Agent = Replicated_Agents[i];
+		const FVector Steps = (Positions[i] - Origin) / QuantizationStep;
+		Agent.X = (int16)FMath::Clamp(FMath::RoundToInt(Steps.X), -MAX_int16, (int32)MAX_int16);
+		Agent.Y = (int16)FMath::Clamp(FMath::RoundToInt(Steps.Y), -MAX_int16, (int32)MAX_int16);
+		Agent.Z = (int16)FMath::Clamp(FMath::RoundToInt(Steps.Z), -MAX_int16, (int32)MAX_int16);
+		Agent.bActive = Active[i] != 0;
+
+		// Keep facing the same way while standing still
+		if (!Velocities[i].IsNearlyZero(1.f))
+		{
+			const float Yaw = FMath::RadiansToDegrees(FMath::Atan2(Velocities[i].Y, Velocities[i].X));
+			Agent.Yaw = (uint8)(FMath::RoundToInt(FRotator::ClampAxis(Yaw) / 360.f * 256.f) & 0xFF);
+		}
+	}
+}
+
+void AEscapeeCrowd::OnRep_Agents()
+{
+	const int32 Num = Replicated_Agents.Num();
+
+	// Carry on from wherever agents are drawn now
+	if (DrawnTo.Num() == Num)
+	{
+		const float Alpha = FMath::Clamp(DrawnBlendTime * NetUpdateFrequency, 0.f, 1.f);
+		for (int32 i = 0; i < Num; i++)
+		{
+			DrawnFrom[i] = FMath::Lerp(DrawnFrom[i], DrawnTo[i], Alpha);
+		}
+	}
+	DrawnTo.SetNumUninitialized(Num);
+	DrawnYaw.SetNumUninitialized(Num);
+
+	const FVector Origin = GetActorLocation();
+	for (int32 i = 0; i < Num; i++)
+	{
+		const FPPCrowdAgentNet& Agent = Replicated_Agents[i];
+		DrawnTo[i] = Origin + FVector(Agent.X, Agent.Y, Agent.Z) * QuantizationStep;
+		DrawnYaw[i] = Agent.Yaw * (360.f / 256.f);
+	}
+	if (DrawnFrom.Num() != Num)
+	{
+		DrawnFrom = DrawnTo;
+	}
+	DrawnBlendTime = 0.f;
+}
+
+#pragma endregion Replication
+
+#pragma region Drawing
+
+void AEscapeeCrowd::UpdateInstances(float DeltaSeconds)
+{
+	if (GetNetMode() == NM_DedicatedServer || nullptr == Instances->GetStaticMesh())
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_PPCrowdInstances);
+
+	const int32 Num = Replicated_Agents.Num();
+	if (Instances->GetInstanceCount() != Num)
+	{
+		Instances->ClearInstances();
+		for (int32 i = 0; i < Num; i++)
+		{
+			Instances->AddInstanceWorldSpace(FTransform(GetActorLocation()));
+		}
+	}
+
+	// The server draws the simulation, clients blend between updates
+	const bool bUseSimulation = HasAuthority() && Positions.Num() == Num;
+	DrawnBlendTime += DeltaSeconds;
+	const float Alpha = FMath::Clamp(DrawnBlendTime * NetUpdateFrequency, 0.f, 1.f);
+
+	// Only clients get yaw from replication, the server faces agents the way they are moving
+	if (bUseSimulation)
+	{
+		DrawnYaw.SetNumZeroed(Num, false);
+		for (int32 i = 0; i < Num; i++)
+		{
+			if (!Velocities[i].IsNearlyZero(1.f))
+			{
+				DrawnYaw[i] = FMath::RadiansToDegrees(FMath::Atan2(Velocities[i].Y, Velocities[i].X));
+			}
+		}
+	}
+
+	for (int32 i = 0; i < Num; i++)
+	{
+		FTransform Transform;
+		if (!Replicated_Agents[i].bActive)
+		{
+			Transform.SetScale3D(FVector::ZeroVector);
+		}
+		else
+		{
+			Transform.SetLocation(bUseSimulation ? Positions[i] : FMath::Lerp(DrawnFrom[i], DrawnTo[i], Alpha));
+			Transform.SetRotation(FRotator(0.f, DrawnYaw.IsValidIndex(i) ? DrawnYaw[i] : 0.f, 0.f).Quaternion());
+		}
+		// One render state update for the lot, on the last instance
+		Instances->UpdateInstanceTransform(i, Transform, true, i == Num - 1, true);
+	}
+}
+
+#pragma endregion Drawing
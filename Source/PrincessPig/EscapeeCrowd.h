@@ -0,0 +1,184 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "EscapeeCrowd.generated.h"
+
+class USceneComponent;
+class UInstancedStaticMeshComponent;
+class APrincessPigCharacter;
+class AEscapee;
+
+/** One crowd agent as replicated, relative to the crowd, in QuantizationStep units */
+USTRUCT()
+struct FPPCrowdAgentNet
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	int16 X;
+
+	UPROPERTY()
+	int16 Y;
+
+	UPROPERTY()
+	int16 Z;
+
+	/** Yaw in 256ths of a turn */
+	UPROPERTY()
+	uint8 Yaw;
+
+	/** Still part of the crowd, rather than promoted to an escapee */
+	UPROPERTY()
+	bool bActive;
+
+	FPPCrowdAgentNet()
+		: X(0)
+		, Y(0)
+		, Z(0)
+		, Yaw(0)
+		, bActive(false)
+	{}
+};
+
+/**
+ * A crowd of background escapees, simulated as plain data and drawn as mesh instances.
+ *
+ * The server keeps every agent's state in flat arrays, wanders each one between points it
+ * can walk straight to on the navmesh, keeps them apart, and sends them fleeing from guards
+ * and players. Positions replicate a few times a second, quantized, and clients interpolate.
+ *
+ * Agents have no collision, perception or behavior tree. As soon as a player comes close
+ * enough to interact, or one is in front of a guard close enough to be seen, it is promoted:
+ * an EscapeeClass is spawned in its place and the agent leaves the crowd for good.
+ */
+UCLASS()
+class PRINCESSPIG_API AEscapeeCrowd : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AEscapeeCrowd();
+
+	virtual void BeginPlay() override;
+	virtual void Tick(float DeltaSeconds) override;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Crowd")
+	UInstancedStaticMeshComponent* Instances;
+
+	/** Spawned in place of an agent when it is promoted */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Crowd")
+	TSubclassOf<AEscapee> EscapeeClass;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Crowd")
+	int32 NumAgents;
+
+	/** Agents start at random points this far from the crowd actor */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Crowd")
+	float SpawnRadius;
+
+	/** How far an agent wanders to its next point */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Crowd")
+	float WanderRadius;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Crowd")
+	float WalkSpeed;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Crowd")
+	float FleeSpeed;
+
+	/** Agents keep at least this far apart */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Crowd")
+	float SeparationRadius;
+
+	/** Agents run from guards and players closer than this */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Crowd")
+	float FleeRadius;
+
+	/** Players closer than this could interact, so the agent becomes an escapee */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Crowd")
+	float PlayerPromotionRadius;
+
+	/** Guards closer than this, and facing the agent, could see it, so the agent becomes an escapee */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Crowd")
+	float GuardPromotionRadius;
+
+	/** Half angle of a guard's view, in degrees */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Crowd")
+	float GuardPromotionAngle;
+
+	/** Navmesh queries for new wander points allowed per frame, the rest wait their turn */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Crowd")
+	int32 MaxNavQueriesPerTick;
+
+	/** Escapees spawned per check at most, so a guard turning to face the crowd doesn't hitch */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Crowd")
+	int32 MaxPromotionsPerCheck;
+
+	/** Size of one replicated position step. Agents must stay within 32767 steps of the crowd actor */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Crowd")
+	float QuantizationStep;
+
+	/** Server only. Turn agent Index into an escapee. Returns null if it was already promoted */
+	UFUNCTION(BlueprintCallable, Category = "Crowd")
+	AEscapee* PromoteAgent(int32 Index);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Crowd")
+	int32 GetNumActiveAgents() const;
+
+protected:
+	UPROPERTY(ReplicatedUsing = OnRep_Agents)
+	TArray<FPPCrowdAgentNet> Replicated_Agents;
+
+	UFUNCTION()
+	void OnRep_Agents();
+
+	/** Server simulation state, one entry per agent */
+	TArray<FVector> Positions;
+	TArray<FVector2D> Velocities;
+	TArray<FVector> Targets;
+	TArray<float> WaitTimes;
+	TArray<uint8> Fleeing;
+	TArray<uint8> Active;
+	TArray<uint8> NeedsTarget;
+
+	/** Where guards and players are this frame */
+	struct FPPCrowdThreat
+	{
+		FVector Location;
+		FVector Forward;
+		bool bIsGuard;
+	};
+	TArray<FPPCrowdThreat> Threats;
+
+	/** Agent indices sorted by cell, for separation */
+	TArray<int32> SortedAgents;
+	TArray<uint64> AgentCells;
+	TMap<uint64, int32> CellStarts;
+
+	/** Where agents are drawn on this machine, for interpolating between updates on clients */
+	TArray<FVector> DrawnFrom;
+	TArray<FVector> DrawnTo;
+	TArray<float> DrawnYaw;
+	float DrawnBlendTime;
+
+	/** Next agent to look at for a new target, so everyone gets a turn */
+	int32 NextTargetQuery;
+
+	float TimeSinceNetWrite;
+	float TimeSincePromotionCheck;
+
+	void SpawnAgents();
+	void GatherThreats();
+	void BuildGrid();
+	void Simulate(float DeltaSeconds);
+	void UpdateTargets();
+	bool FindTarget(int32 Index, const FVector& Origin, float Radius);
+	void CheckPromotions();
+	void WriteNetState();
+	void UpdateInstances(float DeltaSeconds);
+
+	uint64 GetCellKey(int32 X, int32 Y) const { return ((uint64)(uint32)X << 32) | (uint32)Y; }
+};
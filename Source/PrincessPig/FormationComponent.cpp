@@ -0,0 +1,266 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "FormationComponent.h"
+#include "PrincessPig.h"
+#include "PrincessPigCharacter.h"
+#include "LeaderTrailComponent.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Engine/World.h"
+#include "NavigationSystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Formation Build"), STAT_PPFormationBuild, STATGROUP_PrincessPig);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Formation Builds"), STAT_PPFormationBuilds, STATGROUP_PrincessPig);
+
+UFormationComponent::UFormationComponent()
+{
+	// Only ticks while there are followers
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	PrimaryComponentTick.TickGroup = TG_PostPhysics;
+	PrimaryComponentTick.TickInterval = 0.1f;
+
+	Shape = EPPFormationShape::Blob;
+	SlotSpacing = 110.f;
+	FirstRowDistance = 150.f;
+	MaxRowWidth = 450.f;
+	RebuildDistance = 50.f;
+	FollowerAvoidanceRadius = 60.f;
+
+	Trail = nullptr;
+	LastBuildLocation = FVector::ZeroVector;
+	bSlotsDirty = false;
+}
+
+void UFormationComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Build after the trail has recorded this frame's crumb
+	Trail = GetOwner()->FindComponentByClass<ULeaderTrailComponent>();
+	if (Trail)
+	{
+		AddTickPrerequisiteComponent(Trail);
+	}
+}
+
+void UFormationComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// The leader is going away with followers still in slots, so they won't leave through AssignSlots
+	for (auto& Pair : SavedAvoidanceRadii)
+	{
+		APrincessPigCharacter* Follower = Pair.Key.Get();
+		if (Follower && Follower->GetCharacterMovement())
+		{
+			Follower->GetCharacterMovement()->AvoidanceConsiderationRadius = Pair.Value;
+		}
+	}
+	SavedAvoidanceRadii.Reset();
+	SlotFollowers.Reset();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UFormationComponent::SetShape(EPPFormationShape NewShape)
+{
+	if (Shape != NewShape)
+	{
+		Shape = NewShape;
+		bSlotsDirty = true;
+	}
+}
+
+void UFormationComponent::NotifyFollowersChanged()
+{
+	AActor* Owner = GetOwner();
+	if (nullptr == Owner || !Owner->HasAuthority())
+	{
+		return;
+	}
+
+	AssignSlots();
+	SetComponentTickEnabled(SlotFollowers.Num() > 0);
+}
+
+void UFormationComponent::AssignSlots()
+{
+	APrincessPigCharacter* Leader = Cast<APrincessPigCharacter>(GetOwner());
+	if (nullptr == Leader)
+	{
+		return;
+	}
+
+	// Give back the avoidance radius of anyone who left
+	for (auto It = SavedAvoidanceRadii.CreateIterator(); It; ++It)
+	{
+		APrincessPigCharacter* Follower = It.Key().Get();
+		if (nullptr == Follower || !Leader->Followers.Contains(Follower))
+		{
+			if (Follower)
+			{
+				Follower->GetCharacterMovement()->AvoidanceConsiderationRadius = It.Value();
+			}
+			It.RemoveCurrent();
+		}
+	}
+
+	// Nearest follower gets the nearest slot, so nobody has to cross the group to reach theirs
+	TArray<APrincessPigCharacter*> SortedFollowers;
+	for (APrincessPigCharacter* Follower : Leader->Followers)
+	{
+		if (Follower)
+		{
+			SortedFollowers.Add(Follower);
+		}
+	}
+	const FVector LeaderLocation = Leader->GetActorLocation();
+	SortedFollowers.Sort([&LeaderLocation](const APrincessPigCharacter& A, const APrincessPigCharacter& B)
+	{
+		return FVector::DistSquared(A.GetActorLocation(), LeaderLocation) < FVector::DistSquared(B.GetActorLocation(), LeaderLocation);
+	});
+
+	SlotFollowers.Reset(SortedFollowers.Num());
+	for (APrincessPigCharacter* Follower : SortedFollowers)
+	{
+		SlotFollowers.Add(Follower);
+
+		if (!SavedAvoidanceRadii.Contains(Follower))
+		{
+			UCharacterMovementComponent* Movement = Follower->GetCharacterMovement();
+			SavedAvoidanceRadii.Add(Follower, Movement->AvoidanceConsiderationRadius);
+			Movement->AvoidanceConsiderationRadius = FollowerAvoidanceRadius;
+		}
+	}
+
+	bSlotsDirty = true;
+}
+
+void UFormationComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (bSlotsDirty || FVector::DistSquared(GetOwner()->GetActorLocation(), LastBuildLocation) > FMath::Square(RebuildDistance))
+	{
+		BuildSlots();
+	}
+}
+
+void UFormationComponent::GetTrailFrame(float Distance, FVector& OutLocation, FVector& OutForward) const
+{
+	if (nullptr == Trail)
+	{
+		OutForward = GetOwner()->GetActorForwardVector();
+		OutLocation = GetOwner()->GetActorLocation() - OutForward * Distance;
+		return;
+	}
+
+	FVector Ahead;
+	Trail->GetPointBehind(FMath::Max(Distance - SlotSpacing * 0.5f, 0.f), Ahead);
+	Trail->GetPointBehind(Distance, OutLocation);
+	OutForward = (Ahead - OutLocation).GetSafeNormal2D();
+	if (OutForward.IsNearlyZero())
+	{
+		OutForward = GetOwner()->GetActorForwardVector();
+	}
+}
+
+void UFormationComponent::MeasureRowWidth(const FVector& Location, const FVector& Right, float& OutLeft, float& OutRight) const
+{
+	const float HalfWidth = MaxRowWidth * 0.5f;
+	OutLeft = HalfWidth;
+	OutRight = HalfWidth;
+
+	FVector HitLocation;
+	if (UNavigationSystemV1::NavigationRaycast(GetOwner(), Location, Location + Right * HalfWidth, HitLocation))
+	{
+		OutRight = FVector::Dist2D(Location, HitLocation);
+	}
+	if (UNavigationSystemV1::NavigationRaycast(GetOwner(), Location, Location - Right * HalfWidth, HitLocation))
+	{
+		OutLeft = FVector::Dist2D(Location, HitLocation);
+	}
+}
+
+void UFormationComponent::BuildSlots()
+{
+	SCOPE_CYCLE_COUNTER(STAT_PPFormationBuild);
+	INC_DWORD_STAT(STAT_PPFormationBuilds);
+
+	bSlotsDirty = false;
+	LastBuildLocation = GetOwner()->GetActorLocation();
+
+	const int32 NumSlots = SlotFollowers.Num();
+	SlotLocations.SetNumUninitialized(NumSlots);
+
+	// Keep a little clear of the walls
+	const float Margin = SlotSpacing * 0.5f;
+
+	int32 Slot = 0;
+	int32 Row = 0;
+	while (Slot < NumSlots)
+	{
+		FVector RowCentre;
+		FVector Forward;
+		GetTrailFrame(FirstRowDistance + Row * SlotSpacing, RowCentre, Forward);
+		const FVector Right = FVector::CrossProduct(FVector::UpVector, Forward);
+
+		// Room either side of the trail. A column never leaves it, so doesn't need to look
+		float LeftWidth = 0.f;
+		float RightWidth = 0.f;
+		if (Shape != EPPFormationShape::Column)
+		{
+			MeasureRowWidth(RowCentre, Right, LeftWidth, RightWidth);
+			LeftWidth = FMath::Max(LeftWidth - Margin, 0.f);
+			RightWidth = FMath::Max(RightWidth - Margin, 0.f);
+		}
+
+		// Lateral offsets in this row, relative to the trail
+		TArray<float, TInlineAllocator<8>> Offsets;
+		switch (Shape)
+		{
+		case EPPFormationShape::Column:
+			Offsets.Add(0.f);
+			break;
+
+		case EPPFormationShape::Vee:
+			// One either side, spreading out a little more each row until the walls close it up
+			Offsets.Add(FMath::Min((Row + 1) * SlotSpacing * 0.5f, RightWidth));
+			Offsets.Add(-FMath::Min((Row + 1) * SlotSpacing * 0.5f, LeftWidth));
+			break;
+
+		case EPPFormationShape::Blob:
+		default:
+		{
+			// As many as fit, centred in the free space
+			const int32 NumInRow = FMath::Max(1, FMath::FloorToInt((LeftWidth + RightWidth) / SlotSpacing) + 1);
+			const float RowCentreOffset = (RightWidth - LeftWidth) * 0.5f;
+			for (int32 i = 0; i < NumInRow; i++)
+			{
+				Offsets.Add(RowCentreOffset + (i - (NumInRow - 1) * 0.5f) * SlotSpacing);
+			}
+
+			// Middle first, so a short last row stays on the trail
+			Offsets.Sort([RowCentreOffset](float A, float B) { return FMath::Abs(A - RowCentreOffset) < FMath::Abs(B - RowCentreOffset); });
+			break;
+		}
+		}
+
+		for (int32 i = 0; i < Offsets.Num() && Slot < NumSlots; i++, Slot++)
+		{
+			SlotLocations[Slot] = RowCentre + Right * Offsets[i];
+		}
+		Row++;
+	}
+}
+
+bool UFormationComponent::GetSlotLocation(const APrincessPigCharacter* Follower, FVector& OutLocation) const
+{
+	for (int32 Slot = 0; Slot < SlotFollowers.Num() && Slot < SlotLocations.Num(); Slot++)
+	{
+		if (SlotFollowers[Slot].Get() == Follower)
+		{
+			OutLocation = SlotLocations[Slot];
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,97 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "FormationComponent.generated.h"
+
+class APrincessPigCharacter;
+class ULeaderTrailComponent;
+
+UENUM(BlueprintType)
+enum class EPPFormationShape : uint8
+{
+	/** Single file along the trail */
+	Column UMETA(DisplayName = "Column"),
+	/** Widening rows either side of the trail */
+	Vee UMETA(DisplayName = "Vee"),
+	/** Rows as wide as the corridor allows */
+	Blob UMETA(DisplayName = "Blob")
+};
+
+/**
+ * Gives each of a leader's followers its own spot to walk to, so they don't all chase the
+ * same point and leave avoidance to push them apart.
+ *
+ * Server only. Slots are laid out along the owner's ULeaderTrailComponent, so the formation
+ * bends round corners, and are all rebuilt together whenever the owner has moved
+ * RebuildDistance or its followers change. Followers are given slots nearest first.
+ */
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class PRINCESSPIG_API UFormationComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UFormationComponent();
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Formation")
+	EPPFormationShape Shape;
+
+	/** Distance between neighbouring slots */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Formation")
+	float SlotSpacing;
+
+	/** Distance along the trail from the leader to the first row */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Formation")
+	float FirstRowDistance;
+
+	/** Blob rows are never wider than this, even in the open */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Formation")
+	float MaxRowWidth;
+
+	/** How far the leader moves before the slots are rebuilt */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Formation")
+	float RebuildDistance;
+
+	/** Followers only need to avoid their neighbours while they have a slot */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Formation")
+	float FollowerAvoidanceRadius;
+
+	UFUNCTION(BlueprintCallable, Category = "Formation")
+	void SetShape(EPPFormationShape NewShape);
+
+	/** Called by the owner when its followers change */
+	void NotifyFollowersChanged();
+
+	/** Where Follower should be. Returns false if it doesn't have a slot */
+	bool GetSlotLocation(const APrincessPigCharacter* Follower, FVector& OutLocation) const;
+
+protected:
+	UPROPERTY(Transient)
+	ULeaderTrailComponent* Trail;
+
+	/** Follower in each slot, and where that slot is */
+	TArray<TWeakObjectPtr<APrincessPigCharacter>> SlotFollowers;
+	TArray<FVector> SlotLocations;
+
+	/** Followers' own avoidance radii, put back when they leave */
+	TMap<TWeakObjectPtr<APrincessPigCharacter>, float> SavedAvoidanceRadii;
+
+	FVector LastBuildLocation;
+	bool bSlotsDirty;
+
+	void AssignSlots();
+	void BuildSlots();
+
+	/** Point Distance back along the trail, and the direction the trail runs there */
+	void GetTrailFrame(float Distance, FVector& OutLocation, FVector& OutForward) const;
+
+	/** Free width either side of Location across Right, up to MaxRowWidth */
+	void MeasureRowWidth(const FVector& Location, const FVector& Right, float& OutLeft, float& OutRight) const;
+};
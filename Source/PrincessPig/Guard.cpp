@@ -4,7 +4,8 @@
 #include "GameFramework/CharacterMovementComponent.h"
 
 
-AGuard::AGuard()
+AGuard::AGuard(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
 {
 	// Configure avoidance group
 	FNavAvoidanceMask DefaultAvoidanceGroup;
@@ -32,8 +33,14 @@ AGuard::AGuard()
 	GetCharacterMovement()->RotationRate = FRotator(0.f, 500.f, 0.f);
 
 
+	// Waiting guards barely change, chasing guards need to look responsive
+	NetUpdatePolicy.ActiveFrequency = 30.f;
+	NetUpdatePolicy.IdleFrequency = 4.f;
+
 	SetGenericTeamId(FGenericTeamId(1));
 	Tags.AddUnique(FName("Guard"));
+
+	bUseNativeStateMachine = false;
 }
 
 
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "PrincessPigCharacter.h"
+#include "GuardStateMachine.h"
 #include "Guard.generated.h"
 
 class UBehaviorTree;
@@ -17,5 +18,12 @@ class PRINCESSPIG_API AGuard : public APrincessPigCharacter
 	GENERATED_BODY()
 
 public:
-	AGuard();
+	AGuard(const FObjectInitializer& ObjectInitializer);
+
+	/** Run this guard with the native state machine instead of BehaviorTree */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "AI")
+	bool bUseNativeStateMachine;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "AI", meta = (EditCondition = "bUseNativeStateMachine"))
+	FPPGuardStateMachineSettings StateMachineSettings;
 };
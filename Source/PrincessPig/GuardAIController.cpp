@@ -2,15 +2,22 @@
 
 #include "GuardAIController.h"
 #include "PrincessPigCharacter.h"
+#include "PPCharacterMovementComponent.h"
 #include "Guard.h"
 #include "PatrolPoint.h"
 #include "PatrolRoute.h"
 #include "Objective.h"
 #include "InteractionComponent.h"
+#include "SmokeGrid.h"
+#include "GuardObjectiveStage.h"
+#include "CharacterRegistry.h"
+#include "NavQueryService.h"
+#include "PrincessPig.h"
 
 #include "BehaviorTree/BlackboardComponent.h"
 #include "BehaviorTree/BehaviorTreeComponent.h"
 #include "BehaviorTree/BehaviorTree.h"
+#include "BehaviorTree/BTNode.h"
 #include "Perception/AIPerceptionComponent.h"
 #include "Perception/AISenseConfig_Sight.h"
 #include "Perception/AISenseConfig_Hearing.h"
@@ -65,6 +72,11 @@ AGuardAIController::AGuardAIController()
 	TargetActorKey = "TargetActor";
 	ObjectiveTypeKey = "ObjectiveType";
 	ObjectiveLocationKey = "ObjectiveLocation";
+
+	bUsingStateMachine = false;
+	LastTracedNode = nullptr;
+	bObjectiveUpdatedByStage = false;
+	PawnRegistryIndex = INDEX_NONE;
 }
 
 void AGuardAIController::Possess(APawn* Pawn)
@@ -88,19 +100,44 @@ void AGuardAIController::Possess(APawn* Pawn)
 	}
 
 
-	// Start up blackboard and behavior tree
-	if (PPCharacter->BehaviorTree->BlackboardAsset)
+	// Start up the native state machine, or blackboard and behavior tree
+	AGuard* Guard = Cast<AGuard>(PPCharacter);
+	bUsingStateMachine = Guard && Guard->bUseNativeStateMachine;
+	if (bUsingStateMachine)
+	{
+		StateMachine.Start(this);
+	}
+	else
 	{
-		BlackboardComp->InitializeBlackboard(*(PPCharacter->BehaviorTree->BlackboardAsset));
+		if (PPCharacter->BehaviorTree->BlackboardAsset)
+		{
+			BlackboardComp->InitializeBlackboard(*(PPCharacter->BehaviorTree->BlackboardAsset));
+		}
+		BehaviorTreeComp->StartTree(*PPCharacter->BehaviorTree);
 	}
-	BehaviorTreeComp->StartTree(*PPCharacter->BehaviorTree);
 
 	// Get this guard's team
 	SetGenericTeamId(PPCharacter->GetGenericTeamId());
 
+	// Queue navigation queries rather than running them on the spot
+	NavQueryService = ANavQueryService::GetNavQueryService(this);
+
+	// Check the objective along with every other guard
+	AGuardObjectiveStage* ObjectiveStage = AGuardObjectiveStage::GetGuardObjectiveStage(this);
+	if (ObjectiveStage)
+	{
+		ObjectiveStage->RegisterGuard(this);
+
+		// Tick after the stage has applied this frame's objective update
+		AddTickPrerequisiteActor(ObjectiveStage);
+	}
+
 	// Use collision avoidance
 	PPCharacter->SetCollisionAvoidanceEnabled(true);
 
+	// Walk on the navmesh when there is nothing around to bump into
+	PPCharacter->GetPPCharacterMovement()->SetNavWalkingAllowed(true);
+
 	// Configure avoidance group (0 for guards)
 	FNavAvoidanceMask DefaultAvoidanceGroup;
 	DefaultAvoidanceGroup.ClearAll();
@@ -115,15 +152,83 @@ void AGuardAIController::Possess(APawn* Pawn)
 
 }
 
+void AGuardAIController::UnPossess()
+{
+	AGuardObjectiveStage* ObjectiveStage = AGuardObjectiveStage::FindGuardObjectiveStage(this);
+	if (ObjectiveStage)
+	{
+		ObjectiveStage->UnregisterGuard(this);
+		RemoveTickPrerequisiteActor(ObjectiveStage);
+	}
+
+	if (bUsingStateMachine)
+	{
+		StateMachine.Stop(this);
+		bUsingStateMachine = false;
+	}
+
+	if (ANavQueryService* NavQueries = NavQueryService.Get())
+	{
+		NavQueries->CancelMove(this);
+	}
+
+	Super::UnPossess();
+}
+
+void AGuardAIController::StopMovement()
+{
+	if (ANavQueryService* NavQueries = NavQueryService.Get())
+	{
+		NavQueries->CancelMove(this);
+	}
+
+	Super::StopMovement();
+}
+
 void AGuardAIController::Tick(float DeltaSeconds)
 {
 	Super::Tick(DeltaSeconds);
 
-	// Some objectives (like Chase) require updates every frame
+	// Some objectives (like Chase) require updates every frame, usually for all guards at once
+	if (!bObjectiveUpdatedByStage)
+	{
+		UpdateObjective();
+	}
+
+	if (bUsingStateMachine)
+	{
+		StateMachine.Tick(this, DeltaSeconds);
+	}
+	else if (UE_LOG_ACTIVE(LogPrincessPig, Verbose))
+	{
+		// Trace active task changes, to compare against the state machine's transitions
+		const UBTNode* ActiveNode = BehaviorTreeComp->GetActiveNode();
+		if (ActiveNode != LastTracedNode)
+		{
+			LastTracedNode = ActiveNode;
+			UE_LOG(LogPrincessPig, Verbose, TEXT("%s task %s"), *GetName(), ActiveNode ? *ActiveNode->GetNodeName() : TEXT("None"));
+		}
+	}
+
+	//DebugShowObjective();
+
+
+	// Show focus
+	//if (GetFocusActor())
+	//{
+	//	DrawDebugLine(GetWorld(), GetFocusActor()->GetActorLocation(), GetPawn()->GetActorLocation(), FColor::Green, false, 0, 0, 5.f);
+	//}
+
+}
+
+void AGuardAIController::UpdateObjective()
+{
 	if (CurrentObjective)
 	{
-		// Line of sight should be immediately invalidated
-		if (!LineOfSightTo(CurrentObjective->TargetActor) || IsVisionImpaired())
+		// Line of sight should be immediately invalidated. Smoke is much cheaper to check than the trace
+		if (IsVisionImpaired() || 
+			IsSightObscuredBySmoke(CurrentObjective->TargetActor) || 
+			!LineOfSightTo(CurrentObjective->TargetActor))
 		{
 			bObjectiveInSight = false;
 		}
@@ -132,7 +237,7 @@ void AGuardAIController::Tick(float DeltaSeconds)
 		if (CurrentObjective->Type == EObjectiveType::Chase && bObjectiveInSight)
 		{
 			CurrentObjective->Refresh();
-			PursuitLocation = GetObjectivePursuitLocation();
+			RefreshPursuitLocation();
 		}
 
 		// Check the status of the objective target (might be dead, disappeared etc)
@@ -162,16 +267,37 @@ void AGuardAIController::Tick(float DeltaSeconds)
 			}
 		}
 	}
+}
 
-	//DebugShowObjective();
+void AGuardAIController::ApplyObjectiveCommand(const FPPGuardObjectiveCommand& Command)
+{
+	if (nullptr == CurrentObjective)
+	{
+		return;
+	}
 
+	if (Command.bLoseSight)
+	{
+		bObjectiveInSight = false;
+	}
 
-	// Show focus
-	//if (GetFocusActor())
-	//{
-	//	DrawDebugLine(GetWorld(), GetFocusActor()->GetActorLocation(), GetPawn()->GetActorLocation(), FColor::Green, false, 0, 0, 5.f);
-	//}
+	if (Command.bRefreshPursuit)
+	{
+		CurrentObjective->SetLastKnown(Command.TargetLocation, Command.TargetVelocity);
+		RefreshPursuitLocation();
+	}
 
+	// Same order as UpdateObjective
+	if (Command.bDowngrade)
+	{
+		DowngradeObjectiveToSearch();
+	}
+
+	if (Command.bTargetDied)
+	{
+		CurrentObjective->SetObjectiveType(EObjectiveType::Search);
+		CheckCurrentLineOfSight();
+	}
 }
 
 #pragma region Perception
@@ -190,7 +316,7 @@ void AGuardAIController::RespondToPerceptionUpdated(const TArray<AActor*>& Updat
 			switch (Stimulus.Type.Index)
 			{
 			case 0: // sight
-				if (Stimulus.IsActive() && !IsVisionImpaired())
+				if (Stimulus.IsActive() && !IsVisionImpaired() && !IsSightObscuredBySmoke(Actor))
 				{
 					OnActorSeen.Broadcast(Actor);
 				}
@@ -338,7 +464,7 @@ void AGuardAIController::CheckCurrentLineOfSight()
 				Stimulus.IsExpired() )
 				continue;
 
-			if (Stimulus.Type.Index == 0) // 0 refers to sight
+			if (Stimulus.Type.Index == 0 && !IsSightObscuredBySmoke(Actor)) // 0 refers to sight
 			{ 
 				OnActorSeen.Broadcast(Actor);
 			}
@@ -349,6 +475,12 @@ void AGuardAIController::CheckCurrentLineOfSight()
 
 bool AGuardAIController::IsVisionImpaired() 
 {
+	int32 Index;
+	if (const ACharacterRegistry* Registry = ACharacterRegistry::FindSlot(GetPawn(), Index))
+	{
+		return Registry->HasAnyStatus(Index, EPPCharacterStatus::VisionImpaired);
+	}
+
 	APrincessPigCharacter* PPCharacter = Cast<APrincessPigCharacter>(GetPawn());
 	if (PPCharacter) 
 	{
@@ -362,6 +494,15 @@ bool AGuardAIController::IsVisionImpaired()
 	return false;
 }
 
+bool AGuardAIController::IsSightObscuredBySmoke(AActor* Actor) const
+{
+	if (nullptr == Actor || nullptr == GetPawn())
+	{
+		return false;
+	}
+	return ASmokeGrid::IsSightBlockedBySmoke(this, GetPawn()->GetPawnViewLocation(), Actor->GetActorLocation());
+}
+
 
 bool AGuardAIController::IsHearingImpaired()
 {
@@ -385,7 +526,7 @@ bool AGuardAIController::ShouldSetNewObjective(EObjectiveType NewType, AActor* N
 {
 	if (NewTargetActor && !NewTargetActor->IsPendingKillPending())
 	{
-		bool NewObjectiveIsCloser = GetObjectiveDistance() > FVector::Distance(GetPawn()->GetActorLocation(), NewTargetActor->GetActorLocation());
+		bool NewObjectiveIsCloser = GetObjectiveDistance() > FVector::Distance(ACharacterRegistry::GetLocationOf(GetPawn()), ACharacterRegistry::GetLocationOf(NewTargetActor));
 
 		if (!CurrentObjective ||
 			!CurrentObjective->TargetActor ||
@@ -436,7 +577,8 @@ float AGuardAIController::GetObjectiveDistance()
 
 void AGuardAIController::WriteObjectiveToBlackboard()
 {
-	if (CurrentObjective)
+	// The state machine reads the objective directly
+	if (CurrentObjective && !bUsingStateMachine)
 	{
 		// Write objective location
 		if (CurrentObjective->Type == EObjectiveType::Chase)
@@ -466,6 +608,30 @@ FVector AGuardAIController::GetObjectivePursuitLocation()
 		return FVector(0, 0, 0);
 	}
 
+	FVector PursuitLocation = GetUnprojectedPursuitLocation();
+
+	// Project to navigation
+	FNavLocation NavigableLocation;
+	if (UNavigationSystemV1::GetNavigationSystem(this)->ProjectPointToNavigation(PursuitLocation, NavigableLocation))
+	{
+		PursuitLocation = NavigableLocation.Location;
+	}
+	else
+	{
+		PursuitLocation = CurrentObjective->GetLastKnownLocation();
+
+	}
+
+	return PursuitLocation;
+}
+
+FVector AGuardAIController::GetUnprojectedPursuitLocation()
+{
+	if (!CurrentObjective)
+	{
+		return FVector(0, 0, 0);
+	}
+
 	float TimeToReachTarget = GetEstimatedTimeToReach(CurrentObjective->GetLastKnownLocation(), INFINITY);
 
 	FVector PursuitLocation = CurrentObjective->GetExtrapolatedLocation(TimeToReachTarget);
@@ -483,23 +649,41 @@ FVector AGuardAIController::GetObjectivePursuitLocation()
 		PursuitLocation = Hit.ImpactPoint + Hit.ImpactNormal * SafetyBufferDistance;
 	}
 
-	// Project to navigation
-	FNavLocation NavigableLocation;
-	if (UNavigationSystemV1::GetNavigationSystem(this)->ProjectPointToNavigation(PursuitLocation, NavigableLocation))
+	return PursuitLocation;
+}
+
+void AGuardAIController::RefreshPursuitLocation()
+{
+	ANavQueryService* NavQueries = NavQueryService.Get();
+	if (nullptr == NavQueries || nullptr == CurrentObjective)
 	{
-		PursuitLocation = NavigableLocation.Location;
+		PursuitLocation = GetObjectivePursuitLocation();
+		return;
 	}
-	else
-	{
-		PursuitLocation = CurrentObjective->GetLastKnownLocation();
 
-	}
+	// Keep heading for the old pursuit location until the new one is projected
+	NavQueries->RequestProjection(this, GetUnprojectedPursuitLocation(),
+		FPPNavProjectionDelegate::CreateUObject(this, &AGuardAIController::OnPursuitLocationProjected));
+}
 
-	return PursuitLocation;
+void AGuardAIController::OnPursuitLocationProjected(bool bSuccess, const FVector& Location)
+{
+	// Too late if the chase is over
+	if (CurrentObjective && CurrentObjective->Type == EObjectiveType::Chase)
+	{
+		PursuitLocation = bSuccess ? Location : CurrentObjective->GetLastKnownLocation();
+	}
 }
 
 float AGuardAIController::GetEstimatedTimeToReach(FVector Location, float MaxEstimate)
 {
+	int32 Index;
+	if (const ACharacterRegistry* Registry = ACharacterRegistry::FindSlot(GetPawn(), Index))
+	{
+		const float MaxSpeed = Registry->GetMaxSpeed(Index);
+		return MaxSpeed > 0 ? fminf(MaxEstimate, FVector::Distance(Registry->GetLocation(Index), Location) / MaxSpeed) : 0;
+	}
+
 	if (GetPawn() && 
 		GetPawn()->GetMovementComponent() &&
 		GetPawn()->GetMovementComponent()->GetMaxSpeed() > 0)
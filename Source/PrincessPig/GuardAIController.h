@@ -6,13 +6,17 @@
 #include "AIController.h"
 
 #include "Objective.h"
+#include "GuardStateMachine.h"
 #include "Perception/AISenseConfig_Sight.h"
 #include "Perception/AISenseConfig_Hearing.h"
 #include "GuardAIController.generated.h"
 
 class UBehaviorTreeComponent;
+class UBTNode;
+struct FPPGuardObjectiveCommand;
 class UBlackboardComponent;
 class UAIPerceptionComponent;
+class ANavQueryService;
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FActorSeenDelegate, AActor*, Actor);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FActorSightLostDelegate, AActor*, Actor);
@@ -34,12 +38,41 @@ public:
 	virtual void Tick(float DeltaSeconds) override;
 
 	virtual void Possess(APawn* Pawn) override;
+	virtual void UnPossess() override;
 
 	UBehaviorTreeComponent* BehaviorTreeComp;
 	UBlackboardComponent* BlackboardComp;
 	FORCEINLINE UBlackboardComponent* GetBlackboardComp() const { return BlackboardComp; };
 
 
+#pragma region StateMachine
+
+	/** Set on Possess for guards with bUseNativeStateMachine, in which case the behavior tree never starts */
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "AI")
+	bool bUsingStateMachine;
+
+	FPPGuardStateMachine StateMachine;
+
+	/** Last behavior tree task logged, when tracing */
+	const UBTNode* LastTracedNode;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "AI")
+	EPPGuardState GetGuardState() const { return StateMachine.State; }
+
+#pragma endregion StateMachine
+
+
+#pragma region Navigation
+
+	/** Server only, set on Possess. Pursuit projections and state machine moves are queued here when there is one */
+	TWeakObjectPtr<ANavQueryService> NavQueryService;
+
+	/** Also drops any move still waiting for a path */
+	virtual void StopMovement() override;
+
+#pragma endregion Navigation
+
+
 #pragma region Perception
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Perception")
@@ -86,6 +119,10 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Perception")
 	bool IsVisionImpaired();
 
+	/** Is there enough smoke between our eyes and Actor to hide it? Checked before any trace */
+	UFUNCTION(BlueprintCallable, Category = "Perception")
+	bool IsSightObscuredBySmoke(AActor* Actor) const;
+
 	UFUNCTION(BlueprintCallable, Category = "Perception")
 	bool IsHearingImpaired();
 
@@ -125,12 +162,32 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Objective")
 	virtual FVector GetObjectivePursuitLocation();
 
+	/** Where the target is heading, stopped short of walls but not yet projected to navigation */
+	FVector GetUnprojectedPursuitLocation();
+
+	/** Update PursuitLocation, once the nav query service has projected it if there is one */
+	void RefreshPursuitLocation();
+
+	void OnPursuitLocationProjected(bool bSuccess, const FVector& Location);
+
 	UFUNCTION(BlueprintCallable, Category = "Objective")
 	void ClearObjective();
 
 	UFUNCTION(BlueprintCallable, Category = "Objective")
 	void DowngradeObjectiveToSearch();
 
+	/** Check line of sight to the objective target and whether it is still there. Done by AGuardObjectiveStage when there is one */
+	void UpdateObjective();
+
+	/** Act on the stage's verdict for this frame, see AGuardObjectiveStage */
+	void ApplyObjectiveCommand(const FPPGuardObjectiveCommand& Command);
+
+	/** Set while registered with AGuardObjectiveStage, which then updates the objective instead of Tick */
+	bool bObjectiveUpdatedByStage;
+
+	/** Where the stage last found our pawn in ACharacterRegistry, tried first next frame */
+	int32 PawnRegistryIndex;
+
 	// Delegate functions for objectives
 	UPROPERTY(BlueprintAssignable, Category = "Objective")
 	FObjectiveChangedDelegate OnObjectiveChanged;
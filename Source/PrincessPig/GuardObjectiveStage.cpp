@@ -0,0 +1,245 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "GuardObjectiveStage.h"
+#include "PrincessPig.h"
+#include "GuardAIController.h"
+#include "PrincessPigCharacter.h"
+#include "SmokeGrid.h"
+#include "CharacterRegistry.h"
+#include "WorldActorCache.h"
+#include "Components/SceneComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Async/ParallelFor.h"
+
+DECLARE_CYCLE_STAT(TEXT("Guard Objective Gather"), STAT_PPGuardObjectiveGather, STATGROUP_PrincessPig);
+DECLARE_CYCLE_STAT(TEXT("Guard Objective Evaluate"), STAT_PPGuardObjectiveEvaluate, STATGROUP_PrincessPig);
+DECLARE_CYCLE_STAT(TEXT("Guard Objective Sight Traces"), STAT_PPGuardObjectiveSightTraces, STATGROUP_PrincessPig);
+DECLARE_CYCLE_STAT(TEXT("Guard Objective Apply"), STAT_PPGuardObjectiveApply, STATGROUP_PrincessPig);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Guard Objective Guards"), STAT_PPGuardObjectiveGuards, STATGROUP_PrincessPig);
+
+AGuardObjectiveStage::AGuardObjectiveStage()
+{
+	// Same group the controllers tick in. Each registered controller ticks after us, see AGuardAIController::Possess
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickGroup = TG_PrePhysics;
+
+	bReplicates = false;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>("Root");
+
+	bEnabled = true;
+	MinGuardsForParallel = 32;
+	SmokeGrid = nullptr;
+}
+
+AGuardObjectiveStage* AGuardObjectiveStage::GetGuardObjectiveStage(const UObject* WorldContextObject)
+{
+	if (!GetDefault<AGuardObjectiveStage>()->bEnabled)
+	{
+		return nullptr;
+	}
+
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::ReturnNull);
+	if (nullptr == World || World->IsNetMode(NM_Client))
+	{
+		return nullptr;
+	}
+
+	if (AGuardObjectiveStage* Existing = TPPWorldActorCache<AGuardObjectiveStage>::Find(World))
+	{
+		return Existing;
+	}
+
+	// Cached now as well as in BeginPlay, in case play hasn't begun yet
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.ObjectFlags |= RF_Transient;
+	AGuardObjectiveStage* Stage = World->SpawnActor<AGuardObjectiveStage>(SpawnParams);
+	if (Stage)
+	{
+		TPPWorldActorCache<AGuardObjectiveStage>::Add(Stage);
+	}
+	return Stage;
+}
+
+AGuardObjectiveStage* AGuardObjectiveStage::FindGuardObjectiveStage(const UObject* WorldContextObject)
+{
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::ReturnNull);
+	return TPPWorldActorCache<AGuardObjectiveStage>::Find(World);
+}
+
+void AGuardObjectiveStage::BeginPlay()
+{
+	Super::BeginPlay();
+
+	TPPWorldActorCache<AGuardObjectiveStage>::Add(this);
+}
+
+void AGuardObjectiveStage::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	TPPWorldActorCache<AGuardObjectiveStage>::Remove(this);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AGuardObjectiveStage::RegisterGuard(AGuardAIController* Guard)
+{
+	if (Guard && !Guards.Contains(Guard))
+	{
+		Guards.Add(Guard);
+		Guard->bObjectiveUpdatedByStage = true;
+	}
+}
+
+void AGuardObjectiveStage::UnregisterGuard(AGuardAIController* Guard)
+{
+	const int32 Index = Guards.IndexOfByKey(Guard);
+	if (Index != INDEX_NONE)
+	{
+		Guards[Index] = nullptr;
+		Guard->bObjectiveUpdatedByStage = false;
+	}
+}
+
+void AGuardObjectiveStage::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	Gather();
+
+	const int32 NumGuards = Guards.Num();
+	SET_DWORD_STAT(STAT_PPGuardObjectiveGuards, NumGuards);
+	if (NumGuards == 0)
+	{
+		return;
+	}
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_PPGuardObjectiveEvaluate);
+
+		// Every guard only reads its own input and writes its own command, nothing touches the world
+		ParallelFor(NumGuards, [this](int32 Index)
+		{
+			Evaluate(Index);
+		}, NumGuards < MinGuardsForParallel);
+	}
+
+	TraceSight();
+	Apply();
+}
+
+void AGuardObjectiveStage::Gather()
+{
+	SCOPE_CYCLE_COUNTER(STAT_PPGuardObjectiveGather);
+
+	Guards.RemoveAll([](const TWeakObjectPtr<AGuardAIController>& Guard) { return !Guard.IsValid(); });
+
+	// Found once here, rather than by every guard on a worker
+	SmokeGrid = TPPWorldActorCache<ASmokeGrid>::Find(GetWorld());
+
+	// Guards and objectives remember where they last found their characters, so this is usually a compare
+	const ACharacterRegistry* Registry = TPPWorldActorCache<ACharacterRegistry>::Find(GetWorld());
+
+	const int32 NumGuards = Guards.Num();
+	Inputs.SetNumUninitialized(NumGuards, false);
+	Commands.SetNumZeroed(NumGuards, false);
+	for (int32 i = 0; i < NumGuards; i++)
+	{
+		AGuardAIController* Guard = Guards[i].Get();
+		APawn* Pawn = Guard->GetPawn();
+		UObjective* Objective = Guard->CurrentObjective;
+		AActor* Target = Objective ? Objective->TargetActor : nullptr;
+
+		const int32 PawnIndex = Registry ? Registry->FindIndex(Pawn, Guard->PawnRegistryIndex) : INDEX_NONE;
+		Guard->PawnRegistryIndex = PawnIndex;
+
+		int32 TargetIndex = INDEX_NONE;
+		if (Objective)
+		{
+			TargetIndex = Registry ? Registry->FindIndex(Target, Objective->TargetRegistryIndex) : INDEX_NONE;
+			Objective->TargetRegistryIndex = TargetIndex;
+		}
+
+		FPPGuardObjectiveInput& Input = Inputs[i];
+		Input.EyeLocation = Pawn ? Pawn->GetPawnViewLocation() : FVector::ZeroVector;
+		Input.Type = Objective ? Objective->Type : EObjectiveType::None;
+		Input.bHasTarget = Target != nullptr;
+		Input.bInSight = Objective && Guard->bObjectiveInSight;
+		Input.bVisionImpaired = PawnIndex != INDEX_NONE ? Registry->HasAnyStatus(PawnIndex, EPPCharacterStatus::VisionImpaired) : Guard->IsVisionImpaired();
+		Input.bTargetPendingKill = Target && Target->IsPendingKillPending();
+
+		if (TargetIndex != INDEX_NONE)
+		{
+			Input.TargetLocation = Registry->GetLocation(TargetIndex);
+			Input.TargetVelocity = Registry->GetVelocity(TargetIndex);
+			Input.bTargetDead = Registry->HasAnyStatus(TargetIndex, EPPCharacterStatus::Dead);
+		}
+		else
+		{
+			const APrincessPigCharacter* TargetCharacter = Cast<APrincessPigCharacter>(Target);
+			Input.TargetLocation = Target ? Target->GetActorLocation() : FVector::ZeroVector;
+			Input.TargetVelocity = Target ? Target->GetVelocity() : FVector::ZeroVector;
+			Input.bTargetDead = TargetCharacter && TargetCharacter->Replicated_IsDead;
+		}
+	}
+}
+
+void AGuardObjectiveStage::Evaluate(int32 Index)
+{
+	const FPPGuardObjectiveInput& Input = Inputs[Index];
+	FPPGuardObjectiveCommand& Command = Commands[Index];
+
+	// Only a target we can see can be lost. Smoke is much cheaper to check than the trace
+	if (Input.bInSight)
+	{
+		const bool bSmoke = SmokeGrid && Input.bHasTarget && SmokeGrid->GetSmokeDepth(Input.EyeLocation, Input.TargetLocation) >= SmokeGrid->BlockingDepth;
+		if (Input.bVisionImpaired || bSmoke || !Input.bHasTarget)
+		{
+			Command.bLoseSight = true;
+		}
+		else
+		{
+			Command.bNeedsSightTrace = true;
+		}
+	}
+
+	// Chase and Distraction need the target to still be there
+	if ((Input.Type == EObjectiveType::Chase || Input.Type == EObjectiveType::Distraction) && Input.bHasTarget)
+	{
+		Command.bDowngrade = Input.bTargetPendingKill;
+		Command.bTargetDied = Input.bTargetDead;
+	}
+}
+
+void AGuardObjectiveStage::TraceSight()
+{
+	SCOPE_CYCLE_COUNTER(STAT_PPGuardObjectiveSightTraces);
+
+	// Traces and virtual calls stay on the game thread
+	for (int32 i = 0; i < Guards.Num(); i++)
+	{
+		FPPGuardObjectiveCommand& Command = Commands[i];
+		const AGuardAIController* Guard = Guards[i].Get();
+		if (Command.bNeedsSightTrace && Guard && Guard->CurrentObjective)
+		{
+			Command.bLoseSight = !Guard->LineOfSightTo(Guard->CurrentObjective->TargetActor);
+		}
+		Command.bRefreshPursuit = Inputs[i].Type == EObjectiveType::Chase && Command.bNeedsSightTrace && !Command.bLoseSight;
+		Command.TargetLocation = Inputs[i].TargetLocation;
+		Command.TargetVelocity = Inputs[i].TargetVelocity;
+	}
+}
+
+void AGuardObjectiveStage::Apply()
+{
+	SCOPE_CYCLE_COUNTER(STAT_PPGuardObjectiveApply);
+
+	for (int32 i = 0; i < Guards.Num(); i++)
+	{
+		AGuardAIController* Guard = Guards[i].Get();
+		if (Guard)
+		{
+			Guard->ApplyObjectiveCommand(Commands[i]);
+		}
+	}
+}
@@ -0,0 +1,98 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "Objective.h"
+#include "GuardObjectiveStage.generated.h"
+
+class AGuardAIController;
+class ASmokeGrid;
+
+/** What a guard's objective update needs to know, copied out on the game thread */
+struct FPPGuardObjectiveInput
+{
+	FVector EyeLocation;
+	FVector TargetLocation;
+	FVector TargetVelocity;
+	EObjectiveType Type;
+	bool bHasTarget;
+	bool bInSight;
+	bool bVisionImpaired;
+	bool bTargetPendingKill;
+	bool bTargetDead;
+};
+
+/** What to do about it, applied back on the game thread */
+struct FPPGuardObjectiveCommand
+{
+	/** Passed the cheap checks, still needs a line of sight trace on the game thread */
+	bool bNeedsSightTrace;
+	bool bLoseSight;
+	bool bRefreshPursuit;
+	bool bDowngrade;
+	bool bTargetDied;
+
+	/** Where to refresh the objective to, if bRefreshPursuit */
+	FVector TargetLocation;
+	FVector TargetVelocity;
+};
+
+/**
+ * Server-side objective update for every guard at once.
+ *
+ * Each guard controller used to check its objective in its own tick: is the target still in
+ * sight, has it gone or died, and where to pursue it. This does the same once per frame for all
+ * registered guards. Inputs are copied into a flat array, from ACharacterRegistry's snapshot through
+ * indices kept on each guard and objective, and the pure checks (vision, smoke, target status) run
+ * across threads on that copy alone. Guards whose target survives them are then traced
+ * on the game thread, and the resulting commands are applied to each controller in order. Guard
+ * controllers tick after the stage, so they always see this frame's result.
+ *
+ * Settings can be changed in DefaultGame.ini under [/Script/PrincessPig.GuardObjectiveStage].
+ */
+UCLASS(NotPlaceable, Transient, Config = Game)
+class PRINCESSPIG_API AGuardObjectiveStage : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AGuardObjectiveStage();
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Find or spawn the stage for this world. Returns null on clients, or if bEnabled is off */
+	static AGuardObjectiveStage* GetGuardObjectiveStage(const UObject* WorldContextObject);
+
+	/** Find the stage without spawning one */
+	static AGuardObjectiveStage* FindGuardObjectiveStage(const UObject* WorldContextObject);
+
+	/** Update guard objectives here instead of in each controller's tick */
+	UPROPERTY(Config, EditAnywhere, Category = "AI")
+	bool bEnabled;
+
+	/** Evaluate on worker threads once there are at least this many guards */
+	UPROPERTY(Config, EditAnywhere, Category = "AI")
+	int32 MinGuardsForParallel;
+
+	void RegisterGuard(AGuardAIController* Guard);
+	void UnregisterGuard(AGuardAIController* Guard);
+
+protected:
+	TArray<TWeakObjectPtr<AGuardAIController>> Guards;
+
+	/** One entry per guard in Guards order */
+	TArray<FPPGuardObjectiveInput> Inputs;
+	TArray<FPPGuardObjectiveCommand> Commands;
+
+	/** Smoke grid for this frame, if there is any smoke */
+	ASmokeGrid* SmokeGrid;
+
+	void Gather();
+	void Evaluate(int32 Index);
+	void TraceSight();
+	void Apply();
+};
@@ -0,0 +1,406 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "GuardStateMachine.h"
+#include "PrincessPig.h"
+#include "GuardAIController.h"
+#include "PrincessPigCharacter.h"
+#include "Guard.h"
+#include "PatrolPoint.h"
+#include "PatrolRoute.h"
+#include "NavQueryService.h"
+#include "Navigation/PathFollowingComponent.h"
+
+DECLARE_CYCLE_STAT(TEXT("Guard State Machine"), STAT_PPGuardStateMachine, STATGROUP_PrincessPig);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Guard State Transitions"), STAT_PPGuardStateTransitions, STATGROUP_PrincessPig);
+
+/** Used when the pawn isn't an AGuard */
+static const FPPGuardStateMachineSettings DefaultGuardStateMachineSettings;
+
+FPPGuardStateMachine::FPPGuardStateMachine()
+	: State(EPPGuardState::None)
+	, SubState(EPPGuardSubState::None)
+	, TimeRemaining(0.f)
+	, TimeSinceObjectiveUpdate(0.f)
+	, MoveTarget(FVector::ZeroVector)
+	, FocalPoint(FVector::ZeroVector)
+	, PatrolIndex(-1)
+	, LooksRemaining(0)
+	, LookSign(1.f)
+	, bStruck(false)
+	, Settings(&DefaultGuardStateMachineSettings)
+{
+}
+
+void FPPGuardStateMachine::Start(AGuardAIController* Controller)
+{
+	AGuard* Guard = Cast<AGuard>(Controller->GetPawn());
+	Settings = Guard ? &Guard->StateMachineSettings : &DefaultGuardStateMachineSettings;
+
+	State = EPPGuardState::None;
+	SubState = EPPGuardSubState::None;
+	PatrolIndex = -1;
+	TimeSinceObjectiveUpdate = 0.f;
+}
+
+void FPPGuardStateMachine::Stop(AGuardAIController* Controller)
+{
+	Controller->StopMovement();
+	Controller->ClearFocus(EAIFocusPriority::Gameplay);
+	State = EPPGuardState::None;
+	SubState = EPPGuardSubState::None;
+}
+
+void FPPGuardStateMachine::Tick(AGuardAIController* Controller, float DeltaSeconds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PPGuardStateMachine);
+
+	APrincessPigCharacter* PPCharacter = Cast<APrincessPigCharacter>(Controller->GetPawn());
+	if (nullptr == PPCharacter || PPCharacter->Replicated_IsDead)
+	{
+		return;
+	}
+
+	// What the behavior tree's objective service does
+	TimeSinceObjectiveUpdate += DeltaSeconds;
+	if (TimeSinceObjectiveUpdate >= Settings->ObjectiveUpdateInterval)
+	{
+		TimeSinceObjectiveUpdate = 0.f;
+		Controller->CheckCurrentLineOfSight();
+	}
+
+	const EPPGuardState DesiredState = GetDesiredState(Controller, PPCharacter);
+	if (DesiredState != State)
+	{
+		EnterState(Controller, PPCharacter, DesiredState);
+	}
+
+	switch (State)
+	{
+	case EPPGuardState::Patrol:			TickPatrol(Controller, PPCharacter, DeltaSeconds); break;
+	case EPPGuardState::Search:			TickSearch(Controller, PPCharacter, DeltaSeconds); break;
+	case EPPGuardState::Distraction:	TickDistraction(Controller, PPCharacter, DeltaSeconds); break;
+	case EPPGuardState::Chase:			TickChase(Controller, PPCharacter, DeltaSeconds); break;
+	default: break;
+	}
+}
+
+EPPGuardState FPPGuardStateMachine::GetDesiredState(AGuardAIController* Controller, APrincessPigCharacter* PPCharacter) const
+{
+	if (PPCharacter->IsSubdued() || PPCharacter->IsOffBalance())
+	{
+		return EPPGuardState::Preoccupied;
+	}
+
+	switch (Controller->CurrentObjective ? Controller->CurrentObjective->Type : EObjectiveType::None)
+	{
+	case EObjectiveType::Search:		return EPPGuardState::Search;
+	case EObjectiveType::Distraction:	return EPPGuardState::Distraction;
+	case EObjectiveType::Chase:			return EPPGuardState::Chase;
+	default:							return EPPGuardState::Patrol;
+	}
+}
+
+void FPPGuardStateMachine::EnterState(AGuardAIController* Controller, APrincessPigCharacter* PPCharacter, EPPGuardState NewState)
+{
+	// Leave whatever we were doing cleanly
+	if (SubState == EPPGuardSubState::Distracted && PPCharacter->IsDistracted())
+	{
+		PPCharacter->Server_SetDistractedDirectly(false);
+	}
+	Controller->StopMovement();
+	Controller->ClearFocus(EAIFocusPriority::Gameplay);
+
+	State = NewState;
+	SubState = EPPGuardSubState::None;
+	INC_DWORD_STAT(STAT_PPGuardStateTransitions);
+
+	switch (State)
+	{
+	case EPPGuardState::Patrol:
+		PPCharacter->SetMovementMode(EPPMovementMode::Walking);
+		break;
+
+	case EPPGuardState::Search:
+		PPCharacter->SetMovementMode(EPPMovementMode::Running);
+		MoveTo(Controller, Controller->CurrentObjective->GetLastKnownLocation());
+		break;
+
+	case EPPGuardState::Distraction:
+		PPCharacter->SetMovementMode(EPPMovementMode::Walking);
+		MoveTo(Controller, Controller->CurrentObjective->GetLastKnownLocation());
+		break;
+
+	case EPPGuardState::Chase:
+		PPCharacter->SetMovementMode(EPPMovementMode::Running);
+		MoveTo(Controller, Controller->PursuitLocation);
+		break;
+
+	default:
+		break;
+	}
+
+	UE_LOG(LogPrincessPig, Verbose, TEXT("%s state %s/%s"), *Controller->GetName(),
+		*StaticEnum<EPPGuardState>()->GetNameStringByValue((int64)State),
+		*StaticEnum<EPPGuardSubState>()->GetNameStringByValue((int64)SubState));
+}
+
+void FPPGuardStateMachine::EnterSubState(AGuardAIController* Controller, EPPGuardSubState NewSubState)
+{
+	SubState = NewSubState;
+	INC_DWORD_STAT(STAT_PPGuardStateTransitions);
+
+	UE_LOG(LogPrincessPig, Verbose, TEXT("%s state %s/%s"), *Controller->GetName(),
+		*StaticEnum<EPPGuardState>()->GetNameStringByValue((int64)State),
+		*StaticEnum<EPPGuardSubState>()->GetNameStringByValue((int64)SubState));
+}
+
+#pragma region States
+
+void FPPGuardStateMachine::TickPatrol(AGuardAIController* Controller, APrincessPigCharacter* PPCharacter, float DeltaSeconds)
+{
+	APatrolRoute* Route = PPCharacter->PatrolRoute;
+	const bool bHasPatrol = Route && Route->PatrolPoints.Num() > 0;
+
+	switch (SubState)
+	{
+	case EPPGuardSubState::None:
+		// Head for the next point, or without a route just keep looking around
+		if (bHasPatrol)
+		{
+			PatrolIndex = (PatrolIndex + 1) % Route->PatrolPoints.Num();
+			APatrolPoint* PatrolPoint = Route->PatrolPoints[PatrolIndex];
+			if (PatrolPoint)
+			{
+				MoveTo(Controller, PatrolPoint->GetActorLocation());
+			}
+		}
+		else
+		{
+			StartLookAround(Controller, 1);
+		}
+		break;
+
+	case EPPGuardSubState::MoveTo:
+		if (HasArrived(Controller))
+		{
+			APatrolPoint* PatrolPoint = bHasPatrol ? Route->PatrolPoints[PatrolIndex % Route->PatrolPoints.Num()] : nullptr;
+			if (PatrolPoint)
+			{
+				FocalPoint = PatrolPoint->GetActorLocation() + PatrolPoint->GetActorForwardVector() * 200.f;
+				Controller->SetFocalPoint(FocalPoint, EAIFocusPriority::Gameplay);
+			}
+			TimeRemaining = Settings->PatrolWaitTime;
+			EnterSubState(Controller, EPPGuardSubState::WaitAtPatrolPoint);
+		}
+		break;
+
+	case EPPGuardSubState::WaitAtPatrolPoint:
+		TimeRemaining -= DeltaSeconds;
+		if (TimeRemaining <= 0.f)
+		{
+			Controller->ClearFocus(EAIFocusPriority::Gameplay);
+			StartLookAround(Controller, 1);
+		}
+		break;
+
+	case EPPGuardSubState::LookAround:
+		if (TickLookAround(Controller, DeltaSeconds))
+		{
+			EnterSubState(Controller, EPPGuardSubState::None);
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+void FPPGuardStateMachine::TickSearch(AGuardAIController* Controller, APrincessPigCharacter* PPCharacter, float DeltaSeconds)
+{
+	// Something new to search for, start again from there
+	const FVector SearchLocation = Controller->CurrentObjective->GetLastKnownLocation();
+	if (FVector::DistSquared(SearchLocation, MoveTarget) > FMath::Square(Settings->RepathDistance))
+	{
+		Controller->ClearFocus(EAIFocusPriority::Gameplay);
+		MoveTo(Controller, SearchLocation);
+	}
+
+	switch (SubState)
+	{
+	case EPPGuardSubState::MoveTo:
+		if (HasArrived(Controller))
+		{
+			StartLookAround(Controller, Settings->SearchLooks);
+		}
+		break;
+
+	case EPPGuardSubState::LookAround:
+		// Nothing turned up
+		if (TickLookAround(Controller, DeltaSeconds))
+		{
+			Controller->ClearObjective();
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+void FPPGuardStateMachine::TickDistraction(AGuardAIController* Controller, APrincessPigCharacter* PPCharacter, float DeltaSeconds)
+{
+	switch (SubState)
+	{
+	case EPPGuardSubState::MoveTo:
+		if (HasArrived(Controller) || Controller->IsObjectiveInteractionAvailable())
+		{
+			Controller->StopMovement();
+			if (Controller->CurrentObjective->TargetActor)
+			{
+				Controller->SetFocus(Controller->CurrentObjective->TargetActor, EAIFocusPriority::Gameplay);
+			}
+			PPCharacter->Server_SetDistractedFor(Settings->DistractedDuration);
+			TimeRemaining = Settings->DistractedDuration;
+			EnterSubState(Controller, EPPGuardSubState::Distracted);
+		}
+		break;
+
+	case EPPGuardSubState::Distracted:
+		TimeRemaining -= DeltaSeconds;
+		if (TimeRemaining <= 0.f)
+		{
+			Controller->ClearFocus(EAIFocusPriority::Gameplay);
+			Controller->ClearObjective();
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+void FPPGuardStateMachine::TickChase(AGuardAIController* Controller, APrincessPigCharacter* PPCharacter, float DeltaSeconds)
+{
+	APrincessPigCharacter* Target = Cast<APrincessPigCharacter>(Controller->CurrentObjective->TargetActor);
+
+	switch (SubState)
+	{
+	case EPPGuardSubState::MoveTo:
+		if (Target && Controller->IsObjectiveInteractionAvailable())
+		{
+			// Already down, so take them. Otherwise knock them down first
+			Controller->StopMovement();
+			Controller->SetFocus(Target, EAIFocusPriority::Gameplay);
+			if (Target->IsSubdued())
+			{
+				PPCharacter->BPEvent_Interact(Target);
+				bStruck = true;
+				TimeRemaining = Settings->SubdueRecoveryTime;
+			}
+			else
+			{
+				bStruck = false;
+				TimeRemaining = Settings->SubdueWindupTime;
+			}
+			EnterSubState(Controller, EPPGuardSubState::Subdue);
+		}
+		else
+		{
+			// Repath when the pursuit location has moved on, but not more often than the objective updates
+			TimeRemaining -= DeltaSeconds;
+			if (TimeRemaining <= 0.f && (FVector::DistSquared(Controller->PursuitLocation, MoveTarget) > FMath::Square(Settings->RepathDistance) || HasArrived(Controller)))
+			{
+				TimeRemaining = Settings->ObjectiveUpdateInterval;
+				MoveTo(Controller, Controller->PursuitLocation);
+			}
+		}
+		break;
+
+	case EPPGuardSubState::Subdue:
+		TimeRemaining -= DeltaSeconds;
+		if (TimeRemaining > 0.f)
+		{
+			break;
+		}
+
+		if (!bStruck && Target && PPCharacter->AvailableInteractions.Contains(Target))
+		{
+			PPCharacter->Strike(Target);
+			bStruck = true;
+			TimeRemaining = Settings->SubdueRecoveryTime;
+			break;
+		}
+
+		Controller->ClearFocus(EAIFocusPriority::Gameplay);
+		TimeRemaining = Settings->ObjectiveUpdateInterval;
+		MoveTo(Controller, Controller->PursuitLocation);
+		break;
+
+	default:
+		break;
+	}
+}
+
+#pragma endregion States
+
+#pragma region Helpers
+
+void FPPGuardStateMachine::MoveTo(AGuardAIController* Controller, const FVector& Location)
+{
+	MoveTarget = Location;
+	if (ANavQueryService* NavQueries = Controller->NavQueryService.Get())
+	{
+		NavQueries->RequestMove(Controller, Location, Settings->AcceptanceRadius);
+	}
+	else
+	{
+		Controller->MoveToLocation(Location, Settings->AcceptanceRadius);
+	}
+	if (SubState != EPPGuardSubState::MoveTo)
+	{
+		EnterSubState(Controller, EPPGuardSubState::MoveTo);
+	}
+}
+
+bool FPPGuardStateMachine::HasArrived(AGuardAIController* Controller) const
+{
+	// Idle path following means we got there, or couldn't, either way stop trying. Unless the path is still being found
+	const ANavQueryService* NavQueries = Controller->NavQueryService.Get();
+	return Controller->GetMoveStatus() == EPathFollowingStatus::Idle && !(NavQueries && NavQueries->HasPendingMove(Controller));
+}
+
+void FPPGuardStateMachine::StartLookAround(AGuardAIController* Controller, int32 NumLooks)
+{
+	LooksRemaining = FMath::Max(NumLooks, 1) * 2;
+	LookSign = FMath::RandBool() ? 1.f : -1.f;
+	TimeRemaining = 0.f;
+	EnterSubState(Controller, EPPGuardSubState::LookAround);
+}
+
+bool FPPGuardStateMachine::TickLookAround(AGuardAIController* Controller, float DeltaSeconds)
+{
+	TimeRemaining -= DeltaSeconds;
+	if (TimeRemaining > 0.f)
+	{
+		return false;
+	}
+
+	if (LooksRemaining <= 0 || nullptr == Controller->GetPawn())
+	{
+		Controller->ClearFocus(EAIFocusPriority::Gameplay);
+		return true;
+	}
+
+	// Turn one way then the other, like the behavior tree's look around tasks
+	FRotator Rotation = Controller->GetControlRotation();
+	Rotation.Yaw += Settings->LookAroundYaw * LookSign * (LooksRemaining % 2 == 0 ? 1.f : 2.f);
+	FocalPoint = Controller->GetPawn()->GetActorLocation() + Rotation.Vector() * 300.f;
+	Controller->SetFocalPoint(FocalPoint, EAIFocusPriority::Gameplay);
+
+	LookSign = -LookSign;
+	LooksRemaining--;
+	TimeRemaining = Settings->LookAroundTime;
+	return false;
+}
+
+#pragma endregion Helpers
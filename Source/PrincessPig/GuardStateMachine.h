@@ -0,0 +1,147 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Objective.h"
+#include "GuardStateMachine.generated.h"
+
+class AGuardAIController;
+class APrincessPigCharacter;
+
+/** Top level states, one per objective type plus being preoccupied */
+UENUM(BlueprintType)
+enum class EPPGuardState : uint8
+{
+	None UMETA(DisplayName = "None"),
+	Preoccupied UMETA(DisplayName = "Preoccupied"),
+	Patrol UMETA(DisplayName = "Patrol"),
+	Search UMETA(DisplayName = "Search"),
+	Distraction UMETA(DisplayName = "Distraction"),
+	Chase UMETA(DisplayName = "Chase")
+};
+
+/** What the guard is doing inside its top level state */
+UENUM(BlueprintType)
+enum class EPPGuardSubState : uint8
+{
+	None UMETA(DisplayName = "None"),
+	MoveTo UMETA(DisplayName = "MoveTo"),
+	WaitAtPatrolPoint UMETA(DisplayName = "WaitAtPatrolPoint"),
+	LookAround UMETA(DisplayName = "LookAround"),
+	Distracted UMETA(DisplayName = "Distracted"),
+	Subdue UMETA(DisplayName = "Subdue")
+};
+
+/** Timings and distances for guards run by FPPGuardStateMachine, matching the behavior tree's nodes */
+USTRUCT(BlueprintType)
+struct FPPGuardStateMachineSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
+	float AcceptanceRadius;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
+	float PatrolWaitTime;
+
+	/** Seconds looking each way, and how far to turn, when looking around */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
+	float LookAroundTime;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
+	float LookAroundYaw;
+
+	/** Looks each way at the end of a search before giving up */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
+	int32 SearchLooks;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
+	float DistractedDuration;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
+	float SubdueWindupTime;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
+	float SubdueRecoveryTime;
+
+	/** Chasing guards repath when the pursuit location moves this far */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
+	float RepathDistance;
+
+	/** Seconds between objective and line of sight updates, like the behavior tree's objective service */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "AI")
+	float ObjectiveUpdateInterval;
+
+	FPPGuardStateMachineSettings()
+		: AcceptanceRadius(50.f)
+		, PatrolWaitTime(2.f)
+		, LookAroundTime(1.f)
+		, LookAroundYaw(60.f)
+		, SearchLooks(2)
+		, DistractedDuration(3.f)
+		, SubdueWindupTime(0.25f)
+		, SubdueRecoveryTime(0.75f)
+		, RepathDistance(100.f)
+		, ObjectiveUpdateInterval(0.2f)
+	{}
+};
+
+/**
+ * Native alternative to the guard behavior trees, for guards with bUseNativeStateMachine set.
+ *
+ * Patrols the guard's route, waiting and looking at each point, and otherwise follows the
+ * controller's objective: walking to and looking around a search, staring at a distraction,
+ * or running after a chase target and subduing it once in reach. Subdued or off balance
+ * guards stand still. The top level state follows the objective type every tick, so it doesn't
+ * matter whether the objective changed through OnObjectiveChanged or quietly.
+ *
+ * Everything it needs to remember is in this struct, owned by the controller. Transitions are
+ * logged to LogPrincessPig at Verbose, next to the behavior tree's active task changes, so runs
+ * of the two can be compared.
+ */
+struct FPPGuardStateMachine
+{
+	EPPGuardState State;
+	EPPGuardSubState SubState;
+
+	/** Counts down in timed sub states */
+	float TimeRemaining;
+	float TimeSinceObjectiveUpdate;
+
+	/** Where we are walking to, and for Chase where we last asked to path to */
+	FVector MoveTarget;
+	FVector FocalPoint;
+
+	int32 PatrolIndex;
+
+	/** Looks left to do, and which way the next one turns */
+	int32 LooksRemaining;
+	float LookSign;
+
+	bool bStruck;
+
+	/** Owned by the guard pawn, set on Start */
+	const FPPGuardStateMachineSettings* Settings;
+
+	FPPGuardStateMachine();
+
+	void Start(AGuardAIController* Controller);
+	void Stop(AGuardAIController* Controller);
+	void Tick(AGuardAIController* Controller, float DeltaSeconds);
+
+protected:
+	EPPGuardState GetDesiredState(AGuardAIController* Controller, APrincessPigCharacter* PPCharacter) const;
+	void EnterState(AGuardAIController* Controller, APrincessPigCharacter* PPCharacter, EPPGuardState NewState);
+	void EnterSubState(AGuardAIController* Controller, EPPGuardSubState NewSubState);
+
+	void TickPatrol(AGuardAIController* Controller, APrincessPigCharacter* PPCharacter, float DeltaSeconds);
+	void TickSearch(AGuardAIController* Controller, APrincessPigCharacter* PPCharacter, float DeltaSeconds);
+	void TickDistraction(AGuardAIController* Controller, APrincessPigCharacter* PPCharacter, float DeltaSeconds);
+	void TickChase(AGuardAIController* Controller, APrincessPigCharacter* PPCharacter, float DeltaSeconds);
+
+	void MoveTo(AGuardAIController* Controller, const FVector& Location);
+	bool HasArrived(AGuardAIController* Controller) const;
+	void StartLookAround(AGuardAIController* Controller, int32 NumLooks);
+	bool TickLookAround(AGuardAIController* Controller, float DeltaSeconds);
+};
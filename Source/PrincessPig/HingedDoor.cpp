@@ -0,0 +1,266 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HingedDoor.h"
+#include "PrincessPig.h"
+#include "PrincessPigCharacter.h"
+#include "Components/SceneComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Components/BoxComponent.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Engine/World.h"
+#include "Net/UnrealNetwork.h"
+
+DECLARE_CYCLE_STAT(TEXT("Door Tick"), STAT_PPDoorTick, STATGROUP_PrincessPig);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Doors Awake"), STAT_PPDoorsAwake, STATGROUP_PrincessPig);
+
+AHingedDoor::AHingedDoor()
+{
+	// Only ticks while swinging
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
+
+	SetReplicates(true);
+	bReplicateMovement = false;
+	NetUpdateFrequency = 20.f;
+	NetDormancy = DORM_Initial;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>("Root");
+
+	Hinge = CreateDefaultSubobject<USceneComponent>("Hinge");
+	Hinge->SetupAttachment(RootComponent);
+
+	// Blocks the living, overlaps dead bodies (see APrincessPigCharacter::OnRep_AllowOverlapDynamic)
+	DoorMesh = CreateDefaultSubobject<UStaticMeshComponent>("DoorMesh");
+	DoorMesh->SetupAttachment(Hinge);
+	DoorMesh->SetCollisionProfileName("BlockAllDynamic");
+	DoorMesh->SetSimulatePhysics(false);
+	DoorMesh->SetMobility(EComponentMobility::Movable);
+
+	PushVolume = CreateDefaultSubobject<UBoxComponent>("PushVolume");
+	PushVolume->SetupAttachment(Hinge);
+	PushVolume->InitBoxExtent(FVector(50.f, 40.f, 100.f));
+	PushVolume->SetRelativeLocation(FVector(50.f, 0.f, 100.f));
+	PushVolume->SetCollisionProfileName("OverlapOnlyPawn");
+	PushVolume->SetCollisionResponseToChannel(ECC_GameTraceChannel1, ECR_Overlap); // Guard
+	PushVolume->OnComponentBeginOverlap.AddDynamic(this, &AHingedDoor::OnPushVolumeBeginOverlap);
+
+	MinAngle = -100.f;
+	MaxAngle = 100.f;
+	Damping = 2.f;
+	PushStrength = 1.f;
+	SleepSpeed = 1.f;
+	ClientInterpSpeed = 15.f;
+
+	Angle = 0.f;
+	AngularVelocity = 0.f;
+	HingeStateReceivedTime = 0.f;
+}
+
+void AHingedDoor::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(AHingedDoor, Replicated_HingeState);
+}
+
+void AHingedDoor::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Doors placed ajar start from their placed angle
+	Angle = FMath::Clamp(Hinge->RelativeRotation.Yaw, MinAngle, MaxAngle);
+	if (HasAuthority())
+	{
+		Replicated_HingeState.Set(Angle, 0.f);
+	}
+	ApplyAngle();
+}
+
+void AHingedDoor::Tick(float DeltaSeconds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PPDoorTick);
+
+	Super::Tick(DeltaSeconds);
+
+	if (HasAuthority())
+	{
+		TickServer(DeltaSeconds);
+	}
+	else
+	{
+		TickClient(DeltaSeconds);
+	}
+}
+
+void AHingedDoor::OnPushVolumeBeginOverlap(UPrimitiveComponent* OverlappedComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
+{
+	if (HasAuthority() && Cast<APrincessPigCharacter>(OtherActor))
+	{
+		Wake();
+	}
+}
+
+void AHingedDoor::AddAngularVelocity(float DegreesPerSecond)
+{
+	if (HasAuthority())
+	{
+		AngularVelocity += DegreesPerSecond;
+		Wake();
+	}
+}
+
+void AHingedDoor::Wake()
+{
+	if (IsActorTickEnabled())
+	{
+		return;
+	}
+
+	SetActorTickEnabled(true);
+	INC_DWORD_STAT(STAT_PPDoorsAwake);
+
+	if (HasAuthority() && NetDormancy > DORM_Awake)
+	{
+		SetNetDormancy(DORM_Awake);
+	}
+}
+
+void AHingedDoor::Sleep()
+{
+	if (!IsActorTickEnabled())
+	{
+		return;
+	}
+
+	SetActorTickEnabled(false);
+	DEC_DWORD_STAT(STAT_PPDoorsAwake);
+
+	if (HasAuthority())
+	{
+		// Make sure the resting angle goes out before dormancy stops replication
+		AngularVelocity = 0.f;
+		Replicated_HingeState.Set(Angle, 0.f);
+		FlushNetDormancy();
+		SetNetDormancy(DORM_DormantAll);
+	}
+}
+
+bool AHingedDoor::ApplyPushes()
+{
+	TArray<AActor*> Overlapping;
+	PushVolume->GetOverlappingActors(Overlapping, APrincessPigCharacter::StaticClass());
+
+	const FVector HingeLocation = Hinge->GetComponentLocation();
+	const FVector Along = Hinge->GetForwardVector();
+	const FVector Normal = Hinge->GetRightVector();
+
+	bool bAnyPushers = false;
+	for (AActor* Actor : Overlapping)
+	{
+		APrincessPigCharacter* Character = CastChecked<APrincessPigCharacter>(Actor);
+
+		// Dead bodies overlap WorldDynamic and go straight through. Not read off the capsule,
+		// as nav walking ignores WorldDynamic there too
+		if (Character->Replicated_AllowOverlapDynamic)
+		{
+			continue;
+		}
+		bAnyPushers = true;
+
+		// Characters blocked by the door have no velocity into it, so use what they are trying to do
+		const UCharacterMovementComponent* Movement = Character->GetCharacterMovement();
+		const FVector Intent = Movement->GetCurrentAcceleration().GetSafeNormal() * Movement->GetMaxSpeed();
+		const float IntentSpeed = FVector::DotProduct(Intent, Normal);
+		const float ActualSpeed = FVector::DotProduct(Character->GetVelocity(), Normal);
+		const float Speed = FMath::Abs(IntentSpeed) > FMath::Abs(ActualSpeed) ? IntentSpeed : ActualSpeed;
+
+		// Only pushes into the leaf count
+		const FVector ToCharacter = Character->GetActorLocation() - HingeLocation;
+		const float Side = FVector::DotProduct(ToCharacter, Normal);
+		if (Side * Speed >= 0.f)
+		{
+			continue;
+		}
+
+		// Turn the leaf at least as fast as the contact point is being pushed
+		const float Lever = FMath::Max(FVector::DotProduct(ToCharacter, Along), 10.f);
+		const float PushedVelocity = FMath::RadiansToDegrees(Speed / Lever) * PushStrength;
+		if (FMath::Abs(PushedVelocity) > FMath::Abs(AngularVelocity) || PushedVelocity * AngularVelocity < 0.f)
+		{
+			AngularVelocity = PushedVelocity;
+		}
+	}
+
+	return bAnyPushers;
+}
+
+void AHingedDoor::TickServer(float DeltaSeconds)
+{
+	const bool bAnyPushers = ApplyPushes();
+
+	Angle += AngularVelocity * DeltaSeconds;
+	if (Angle < MinAngle || Angle > MaxAngle)
+	{
+		Angle = FMath::Clamp(Angle, MinAngle, MaxAngle);
+		AngularVelocity = 0.f;
+	}
+	AngularVelocity *= FMath::Max(0.f, 1.f - Damping * DeltaSeconds);
+
+	ApplyAngle();
+
+	// Quantized, so tiny changes don't dirty the property
+	FPPHingeState NewState;
+	NewState.Set(Angle, AngularVelocity);
+	if (NewState != Replicated_HingeState)
+	{
+		Replicated_HingeState = NewState;
+	}
+
+	if (!bAnyPushers && FMath::Abs(AngularVelocity) < SleepSpeed)
+	{
+		Sleep();
+	}
+}
+
+void AHingedDoor::OnRep_HingeState()
+{
+	HingeStateReceivedTime = GetWorld()->GetTimeSeconds();
+	Wake();
+}
+
+void AHingedDoor::TickClient(float DeltaSeconds)
+{
+	// Extrapolate a little past the last update, then ease towards it
+	const float SinceUpdate = FMath::Min(GetWorld()->GetTimeSeconds() - HingeStateReceivedTime, 2.f / NetUpdateFrequency);
+	const float TargetAngle = FMath::Clamp(Replicated_HingeState.GetAngle() + Replicated_HingeState.GetVelocity() * SinceUpdate, MinAngle, MaxAngle);
+
+	Angle = FMath::FInterpTo(Angle, TargetAngle, DeltaSeconds, ClientInterpSpeed);
+	ApplyAngle();
+
+	if (Replicated_HingeState.QuantizedVelocity == 0 && FMath::IsNearlyEqual(Angle, TargetAngle, 0.05f))
+	{
+		Angle = TargetAngle;
+		ApplyAngle();
+		Sleep();
+	}
+}
+
+void AHingedDoor::ApplyAngle()
+{
+	Hinge->SetRelativeRotation(FRotator(0.f, Angle, 0.f));
+}
+
+
+#pragma region Relevancy
+
+bool AHingedDoor::IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const
+{
+	if (!CameraRelevancy.bEnabled || bAlwaysRelevant)
+	{
+		return Super::IsNetRelevantFor(RealViewer, ViewTarget, SrcLocation);
+	}
+
+	return CameraRelevancy.IsRelevant(GetActorLocation(), RealViewer, SrcLocation);
+}
+
+#pragma endregion Relevancy
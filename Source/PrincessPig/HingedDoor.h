@@ -0,0 +1,145 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "CameraRelevancy.h"
+#include "HingedDoor.generated.h"
+
+class USceneComponent;
+class UStaticMeshComponent;
+class UBoxComponent;
+class UPrimitiveComponent;
+
+/** Hinge angle and speed as replicated, in hundredths of a degree and tenths of a degree per second */
+USTRUCT()
+struct FPPHingeState
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	int16 QuantizedAngle;
+
+	UPROPERTY()
+	int16 QuantizedVelocity;
+
+	FPPHingeState()
+		: QuantizedAngle(0)
+		, QuantizedVelocity(0)
+	{}
+
+	float GetAngle() const { return QuantizedAngle * 0.01f; }
+	float GetVelocity() const { return QuantizedVelocity * 0.1f; }
+
+	void Set(float Angle, float Velocity)
+	{
+		QuantizedAngle = (int16)FMath::Clamp(FMath::RoundToInt(Angle * 100.f), -MAX_int16, (int32)MAX_int16);
+		QuantizedVelocity = (int16)FMath::Clamp(FMath::RoundToInt(Velocity * 10.f), -MAX_int16, (int32)MAX_int16);
+	}
+
+	bool operator==(const FPPHingeState& Other) const { return QuantizedAngle == Other.QuantizedAngle && QuantizedVelocity == Other.QuantizedVelocity; }
+	bool operator!=(const FPPHingeState& Other) const { return !(*this == Other); }
+};
+
+/**
+ * A door on a kinematic hinge.
+ *
+ * Instead of simulating the leaf as a rigid body, the server keeps a single angle that
+ * characters in PushVolume push open, by turning the leaf at least as fast as they are walking
+ * into it. Only the angle and angular speed replicate. Clients extrapolate from the last update
+ * and ease towards it. The door stops ticking and goes dormant once it comes to rest.
+ *
+ * The leaf is WorldDynamic, so characters with Replicated_AllowOverlapDynamic (dead bodies)
+ * pass through it and don't push it, same as with the physics doors.
+ */
+UCLASS()
+class PRINCESSPIG_API AHingedDoor : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AHingedDoor();
+
+	virtual void BeginPlay() override;
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Rotates about its Z axis. Attach the leaf to this with the hinge edge at the origin */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Door")
+	USceneComponent* Hinge;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Door")
+	UStaticMeshComponent* DoorMesh;
+
+	/** Characters overlapping this can push the door */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Door")
+	UBoxComponent* PushVolume;
+
+	/** Limits of the hinge, in degrees from closed */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Door")
+	float MinAngle;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Door")
+	float MaxAngle;
+
+	/** Fraction of angular speed lost per second once nobody is pushing */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Door")
+	float Damping;
+
+	/** Scales how fast pushing characters turn the door */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Door")
+	float PushStrength;
+
+	/** Below this speed (degrees per second) with nobody pushing, the door goes to sleep */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Door")
+	float SleepSpeed;
+
+	/** How quickly clients catch up with the replicated angle */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Door")
+	float ClientInterpSpeed;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Door")
+	float GetAngle() const { return Angle; }
+
+	/** Server only. Swing the door, e.g. from an explosion or a key */
+	UFUNCTION(BlueprintCallable, Category = "Door")
+	void AddAngularVelocity(float DegreesPerSecond);
+
+protected:
+	UPROPERTY(ReplicatedUsing = OnRep_HingeState)
+	FPPHingeState Replicated_HingeState;
+
+	UFUNCTION()
+	void OnRep_HingeState();
+
+	/** Angle currently applied to Hinge, and its speed */
+	float Angle;
+	float AngularVelocity;
+
+	/** Client only: when the last hinge state arrived */
+	float HingeStateReceivedTime;
+
+	UFUNCTION()
+	void OnPushVolumeBeginOverlap(UPrimitiveComponent* OverlappedComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
+
+	void Wake();
+	void Sleep();
+
+	/** Returns true if anyone is pushing */
+	bool ApplyPushes();
+	void ApplyAngle();
+	void TickServer(float DeltaSeconds);
+	void TickClient(float DeltaSeconds);
+
+
+#pragma region Relevancy
+
+public:
+	/** Doors are only relevant to clients whose camera can (nearly) see them */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Replication")
+	FPPCameraRelevancy CameraRelevancy;
+
+	virtual bool IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const override;
+
+#pragma endregion Relevancy
+};
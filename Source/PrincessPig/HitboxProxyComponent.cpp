@@ -0,0 +1,124 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "HitboxProxyComponent.h"
+#include "PrincessPig.h"
+#include "GameFramework/Character.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/World.h"
+#include "AnimationRuntime.h"
+#include "TimerManager.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Characters With Live Bones"), STAT_PPLiveBoneCharacters, STATGROUP_PrincessPig);
+DECLARE_CYCLE_STAT(TEXT("Hitbox Proxy Location"), STAT_PPHitboxProxyLocation, STATGROUP_PrincessPig);
+
+UHitboxProxyComponent::UHitboxProxyComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+
+	Mesh = nullptr;
+	IdleUpdateFlag = EMeshComponentUpdateFlag::AlwaysTickPose;
+	bHitWindowOpen = false;
+}
+
+void UHitboxProxyComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	ACharacter* Character = Cast<ACharacter>(GetOwner());
+	Mesh = Character ? Character->GetMesh() : nullptr;
+	if (nullptr == Mesh)
+	{
+		return;
+	}
+
+	IdleUpdateFlag = Mesh->MeshComponentUpdateFlag;
+
+	// Cache the reference pose once, it never changes
+	RefPoseTransforms.SetNum(Proxies.Num());
+	for (int32 i = 0; i < Proxies.Num(); i++)
+	{
+		RefPoseTransforms[i] = FTransform::Identity;
+		if (Mesh->SkeletalMesh)
+		{
+			const FReferenceSkeleton& RefSkeleton = Mesh->SkeletalMesh->RefSkeleton;
+			const int32 BoneIndex = RefSkeleton.FindBoneIndex(Proxies[i].BoneName);
+			if (BoneIndex != INDEX_NONE)
+			{
+				RefPoseTransforms[i] = FAnimationRuntime::GetComponentSpaceTransformRefPose(RefSkeleton, BoneIndex);
+			}
+			else
+			{
+				UE_LOG(LogPrincessPig, Warning, TEXT("%s: hitbox proxy bone %s not found"), *GetOwner()->GetName(), *Proxies[i].BoneName.ToString());
+			}
+		}
+	}
+}
+
+void UHitboxProxyComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	CloseHitWindow();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UHitboxProxyComponent::OpenHitWindow(float Duration)
+{
+	if (nullptr == Mesh)
+	{
+		return;
+	}
+
+	if (!bHitWindowOpen)
+	{
+		bHitWindowOpen = true;
+		Mesh->MeshComponentUpdateFlag = EMeshComponentUpdateFlag::AlwaysTickPoseAndRefreshBones;
+		INC_DWORD_STAT(STAT_PPLiveBoneCharacters);
+	}
+
+	// Overlapping windows keep it open until the later one ends
+	FTimerManager& TimerManager = GetWorld()->GetTimerManager();
+	if (TimerManager.GetTimerRemaining(HitWindowTimer) < Duration)
+	{
+		TimerManager.SetTimer(HitWindowTimer, this, &UHitboxProxyComponent::CloseHitWindow, Duration, false);
+	}
+}
+
+void UHitboxProxyComponent::CloseHitWindow()
+{
+	if (!bHitWindowOpen)
+	{
+		return;
+	}
+
+	bHitWindowOpen = false;
+	if (Mesh)
+	{
+		Mesh->MeshComponentUpdateFlag = IdleUpdateFlag;
+	}
+	if (GetWorld())
+	{
+		GetWorld()->GetTimerManager().ClearTimer(HitWindowTimer);
+	}
+	DEC_DWORD_STAT(STAT_PPLiveBoneCharacters);
+}
+
+FVector UHitboxProxyComponent::GetProxyLocation(int32 Index) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_PPHitboxProxyLocation);
+
+	if (nullptr == Mesh || !Proxies.IsValidIndex(Index))
+	{
+		return GetOwner() ? GetOwner()->GetActorLocation() : FVector::ZeroVector;
+	}
+
+	const FPPHitboxProxy& Proxy = Proxies[Index];
+	if (bHitWindowOpen || Mesh->bRecentlyRendered)
+	{
+		// Bones are up to date
+		return Mesh->GetSocketTransform(Proxy.BoneName, RTS_World).TransformPosition(Proxy.Offset);
+	}
+
+	const FTransform BoneTransform = RefPoseTransforms.IsValidIndex(Index) ? RefPoseTransforms[Index] * Mesh->GetComponentTransform() : Mesh->GetComponentTransform();
+	return BoneTransform.TransformPosition(Proxy.Offset);
+}
@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "Components/SkinnedMeshComponent.h"
+#include "HitboxProxyComponent.generated.h"
+
+class USkeletalMeshComponent;
+
+/** A sphere that follows a bone of the owner's mesh */
+USTRUCT(BlueprintType)
+struct FPPHitboxProxy
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hitbox")
+	FName BoneName;
+
+	/** Offset from the bone, in bone space */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hitbox")
+	FVector Offset;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hitbox")
+	float Radius;
+
+	FPPHitboxProxy()
+		: BoneName(NAME_None)
+		, Offset(FVector::ZeroVector)
+		, Radius(20.f)
+	{}
+};
+
+/**
+ * Cheap hitboxes for the server.
+ *
+ * The server doesn't refresh bones for characters nobody is looking at. Instead, each proxy
+ * follows its bone's reference pose relative to the mesh, which costs a transform multiply.
+ * While a hit window is open (a strike or interaction is in progress) the mesh refreshes its
+ * bones every frame and the proxies follow the animated bones instead.
+ */
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class PRINCESSPIG_API UHitboxProxyComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UHitboxProxyComponent();
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hitbox")
+	TArray<FPPHitboxProxy> Proxies;
+
+	/** Refresh bones for at least Duration seconds, so that proxies follow the animation */
+	UFUNCTION(BlueprintCallable, Category = "Hitbox")
+	void OpenHitWindow(float Duration);
+
+	UFUNCTION(BlueprintCallable, Category = "Hitbox")
+	void CloseHitWindow();
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Hitbox")
+	bool IsHitWindowOpen() const { return bHitWindowOpen; }
+
+	int32 NumProxies() const { return Proxies.Num(); }
+	float GetProxyRadius(int32 Index) const { return Proxies[Index].Radius; }
+
+	/** World location of a proxy, from the animated bone if the window is open, or the reference pose if not */
+	UFUNCTION(BlueprintCallable, Category = "Hitbox")
+	FVector GetProxyLocation(int32 Index) const;
+
+protected:
+	UPROPERTY(Transient)
+	USkeletalMeshComponent* Mesh;
+
+	/** Reference pose of each proxy's bone, in mesh component space */
+	TArray<FTransform> RefPoseTransforms;
+
+	/** Update flag the mesh had before any window opened */
+	EMeshComponentUpdateFlag::Type IdleUpdateFlag;
+
+	bool bHitWindowOpen;
+
+	FTimerHandle HitWindowTimer;
+};
@@ -1,16 +1,76 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "InteractionComponent.h"
+#include "ProximityService.h"
+#include "GameFramework/Actor.h"
 
 
 // Sets default values for this component's properties
 UInteractionComponent::UInteractionComponent()
 {
-	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
-	// off to improve performance if you don't need them.
-	PrimaryComponentTick.bCanEverTick = true;
+	// Overlaps come from physics or the proximity service, nothing to tick
+	PrimaryComponentTick.bCanEverTick = false;
 	
 	InitSphereRadius(100.f);
 	SetCollisionProfileName("InteractionDetection");
+
+	bUseProximityService = true;
+}
+
+void UInteractionComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (!bUseProximityService)
+	{
+		return;
+	}
+
+	// Clients only read the replicated results, so they don't need the sphere either
+	SetCollisionEnabled(ECollisionEnabled::NoCollision);
+
+	if (AProximityService* ProximityService = AProximityService::GetProximityService(this))
+	{
+		ProximityService->RegisterSensor(this);
+		ProximityService->RegisterTarget(GetOwner());
+	}
+}
+
+void UInteractionComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (bUseProximityService)
+	{
+		if (AProximityService* ProximityService = AProximityService::FindProximityService(this))
+		{
+			ProximityService->UnregisterSensor(this);
+			ProximityService->UnregisterTarget(GetOwner());
+		}
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UInteractionComponent::StopSensing()
+{
+	SetCollisionEnabled(ECollisionEnabled::NoCollision);
+
+	if (bUseProximityService)
+	{
+		if (AProximityService* ProximityService = AProximityService::FindProximityService(this))
+		{
+			ProximityService->UnregisterSensor(this);
+		}
+	}
 }
 
+void UInteractionComponent::NotifyProximityBegin(AActor* OtherActor)
+{
+	UPrimitiveComponent* OtherComp = OtherActor ? Cast<UPrimitiveComponent>(OtherActor->GetRootComponent()) : nullptr;
+	OnComponentBeginOverlap.Broadcast(this, OtherActor, OtherComp, 0, false, FHitResult());
+}
+
+void UInteractionComponent::NotifyProximityEnd(AActor* OtherActor)
+{
+	UPrimitiveComponent* OtherComp = OtherActor ? Cast<UPrimitiveComponent>(OtherActor->GetRootComponent()) : nullptr;
+	OnComponentEndOverlap.Broadcast(this, OtherActor, OtherComp, 0);
+}
@@ -7,9 +7,16 @@
 #include "InteractionComponent.generated.h"
 
 /**
- * 
+ * Detects things the owner can interact with.
+ *
+ * By default the sphere doesn't collide at all. AProximityService tests it against
+ * registered targets at a fixed rate and raises the usual begin/end overlap events.
+ * Only registered targets are seen, and the service warns about actors the sphere would
+ * have overlapped that never registered. Turn off bUseProximityService to go back to
+ * physics overlaps, per component or for the game in DefaultGame.ini under
+ * [/Script/PrincessPig.InteractionComponent].
  */
-UCLASS()
+UCLASS(Config = Game)
 class PRINCESSPIG_API UInteractionComponent : public USphereComponent
 {
 	GENERATED_BODY()
@@ -17,6 +24,19 @@ class PRINCESSPIG_API UInteractionComponent : public USphereComponent
 public:
 	// Sets default values for this component's properties
 	UInteractionComponent();
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Interaction")
+	bool bUseProximityService;
+
+	/** Stop detecting anything, e.g. once the owner is dead. The owner can still be detected */
+	void StopSensing();
+
+	/** Called by AProximityService */
+	void NotifyProximityBegin(AActor* OtherActor);
+	void NotifyProximityEnd(AActor* OtherActor);
 };
 	
 	
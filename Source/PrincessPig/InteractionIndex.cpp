@@ -0,0 +1,116 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "InteractionIndex.h"
+#include "PrincessPig.h"
+#include "PrincessPigCharacter.h"
+#include "Item.h"
+
+DECLARE_CYCLE_STAT(TEXT("Interaction Index Rebuild"), STAT_PPInteractionIndexRebuild, STATGROUP_PrincessPig);
+DECLARE_CYCLE_STAT(TEXT("Interaction Index Query"), STAT_PPInteractionIndexQuery, STATGROUP_PrincessPig);
+
+uint32 FPPInteractionIndex::FollowerStatusSerial = 0;
+
+/* Priority ranking */
+static const float HoldableItemPriority = 4.f;
+static const float EscapeePriority = 2.f;
+static const float FollowerPriority = 1.f;
+
+FPPInteractionIndex::FPPInteractionIndex()
+{
+	bDirty = true;
+	BuiltSerial = 0;
+}
+
+float FPPInteractionIndex::ScoreCandidate(const APrincessPigCharacter* Owner, AActor* Candidate)
+{
+	if (nullptr == Candidate)
+	{
+		return 0.f;
+	}
+
+	if (Candidate->ActorHasTag("Item"))
+	{
+		return Cast<AItem>(Candidate) ? HoldableItemPriority : 0.f;
+	}
+
+	if (Candidate->ActorHasTag("Escapee"))
+	{
+		APrincessPigCharacter* Escapee = Cast<APrincessPigCharacter>(Candidate);
+		if (Escapee && Escapee->Replicated_CanBecomeFollower)
+		{
+			return Owner->Followers.Contains(Escapee) ? FollowerPriority : EscapeePriority;
+		}
+	}
+
+	return 0.f;
+}
+
+void FPPInteractionIndex::Rebuild(const APrincessPigCharacter* Owner, const TArray<AActor*>& Available)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PPInteractionIndexRebuild);
+
+	Candidates.Reset();
+	for (AActor* Actor : Available)
+	{
+		const float Priority = ScoreCandidate(Owner, Actor);
+		if (Priority > 0.f)
+		{
+			FPPInteractionCandidate& Candidate = Candidates.AddDefaulted_GetRef();
+			Candidate.Actor = Actor;
+			Candidate.Priority = Priority;
+		}
+	}
+
+	Candidates.Sort([](const FPPInteractionCandidate& A, const FPPInteractionCandidate& B) { return A.Priority > B.Priority; });
+
+	bDirty = false;
+	BuiltSerial = FollowerStatusSerial;
+}
+
+AActor* FPPInteractionIndex::GetTop(const APrincessPigCharacter* Owner, const TArray<AActor*>& Available)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PPInteractionIndexQuery);
+
+	if (nullptr == Owner)
+	{
+		return nullptr;
+	}
+
+	if (bDirty || BuiltSerial != FollowerStatusSerial)
+	{
+		Rebuild(Owner, Available);
+	}
+
+	// Break ties between the top candidates: prefer what we face, then what is close
+	const FVector Location = Owner->GetActorLocation();
+	const FVector Forward = Owner->GetActorForwardVector();
+	AActor* Best = nullptr;
+	float BestPriority = 0.f;
+	float BestTieBreak = -MAX_FLT;
+	for (const FPPInteractionCandidate& Candidate : Candidates)
+	{
+		if (Best && Candidate.Priority < BestPriority)
+		{
+			break;
+		}
+
+		AActor* Actor = Candidate.Actor.Get();
+		if (nullptr == Actor)
+		{
+			continue;
+		}
+
+		const FVector ToActor = Actor->GetActorLocation() - Location;
+		const float Distance = ToActor.Size2D();
+		const float Facing = Distance > KINDA_SMALL_NUMBER ? FVector::DotProduct(Forward, ToActor.GetSafeNormal2D()) : 1.f;
+		const float TieBreak = Facing * 1000.f - Distance;
+		if (TieBreak > BestTieBreak)
+		{
+			Best = Actor;
+			BestPriority = Candidate.Priority;
+			BestTieBreak = TieBreak;
+		}
+	}
+
+	return Best;
+}
@@ -0,0 +1,50 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AActor;
+class APrincessPigCharacter;
+
+struct FPPInteractionCandidate
+{
+	TWeakObjectPtr<AActor> Actor;
+	float Priority;
+};
+
+/**
+ * A character's available interactions, scored and sorted by priority.
+ *
+ * Scoring looks at tags, casts and follower lists, so it is only redone when the
+ * set of available interactions changes (MarkDirty) or any character's follower
+ * status changes (NotifyFollowerStatusChanged). Queries only break ties between
+ * the top scoring candidates, by facing and distance.
+ */
+class PRINCESSPIG_API FPPInteractionIndex
+{
+public:
+	FPPInteractionIndex();
+
+	void MarkDirty() { bDirty = true; }
+
+	/** Call whenever a character starts or stops following, or changes whether it can */
+	static void NotifyFollowerStatusChanged() { FollowerStatusSerial++; }
+
+	/** Best candidate out of Available for Owner right now, or null */
+	AActor* GetTop(const APrincessPigCharacter* Owner, const TArray<AActor*>& Available);
+
+	/** Priority of Candidate for Owner, 0 if it can't be interacted with */
+	static float ScoreCandidate(const APrincessPigCharacter* Owner, AActor* Candidate);
+
+private:
+	void Rebuild(const APrincessPigCharacter* Owner, const TArray<AActor*>& Available);
+
+	/** Highest priority first */
+	TArray<FPPInteractionCandidate> Candidates;
+
+	bool bDirty;
+	uint32 BuiltSerial;
+
+	static uint32 FollowerStatusSerial;
+};
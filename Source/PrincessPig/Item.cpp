@@ -2,7 +2,11 @@
 
 #include "Item.h"
 #include "PrincessPigCharacter.h"
+#include "ProximityService.h"
+#include "ActorPool.h"
 #include "Net/UnrealNetwork.h"
+#include "Engine/World.h"
+#include "TimerManager.h"
 
 // Sets default values
 AItem::AItem()
@@ -11,9 +15,153 @@ AItem::AItem()
 	PrimaryActorTick.bCanEverTick = false;
 	
 	SetReplicates(true);
+
+	bDormantWhenIdle = true;
+	DormancyDelay = 2.f;
+	bIsHeld = false;
+}
+
+void AItem::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Nobody has touched this item yet, so there is nothing to replicate after the initial bunch
+	if (HasAuthority() && bDormantWhenIdle)
+	{
+		SetNetDormancy(DORM_DormantAll);
+	}
+
+	// Interaction sensors find items through the proximity service. Pooled items register when handed out
+	if (IsInUse())
+	{
+		if (AProximityService* ProximityService = AProximityService::GetProximityService(this))
+		{
+			ProximityService->RegisterTarget(this);
+		}
+	}
+}
+
+void AItem::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (AProximityService* ProximityService = AProximityService::FindProximityService(this))
+	{
+		ProximityService->UnregisterTarget(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void AItem::Use(APrincessPigCharacter* PPUser)
 {
+	WakeNetDormancy();
 	BPEvent_OnUsed(PPUser);
 }
+
+APooledActor* AItem::AcquireFromPool(TSubclassOf<APooledActor> ActorClass, const FTransform& Transform)
+{
+	AActorPool* Pool = AActorPool::GetActorPool(this);
+	return Pool ? Pool->AcquireActor(ActorClass, Transform, this, Instigator) : nullptr;
+}
+
+void AItem::OnAcquiredFromPool()
+{
+	Super::OnAcquiredFromPool();
+
+	bIsHeld = false;
+	WakeNetDormancy();
+
+	if (AProximityService* ProximityService = AProximityService::GetProximityService(this))
+	{
+		ProximityService->RegisterTarget(this);
+	}
+}
+
+void AItem::OnReturnedToPool()
+{
+	if (AProximityService* ProximityService = AProximityService::FindProximityService(this))
+	{
+		ProximityService->UnregisterTarget(this);
+	}
+
+	GetWorldTimerManager().ClearTimer(DormancyTimer);
+	bIsHeld = false;
+
+	Super::OnReturnedToPool();
+}
+
+void AItem::PickedUp(APrincessPigCharacter* PPUser)
+{
+	bIsHeld = true;
+	WakeNetDormancy();
+	BPEvent_OnPickedUp(PPUser);
+}
+
+void AItem::Dropped()
+{
+	bIsHeld = false;
+	WakeNetDormancy();
+	BPEvent_OnDropped();
+}
+
+
+#pragma region Dormancy
+
+void AItem::WakeNetDormancy()
+{
+	if (!HasAuthority())
+	{
+		return;
+	}
+
+	if (NetDormancy > DORM_Awake)
+	{
+		SetNetDormancy(DORM_Awake);
+	}
+
+	// Check again later, the item might have been left alone by then
+	if (bDormantWhenIdle)
+	{
+		GetWorld()->GetTimerManager().SetTimer(DormancyTimer, this, &AItem::TryGoDormant, DormancyDelay, false);
+	}
+}
+
+void AItem::TryGoDormant()
+{
+	// Held items stay awake, Dropped() will check again
+	if (bIsHeld || IsPendingKillPending())
+	{
+		return;
+	}
+
+	// Still settling after a drop, try again later
+	if (!GetVelocity().IsNearlyZero(1.f))
+	{
+		GetWorld()->GetTimerManager().SetTimer(DormancyTimer, this, &AItem::TryGoDormant, DormancyDelay, false);
+		return;
+	}
+
+	SetNetDormancy(DORM_DormantAll);
+}
+
+#pragma endregion Dormancy
+
+
+#pragma region Relevancy
+
+bool AItem::IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const
+{
+	// Held items are relevant whenever their holder is
+	if (!CameraRelevancy.bEnabled ||
+		bAlwaysRelevant ||
+		bIsHeld ||
+		GetAttachParentActor() ||
+		IsOwnedBy(ViewTarget) ||
+		IsOwnedBy(RealViewer))
+	{
+		return Super::IsNetRelevantFor(RealViewer, ViewTarget, SrcLocation);
+	}
+
+	return CameraRelevancy.IsRelevant(GetActorLocation(), RealViewer, SrcLocation);
+}
+
+#pragma endregion Relevancy
@@ -3,14 +3,15 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "GameFramework/Actor.h"
+#include "PooledActor.h"
+#include "CameraRelevancy.h"
 #include "Item.generated.h"
 
 
 class APrincessPigCharacter;
 
 UCLASS()
-class PRINCESSPIG_API AItem : public AActor
+class PRINCESSPIG_API AItem : public APooledActor
 {
 	GENERATED_BODY()
 	
@@ -18,15 +19,65 @@ public:
 	// Sets default values for this actor's properties
 	AItem();
 
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	UFUNCTION(BlueprintCallable, Category = "Item")
 	virtual void Use(APrincessPigCharacter* PPUser);
 
+	/** Called by the character picking this item up */
+	virtual void PickedUp(APrincessPigCharacter* PPUser);
+
+	/** Called by the character dropping this item */
+	virtual void Dropped();
+
 	UFUNCTION(BlueprintImplementableEvent, BlueprintCallable, Category = "Item")
 	void BPEvent_OnUsed(APrincessPigCharacter* PPUser);
 
+	/** Server only. Get an effect (smoke etc.) from the actor pool rather than spawning it. Owned by this item */
+	UFUNCTION(BlueprintCallable, Category = "Item", meta = (DeterminesOutputType = "ActorClass"))
+	APooledActor* AcquireFromPool(TSubclassOf<APooledActor> ActorClass, const FTransform& Transform);
+
+	virtual void OnAcquiredFromPool() override;
+	virtual void OnReturnedToPool() override;
+
 	UFUNCTION(BlueprintImplementableEvent, BlueprintCallable, Category = "Item")
 	void BPEvent_OnPickedUp(APrincessPigCharacter* PPUser);
 
 	UFUNCTION(BlueprintImplementableEvent, BlueprintCallable, Category = "Item")
 	void BPEvent_OnDropped();
+
+
+#pragma region Dormancy
+
+	/** Lying-around items stop replicating until someone touches them */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Replication")
+	bool bDormantWhenIdle;
+
+	/** Seconds an item must stay put after being dropped before it goes dormant */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Replication")
+	float DormancyDelay;
+
+	FTimerHandle DormancyTimer;
+
+	bool bIsHeld;
+
+	UFUNCTION(BlueprintCallable, Category = "Replication")
+	void WakeNetDormancy();
+
+	UFUNCTION()
+	void TryGoDormant();
+
+#pragma endregion Dormancy
+
+
+#pragma region Relevancy
+
+	/** Items lying around are only relevant to clients whose camera can (nearly) see them */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Replication")
+	FPPCameraRelevancy CameraRelevancy;
+
+	virtual bool IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const override;
+
+#pragma endregion Relevancy
 };
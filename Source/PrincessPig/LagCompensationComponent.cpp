@@ -0,0 +1,224 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LagCompensationComponent.h"
+#include "PrincessPig.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/PrimitiveComponent.h"
+#include "HitboxProxyComponent.h"
+#include "GameFramework/Actor.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("Lag Compensation Record"), STAT_PPLagCompensationRecord, STATGROUP_PrincessPig);
+DECLARE_CYCLE_STAT(TEXT("Lag Compensation Rewind"), STAT_PPLagCompensationRewind, STATGROUP_PrincessPig);
+DECLARE_MEMORY_STAT(TEXT("Lag Compensation History"), STAT_PPLagCompensationMemory, STATGROUP_PrincessPig);
+
+ULagCompensationComponent::ULagCompensationComponent()
+{
+	// Record after movement has finished for the frame
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	PrimaryComponentTick.TickGroup = TG_PostPhysics;
+
+	MaxRewindTime = 0.4f;
+	SampleInterval = 1.f / 30.f;
+
+	Capsule = nullptr;
+	HitboxProxies = nullptr;
+	NumHitboxes = 0;
+	Head = 0;
+	NumFrames = 0;
+	TimeSinceLastSample = 0.f;
+}
+
+void ULagCompensationComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// History is only needed where hits get validated
+	AActor* Owner = GetOwner();
+	if (nullptr == Owner || !Owner->HasAuthority())
+	{
+		return;
+	}
+
+	Capsule = Cast<UCapsuleComponent>(Owner->GetRootComponent());
+
+	// Prefer the proxies, fall back to tagged components
+	HitboxProxies = Owner->FindComponentByClass<UHitboxProxyComponent>();
+	if (HitboxProxies && HitboxProxies->NumProxies() > 0)
+	{
+		NumHitboxes = HitboxProxies->NumProxies();
+	}
+	else
+	{
+		HitboxProxies = nullptr;
+		TArray<UActorComponent*> TaggedComponents = Owner->GetComponentsByTag(UPrimitiveComponent::StaticClass(), FName("Hitbox"));
+		for (UActorComponent* Component : TaggedComponents)
+		{
+			HitboxComponents.Add(CastChecked<UPrimitiveComponent>(Component));
+		}
+		NumHitboxes = HitboxComponents.Num();
+	}
+
+	// Enough frames to cover the rewind window, plus one either side for interpolation
+	const int32 Capacity = FMath::CeilToInt(MaxRewindTime / FMath::Max(SampleInterval, 0.001f)) + 2;
+	Frames.SetNumZeroed(Capacity);
+	HitboxOffsets.SetNumZeroed(Capacity * NumHitboxes);
+	HitboxRadii.SetNumUninitialized(NumHitboxes);
+	for (int32 i = 0; i < NumHitboxes; i++)
+	{
+		HitboxRadii[i] = HitboxProxies ? HitboxProxies->GetProxyRadius(i) : HitboxComponents[i]->Bounds.SphereRadius;
+	}
+
+	INC_MEMORY_STAT_BY(STAT_PPLagCompensationMemory, GetHistoryMemorySize());
+
+	SetComponentTickEnabled(true);
+	RecordFrame();
+}
+
+void ULagCompensationComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	DEC_MEMORY_STAT_BY(STAT_PPLagCompensationMemory, GetHistoryMemorySize());
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ULagCompensationComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	TimeSinceLastSample += DeltaTime;
+	if (TimeSinceLastSample >= SampleInterval)
+	{
+		TimeSinceLastSample = 0.f;
+		RecordFrame();
+	}
+}
+
+void ULagCompensationComponent::RecordFrame()
+{
+	SCOPE_CYCLE_COUNTER(STAT_PPLagCompensationRecord);
+
+	if (nullptr == Capsule || Frames.Num() == 0)
+	{
+		return;
+	}
+
+	Head = (Head + 1) % Frames.Num();
+	NumFrames = FMath::Min(NumFrames + 1, Frames.Num());
+
+	FPPHitboxFrame& Frame = Frames[Head];
+	Frame.Time = GetWorld()->GetTimeSeconds();
+	Frame.CapsuleLocation = Capsule->GetComponentLocation();
+	Frame.CapsuleRotation = Capsule->GetComponentQuat();
+
+	// Hitboxes are stored relative to the capsule so that they interpolate with it
+	for (int32 i = 0; i < NumHitboxes; i++)
+	{
+		const FVector Centre = GetHitboxCentre(i);
+		HitboxOffsets[Head * NumHitboxes + i] = Frame.CapsuleRotation.UnrotateVector(Centre - Frame.CapsuleLocation);
+	}
+}
+
+FVector ULagCompensationComponent::GetHitboxCentre(int32 Index) const
+{
+	if (HitboxProxies)
+	{
+		return HitboxProxies->GetProxyLocation(Index);
+	}
+	if (HitboxComponents[Index])
+	{
+		return HitboxComponents[Index]->Bounds.Origin;
+	}
+	return Capsule->GetComponentLocation();
+}
+
+float ULagCompensationComponent::ClampRewindTime(float RequestedTime) const
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+	return FMath::Clamp(RequestedTime, Now - MaxRewindTime, Now);
+}
+
+bool ULagCompensationComponent::GetRewoundFrame(float Time, FPPRewoundFrame& OutFrame) const
+{
+	if (NumFrames == 0 || nullptr == Capsule)
+	{
+		return false;
+	}
+
+	// Walk back from the newest frame until we pass the requested time
+	int32 NewerAge = 0;
+	int32 OlderAge = 0;
+	for (int32 Age = 0; Age < NumFrames; Age++)
+	{
+		OlderAge = Age;
+		if (GetFrame(Age).Time <= Time)
+		{
+			break;
+		}
+		NewerAge = Age;
+	}
+
+	const FPPHitboxFrame& Newer = GetFrame(NewerAge);
+	const FPPHitboxFrame& Older = GetFrame(OlderAge);
+	const float Span = Newer.Time - Older.Time;
+	const float Alpha = (Span > KINDA_SMALL_NUMBER) ? FMath::Clamp((Time - Older.Time) / Span, 0.f, 1.f) : 1.f;
+
+	OutFrame.CapsuleLocation = FMath::Lerp(Older.CapsuleLocation, Newer.CapsuleLocation, Alpha);
+	OutFrame.CapsuleRotation = FQuat::Slerp(Older.CapsuleRotation, Newer.CapsuleRotation, Alpha);
+	OutFrame.CapsuleRadius = Capsule->GetScaledCapsuleRadius();
+	OutFrame.CapsuleHalfHeight = Capsule->GetScaledCapsuleHalfHeight();
+
+	const int32 NewerIndex = (Head - NewerAge + Frames.Num()) % Frames.Num();
+	const int32 OlderIndex = (Head - OlderAge + Frames.Num()) % Frames.Num();
+	OutFrame.HitboxCentres.Reset();
+	for (int32 i = 0; i < NumHitboxes; i++)
+	{
+		const FVector Offset = FMath::Lerp(HitboxOffsets[OlderIndex * NumHitboxes + i], HitboxOffsets[NewerIndex * NumHitboxes + i], Alpha);
+		OutFrame.HitboxCentres.Add(OutFrame.CapsuleLocation + OutFrame.CapsuleRotation.RotateVector(Offset));
+	}
+
+	return true;
+}
+
+bool ULagCompensationComponent::SweepHitsAtTime(FVector Start, FVector End, float Radius, float Time) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_PPLagCompensationRewind);
+
+	FPPRewoundFrame Frame;
+	if (!GetRewoundFrame(ClampRewindTime(Time), Frame))
+	{
+		return false;
+	}
+
+	// Capsule: compare the sweep against the capsule's core segment
+	const FVector CapsuleUp = Frame.CapsuleRotation.GetUpVector();
+	const float CoreHalfHeight = FMath::Max(0.f, Frame.CapsuleHalfHeight - Frame.CapsuleRadius);
+	FVector SweepPoint, CapsulePoint;
+	FMath::SegmentDistToSegmentSafe(
+		Start, End,
+		Frame.CapsuleLocation - CapsuleUp * CoreHalfHeight,
+		Frame.CapsuleLocation + CapsuleUp * CoreHalfHeight,
+		SweepPoint, CapsulePoint);
+	if (FVector::DistSquared(SweepPoint, CapsulePoint) <= FMath::Square(Radius + Frame.CapsuleRadius))
+	{
+		return true;
+	}
+
+	// Hitboxes: spheres around their centres
+	for (int32 i = 0; i < Frame.HitboxCentres.Num(); i++)
+	{
+		const FVector Closest = FMath::ClosestPointOnSegment(Frame.HitboxCentres[i], Start, End);
+		if (FVector::DistSquared(Closest, Frame.HitboxCentres[i]) <= FMath::Square(Radius + HitboxRadii[i]))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+SIZE_T ULagCompensationComponent::GetHistoryMemorySize() const
+{
+	return Frames.GetAllocatedSize() + HitboxOffsets.GetAllocatedSize() + HitboxRadii.GetAllocatedSize();
+}
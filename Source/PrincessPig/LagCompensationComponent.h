@@ -0,0 +1,105 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "LagCompensationComponent.generated.h"
+
+class UCapsuleComponent;
+class UPrimitiveComponent;
+class UHitboxProxyComponent;
+
+/** Where a character's capsule was at some point in time */
+struct FPPHitboxFrame
+{
+	float Time;
+	FVector CapsuleLocation;
+	FQuat CapsuleRotation;
+};
+
+/** A frame rebuilt for a time between two recorded frames */
+struct FPPRewoundFrame
+{
+	FVector CapsuleLocation;
+	FQuat CapsuleRotation;
+	float CapsuleRadius;
+	float CapsuleHalfHeight;
+
+	/** World space centres of the hitboxes */
+	TArray<FVector, TInlineAllocator<8>> HitboxCentres;
+};
+
+/**
+ * Server-side history of where a character's capsule and hitboxes were.
+ *
+ * Every SampleInterval the server writes the current transforms into a ring buffer
+ * covering MaxRewindTime. Hit checks for player strikes can then be made against
+ * the positions the striking client actually saw, instead of the server's current ones.
+ *
+ * Hitboxes come from the owner's UHitboxProxyComponent if it has any proxies. Otherwise
+ * any primitive components tagged "Hitbox" are used, as spheres of their bounds radius.
+ */
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class PRINCESSPIG_API ULagCompensationComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	ULagCompensationComponent();
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/** How far back a hit check may rewind. Clients with a worse ping get their hits checked at this age */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "LagCompensation")
+	float MaxRewindTime;
+
+	/** Seconds between recorded frames. Times in between are interpolated */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "LagCompensation")
+	float SampleInterval;
+
+	/** Clamp a time reported by a client to the window we have history for */
+	float ClampRewindTime(float RequestedTime) const;
+
+	/** Rebuild the capsule and hitboxes at Time. Returns false if there is no history yet */
+	bool GetRewoundFrame(float Time, FPPRewoundFrame& OutFrame) const;
+
+	/** Does a sphere swept from Start to End touch the capsule or any hitbox as they were at Time? */
+	UFUNCTION(BlueprintCallable, Category = "LagCompensation")
+	bool SweepHitsAtTime(FVector Start, FVector End, float Radius, float Time) const;
+
+	/** Memory held by the history buffers, in bytes */
+	SIZE_T GetHistoryMemorySize() const;
+
+protected:
+	void RecordFrame();
+
+	UPROPERTY(Transient)
+	UCapsuleComponent* Capsule;
+
+	UPROPERTY(Transient)
+	UHitboxProxyComponent* HitboxProxies;
+
+	UPROPERTY(Transient)
+	TArray<UPrimitiveComponent*> HitboxComponents;
+
+	int32 NumHitboxes;
+
+	FVector GetHitboxCentre(int32 Index) const;
+
+	/** Hitbox offsets from the capsule, one block of NumHitboxes per frame */
+	TArray<FVector> HitboxOffsets;
+	TArray<float> HitboxRadii;
+
+	TArray<FPPHitboxFrame> Frames;
+
+	/** Index of the newest frame, and how many frames hold valid data */
+	int32 Head;
+	int32 NumFrames;
+
+	float TimeSinceLastSample;
+
+	const FPPHitboxFrame& GetFrame(int32 Age) const { return Frames[(Head - Age + Frames.Num()) % Frames.Num()]; }
+};
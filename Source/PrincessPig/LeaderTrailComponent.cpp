@@ -0,0 +1,154 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "LeaderTrailComponent.h"
+#include "PrincessPig.h"
+#include "GameFramework/Actor.h"
+#include "Engine/World.h"
+#include "NavigationSystem.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Trail Crumbs Dropped"), STAT_PPTrailCrumbsDropped, STATGROUP_PrincessPig);
+
+ULeaderTrailComponent::ULeaderTrailComponent()
+{
+	// Only ticks while recording, and doesn't need to every frame
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	PrimaryComponentTick.TickGroup = TG_PostPhysics;
+	PrimaryComponentTick.TickInterval = 0.1f;
+
+	CrumbSpacing = 100.f;
+	MaxCrumbs = 48;
+
+	Head = 0;
+	Num = 0;
+}
+
+void ULeaderTrailComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	Crumbs.SetNumZeroed(FMath::Max(MaxCrumbs, 2));
+}
+
+void ULeaderTrailComponent::SetRecording(bool bRecord)
+{
+	AActor* Owner = GetOwner();
+	if (nullptr == Owner || !Owner->HasAuthority() || bRecord == IsComponentTickEnabled())
+	{
+		return;
+	}
+
+	Head = 0;
+	Num = 0;
+	if (bRecord)
+	{
+		DropCrumb(Owner->GetActorLocation());
+	}
+	SetComponentTickEnabled(bRecord);
+}
+
+void ULeaderTrailComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	const FVector Location = GetOwner()->GetActorLocation();
+	if (Num == 0 || FVector::DistSquared(Location, GetCrumb(0)) >= FMath::Square(CrumbSpacing))
+	{
+		DropCrumb(Location);
+	}
+}
+
+void ULeaderTrailComponent::DropCrumb(const FVector& Location)
+{
+	// Only keep points followers can actually stand on
+	FNavLocation NavLocation;
+	UNavigationSystemV1* NavSys = UNavigationSystemV1::GetNavigationSystem(this);
+	if (nullptr == NavSys || !NavSys->ProjectPointToNavigation(Location, NavLocation, FVector(CrumbSpacing * 0.5f, CrumbSpacing * 0.5f, 200.f)))
+	{
+		return;
+	}
+
+	Head = (Head + 1) % Crumbs.Num();
+	Crumbs[Head] = NavLocation.Location;
+	Num = FMath::Min(Num + 1, Crumbs.Num());
+
+	INC_DWORD_STAT(STAT_PPTrailCrumbsDropped);
+}
+
+bool ULeaderTrailComponent::GetPointBehind(float Distance, FVector& OutLocation) const
+{
+	if (Num == 0)
+	{
+		OutLocation = GetOwner()->GetActorLocation();
+		return false;
+	}
+
+	// Walk back from the owner through the crumbs, newest first
+	FVector Previous = GetOwner()->GetActorLocation();
+	float Remaining = Distance;
+	for (int32 Age = 0; Age < Num; Age++)
+	{
+		const FVector& Crumb = GetCrumb(Age);
+		const float SegmentLength = FVector::Dist(Previous, Crumb);
+		if (SegmentLength >= Remaining)
+		{
+			OutLocation = FMath::Lerp(Previous, Crumb, SegmentLength > KINDA_SMALL_NUMBER ? Remaining / SegmentLength : 0.f);
+			return true;
+		}
+		Remaining -= SegmentLength;
+		Previous = Crumb;
+	}
+
+	OutLocation = Previous;
+	return false;
+}
+
+float ULeaderTrailComponent::GetDistanceSquaredToTrail(const FVector& Location, FVector& OutClosestCrumb) const
+{
+	float BestDistanceSquared = BIG_NUMBER;
+	for (int32 Age = 0; Age < Num; Age++)
+	{
+		const float DistanceSquared = FVector::DistSquared(Location, GetCrumb(Age));
+		if (DistanceSquared < BestDistanceSquared)
+		{
+			BestDistanceSquared = DistanceSquared;
+			OutClosestCrumb = GetCrumb(Age);
+		}
+	}
+	return BestDistanceSquared;
+}
+
+int32 ULeaderTrailComponent::FindClosestCrumb(const FVector& Location) const
+{
+	int32 BestAge = INDEX_NONE;
+	float BestDistanceSquared = BIG_NUMBER;
+	for (int32 Age = 0; Age < Num; Age++)
+	{
+		const float DistanceSquared = FVector::DistSquared(Location, GetCrumb(Age));
+		if (DistanceSquared < BestDistanceSquared)
+		{
+			BestDistanceSquared = DistanceSquared;
+			BestAge = Age;
+		}
+	}
+	return BestAge;
+}
+
+FVector ULeaderTrailComponent::GetPointAlongTrail(int32 FromAge, int32 ToAge, float Distance) const
+{
+	const int32 Step = ToAge >= FromAge ? 1 : -1;
+	FVector Previous = GetCrumb(FromAge);
+	float Remaining = Distance;
+	for (int32 Age = FromAge + Step; Age != ToAge + Step; Age += Step)
+	{
+		const FVector& Crumb = GetCrumb(Age);
+		const float SegmentLength = FVector::Dist(Previous, Crumb);
+		if (SegmentLength >= Remaining)
+		{
+			return FMath::Lerp(Previous, Crumb, SegmentLength > KINDA_SMALL_NUMBER ? Remaining / SegmentLength : 0.f);
+		}
+		Remaining -= SegmentLength;
+		Previous = Crumb;
+	}
+	return Previous;
+}
@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "LeaderTrailComponent.generated.h"
+
+/**
+ * Server-side breadcrumb trail left by a character while it has followers.
+ *
+ * Every CrumbSpacing the owner moves, its location is projected onto the navmesh and
+ * written into a ring buffer. Followers walk along the trail to a point some distance
+ * behind the leader (see UBTT_FollowLeaderTrail), which keeps them on walkable ground
+ * without each of them pathfinding to the leader over and over.
+ */
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class PRINCESSPIG_API ULeaderTrailComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	ULeaderTrailComponent();
+
+	virtual void BeginPlay() override;
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/** Distance the owner moves between crumbs */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Follow")
+	float CrumbSpacing;
+
+	/** Crumbs kept. The trail covers about MaxCrumbs * CrumbSpacing */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Follow")
+	int32 MaxCrumbs;
+
+	/** Start recording from the owner's current location, or stop and forget the trail */
+	void SetRecording(bool bRecord);
+
+	/**
+	 * Point Distance back along the trail from the owner. Returns false if the trail is
+	 * shorter than that, in which case OutLocation is the oldest crumb.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Follow")
+	bool GetPointBehind(float Distance, FVector& OutLocation) const;
+
+	/** Squared distance from Location to the closest crumb, or BIG_NUMBER if there are none */
+	float GetDistanceSquaredToTrail(const FVector& Location, FVector& OutClosestCrumb) const;
+
+	/** Age of the crumb closest to Location (0 is the newest), or INDEX_NONE if there are none */
+	int32 FindClosestCrumb(const FVector& Location) const;
+
+	/**
+	 * Point Distance along the trail from crumb FromAge towards crumb ToAge, following the
+	 * crumbs round corners rather than cutting across. Stops at ToAge
+	 */
+	FVector GetPointAlongTrail(int32 FromAge, int32 ToAge, float Distance) const;
+
+	int32 NumCrumbs() const { return Num; }
+
+protected:
+	void DropCrumb(const FVector& Location);
+
+	TArray<FVector> Crumbs;
+
+	/** Index of the newest crumb, and how many crumbs hold valid data */
+	int32 Head;
+	int32 Num;
+
+	const FVector& GetCrumb(int32 Age) const { return Crumbs[(Head - Age + Crumbs.Num()) % Crumbs.Num()]; }
+};
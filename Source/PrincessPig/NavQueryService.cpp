@@ -0,0 +1,275 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "NavQueryService.h"
+#include "PrincessPig.h"
+#include "AIController.h"
+#include "AITypes.h"
+#include "NavigationSystem.h"
+#include "NavFilters/NavigationQueryFilter.h"
+#include "Components/SceneComponent.h"
+#include "GameFramework/Pawn.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "WorldActorCache.h"
+
+DECLARE_CYCLE_STAT(TEXT("Nav Query Projections"), STAT_PPNavQueryProjections, STATGROUP_PrincessPig);
+DECLARE_CYCLE_STAT(TEXT("Nav Query Send Paths"), STAT_PPNavQuerySendPaths, STATGROUP_PrincessPig);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Nav Projections"), STAT_PPNavProjections, STATGROUP_PrincessPig);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Nav Async Path Queries"), STAT_PPNavPathQueries, STATGROUP_PrincessPig);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Nav Stale Results"), STAT_PPNavStaleResults, STATGROUP_PrincessPig);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Nav Queued Queries"), STAT_PPNavQueuedQueries, STATGROUP_PrincessPig);
+
+ANavQueryService::ANavQueryService()
+{
+	// Run after the AI has ticked, so anything asked for this frame goes out this frame
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickGroup = TG_PostPhysics;
+
+	bReplicates = false;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>("Root");
+
+	bEnabled = true;
+	MaxProjectionsPerFrame = 32;
+	MaxPathQueriesPerFrame = 8;
+
+	PathQueryDelegate = FNavPathQueryDelegate::CreateUObject(this, &ANavQueryService::OnPathQueryFinished);
+}
+
+void ANavQueryService::BeginPlay()
+{
+	Super::BeginPlay();
+
+	TPPWorldActorCache<ANavQueryService>::Add(this);
+}
+
+void ANavQueryService::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	TPPWorldActorCache<ANavQueryService>::Remove(this);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+ANavQueryService* ANavQueryService::GetNavQueryService(const UObject* WorldContextObject)
+{
+	if (!GetDefault<ANavQueryService>()->bEnabled)
+	{
+		return nullptr;
+	}
+
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::ReturnNull);
+	if (nullptr == World || World->IsNetMode(NM_Client))
+	{
+		return nullptr;
+	}
+
+	if (ANavQueryService* Existing = FindNavQueryService(World))
+	{
+		return Existing;
+	}
+
+	// Cached now as well as in BeginPlay, in case play hasn't begun yet
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.ObjectFlags |= RF_Transient;
+	ANavQueryService* Service = World->SpawnActor<ANavQueryService>(SpawnParams);
+	if (Service)
+	{
+		TPPWorldActorCache<ANavQueryService>::Add(Service);
+	}
+	return Service;
+}
+
+ANavQueryService* ANavQueryService::FindNavQueryService(const UObject* WorldContextObject)
+{
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::ReturnNull);
+	return TPPWorldActorCache<ANavQueryService>::Find(World);
+}
+
+void ANavQueryService::RequestProjection(const UObject* Requester, const FVector& Location, const FPPNavProjectionDelegate& OnDone)
+{
+	// Replace in place, so asking again doesn't lose our place in the queue
+	FPPNavProjectionRequest* Queued = QueuedProjections.FindByPredicate([Requester](const FPPNavProjectionRequest& Request) { return Request.Requester == Requester; });
+	if (Queued)
+	{
+		INC_DWORD_STAT(STAT_PPNavStaleResults);
+	}
+	else
+	{
+		Queued = &QueuedProjections.AddDefaulted_GetRef();
+		Queued->Requester = Requester;
+	}
+	Queued->Location = Location;
+	Queued->OnDone = OnDone;
+}
+
+void ANavQueryService::RequestMove(AAIController* Controller, const FVector& Goal, float AcceptanceRadius)
+{
+	CancelMove(Controller);
+
+	FPPNavMoveRequest& Request = QueuedMoves.AddDefaulted_GetRef();
+	Request.Controller = Controller;
+	Request.Goal = Goal;
+	Request.AcceptanceRadius = AcceptanceRadius;
+	Request.QueryId = INVALID_NAVQUERYID;
+}
+
+void ANavQueryService::CancelMove(const AAIController* Controller)
+{
+	QueuedMoves.RemoveAll([Controller](const FPPNavMoveRequest& Request) { return Request.Controller == Controller; });
+
+	// Whatever comes back for a dropped query is ignored, but there's no point finishing it
+	UNavigationSystemV1* NavSys = UNavigationSystemV1::GetNavigationSystem(this);
+	for (int32 i = PathQueries.Num() - 1; i >= 0; i--)
+	{
+		if (PathQueries[i].Controller == Controller)
+		{
+			if (NavSys)
+			{
+				NavSys->AbortAsyncFindPathRequest(PathQueries[i].QueryId);
+			}
+			PathQueries.RemoveAtSwap(i);
+			INC_DWORD_STAT(STAT_PPNavStaleResults);
+		}
+	}
+}
+
+bool ANavQueryService::HasPendingMove(const AAIController* Controller) const
+{
+	auto IsController = [Controller](const FPPNavMoveRequest& Request) { return Request.Controller == Controller; };
+	return QueuedMoves.ContainsByPredicate(IsController) || PathQueries.ContainsByPredicate(IsController);
+}
+
+void ANavQueryService::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	ProcessProjections();
+	SendPathQueries();
+
+	SET_DWORD_STAT(STAT_PPNavQueuedQueries, QueuedProjections.Num() + QueuedMoves.Num() + PathQueries.Num());
+}
+
+void ANavQueryService::ProcessProjections()
+{
+	if (QueuedProjections.Num() == 0)
+	{
+		return;
+	}
+
+	UNavigationSystemV1* NavSys = UNavigationSystemV1::GetNavigationSystem(this);
+	const ANavigationData* NavData = NavSys ? NavSys->GetDefaultNavDataInstance(FNavigationSystem::DontCreate) : nullptr;
+
+	// Take this frame's batch off the queue first, callbacks may well ask again
+	const int32 NumBatched = NavData ? FMath::Min(QueuedProjections.Num(), FMath::Max(MaxProjectionsPerFrame, 1)) : QueuedProjections.Num();
+	TArray<FPPNavProjectionRequest> Batch;
+	Batch.Append(QueuedProjections.GetData(), NumBatched);
+	QueuedProjections.RemoveAt(0, NumBatched, false);
+
+	if (nullptr == NavData)
+	{
+		for (const FPPNavProjectionRequest& Request : Batch)
+		{
+			Request.OnDone.ExecuteIfBound(false, Request.Location);
+		}
+		return;
+	}
+
+	TArray<FNavigationProjectionWork> Workload;
+	{
+		SCOPE_CYCLE_COUNTER(STAT_PPNavQueryProjections);
+		INC_DWORD_STAT_BY(STAT_PPNavProjections, NumBatched);
+
+		Workload.Reserve(NumBatched);
+		for (const FPPNavProjectionRequest& Request : Batch)
+		{
+			Workload.Add(FNavigationProjectionWork(Request.Location));
+		}
+
+		// Same extent and filter ProjectPointToNavigation uses by default
+		NavData->BatchProjectPoints(Workload, NavData->GetConfig().DefaultQueryExtent, NavData->GetDefaultQueryFilter(), this);
+	}
+
+	for (int32 i = 0; i < NumBatched; i++)
+	{
+		if (Batch[i].Requester.IsValid())
+		{
+			Batch[i].OnDone.ExecuteIfBound(Workload[i].bResult, Workload[i].bResult ? Workload[i].OutLocation.Location : Batch[i].Location);
+		}
+	}
+}
+
+void ANavQueryService::SendPathQueries()
+{
+	if (QueuedMoves.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_PPNavQuerySendPaths);
+
+	UNavigationSystemV1* NavSys = UNavigationSystemV1::GetNavigationSystem(this);
+	if (nullptr == NavSys)
+	{
+		QueuedMoves.Reset();
+		return;
+	}
+
+	int32 NumSent = 0;
+	while (QueuedMoves.Num() > 0 && NumSent < MaxPathQueriesPerFrame)
+	{
+		FPPNavMoveRequest Request = QueuedMoves[0];
+		QueuedMoves.RemoveAt(0, 1, false);
+
+		AAIController* Controller = Request.Controller.Get();
+		APawn* Pawn = Controller ? Controller->GetPawn() : nullptr;
+		if (nullptr == Pawn)
+		{
+			continue;
+		}
+
+		const FNavAgentProperties& AgentProperties = Pawn->GetNavAgentPropertiesRef();
+		const ANavigationData* NavData = NavSys->GetNavDataForProps(AgentProperties);
+		if (nullptr == NavData)
+		{
+			continue;
+		}
+
+		// The same query MoveToLocation would make
+		FPathFindingQuery Query(Controller, *NavData, Pawn->GetNavAgentLocation(), Request.Goal,
+			UNavigationQueryFilter::GetQueryFilter(*NavData, Controller, Controller->GetDefaultNavigationFilterClass()));
+		Query.SetAllowPartialPaths(true);
+
+		Request.QueryId = NavSys->FindPathAsync(AgentProperties, Query, PathQueryDelegate);
+		if (Request.QueryId != INVALID_NAVQUERYID)
+		{
+			PathQueries.Add(Request);
+		}
+		NumSent++;
+		INC_DWORD_STAT(STAT_PPNavPathQueries);
+	}
+}
+
+void ANavQueryService::OnPathQueryFinished(uint32 QueryId, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path)
+{
+	const int32 Index = PathQueries.IndexOfByPredicate([QueryId](const FPPNavMoveRequest& Request) { return Request.QueryId == QueryId; });
+	if (Index == INDEX_NONE)
+	{
+		// Replaced or cancelled since it was sent, and already counted as stale by CancelMove
+		return;
+	}
+
+	const FPPNavMoveRequest Request = PathQueries[Index];
+	PathQueries.RemoveAtSwap(Index);
+
+	AAIController* Controller = Request.Controller.Get();
+	if (nullptr == Controller || nullptr == Controller->GetPawn() || Result != ENavigationQueryResult::Success || !Path.IsValid())
+	{
+		return;
+	}
+
+	FAIMoveRequest MoveRequest(Request.Goal);
+	MoveRequest.SetAcceptanceRadius(Request.AcceptanceRadius);
+	MoveRequest.SetAllowPartialPath(true);
+	MoveRequest.SetNavigationFilter(Controller->GetDefaultNavigationFilterClass());
+	Controller->RequestMove(MoveRequest, Path);
+}
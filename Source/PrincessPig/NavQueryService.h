@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "NavigationData.h"
+#include "NavQueryService.generated.h"
+
+class AAIController;
+
+/** Result of a projection: whether a point on the navmesh was found, and where */
+DECLARE_DELEGATE_TwoParams(FPPNavProjectionDelegate, bool /*bSuccess*/, const FVector& /*Location*/);
+
+struct FPPNavProjectionRequest
+{
+	TWeakObjectPtr<const UObject> Requester;
+	FVector Location;
+	FPPNavProjectionDelegate OnDone;
+};
+
+struct FPPNavMoveRequest
+{
+	TWeakObjectPtr<AAIController> Controller;
+	FVector Goal;
+	float AcceptanceRadius;
+
+	/** Set once the path query has been sent */
+	uint32 QueryId;
+};
+
+/**
+ * Server-side queue that keeps navigation queries off the game thread, or at least spreads them out.
+ *
+ * Projections are collected through the frame and projected together in one batch, up to
+ * MaxProjectionsPerFrame. Moves are pathfound with FindPathAsync on the navigation system's
+ * worker, at most MaxPathQueriesPerFrame sent per frame, and the controller starts following the
+ * path when it comes back. Results come back on the game thread a frame or more later.
+ *
+ * Each requester has at most one projection and one move in flight. Asking again replaces the
+ * earlier request, and the answer to a replaced or cancelled request is thrown away rather than
+ * acted on late. AI controllers cancel their pending move in StopMovement.
+ *
+ * Settings can be changed in DefaultGame.ini under [/Script/PrincessPig.NavQueryService].
+ */
+UCLASS(NotPlaceable, Transient, Config = Game)
+class PRINCESSPIG_API ANavQueryService : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ANavQueryService();
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Find or spawn the service for this world. Returns null on clients, or if bEnabled is off */
+	static ANavQueryService* GetNavQueryService(const UObject* WorldContextObject);
+
+	/** Find the service without spawning one */
+	static ANavQueryService* FindNavQueryService(const UObject* WorldContextObject);
+
+	/** Queue navigation queries instead of running them straight away */
+	UPROPERTY(Config, EditAnywhere, Category = "Navigation")
+	bool bEnabled;
+
+	UPROPERTY(Config, EditAnywhere, Category = "Navigation")
+	int32 MaxProjectionsPerFrame;
+
+	UPROPERTY(Config, EditAnywhere, Category = "Navigation")
+	int32 MaxPathQueriesPerFrame;
+
+	/** Project Location onto the default navmesh, replacing any projection Requester is still waiting for */
+	void RequestProjection(const UObject* Requester, const FVector& Location, const FPPNavProjectionDelegate& OnDone);
+
+	/**
+	 * Pathfind from Controller's pawn to Goal, then have Controller follow the path. Replaces any
+	 * move Controller is still waiting for. If no path is found, Controller doesn't move
+	 */
+	void RequestMove(AAIController* Controller, const FVector& Goal, float AcceptanceRadius);
+
+	/** Forget any move Controller is waiting for */
+	void CancelMove(const AAIController* Controller);
+
+	/** Is Controller waiting for a path? */
+	bool HasPendingMove(const AAIController* Controller) const;
+
+protected:
+	TArray<FPPNavProjectionRequest> QueuedProjections;
+
+	/** Moves waiting to be sent, and sent moves waiting for a path */
+	TArray<FPPNavMoveRequest> QueuedMoves;
+	TArray<FPPNavMoveRequest> PathQueries;
+
+	FNavPathQueryDelegate PathQueryDelegate;
+
+	void ProcessProjections();
+	void SendPathQueries();
+	void OnPathQueryFinished(uint32 QueryId, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path);
+};
@@ -1,6 +1,7 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "Objective.h"
+#include "CharacterRegistry.h"
 #include "Engine/World.h"
 
 #include "DrawDebugHelpers.h"
@@ -11,12 +12,14 @@ UObjective::UObjective()
 	TargetActor = nullptr;
 	LastKnownLocation = FVector::ZeroVector;
 	LastKnownVelocity = FVector::ZeroVector;
+	TargetRegistryIndex = INDEX_NONE;
 }
 
 void UObjective::ChangeObjective(EObjectiveType NewType, AActor* NewTargetActor)
 {
 	Type = NewType;
 	TargetActor = NewTargetActor;
+	TargetRegistryIndex = INDEX_NONE;
 	if (NewTargetActor)
 	{
 		LastKnownLocation = NewTargetActor->GetActorLocation();
@@ -49,15 +52,32 @@ void UObjective::Refresh()
 {
 	if (TargetActor)
 	{
-		LastKnownLocation = TargetActor->GetActorLocation();
-		LastKnownVelocity = TargetActor->GetVelocity();
+		// Characters are read from the registry's snapshot when they are in it
+		int32 Index;
+		if (const ACharacterRegistry* Registry = ACharacterRegistry::FindSlot(TargetActor, Index))
+		{
+			LastKnownLocation = Registry->GetLocation(Index);
+			LastKnownVelocity = Registry->GetVelocity(Index);
+		}
+		else
+		{
+			LastKnownLocation = TargetActor->GetActorLocation();
+			LastKnownVelocity = TargetActor->GetVelocity();
+		}
 	}
 }
 
+void UObjective::SetLastKnown(const FVector& Location, const FVector& Velocity)
+{
+	LastKnownLocation = Location;
+	LastKnownVelocity = Velocity;
+}
+
 void UObjective::Clear()
 {
 	Type = EObjectiveType::None;
 	TargetActor = nullptr;
+	TargetRegistryIndex = INDEX_NONE;
 	LastKnownLocation = FVector::ZeroVector;
 	LastKnownVelocity = FVector::ZeroVector;
 }
@@ -56,6 +56,12 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Objective")
 	void Refresh();
 
+	/** Refresh with a location and velocity already read, e.g. from ACharacterRegistry */
+	void SetLastKnown(const FVector& Location, const FVector& Velocity);
+
+	/** Where AGuardObjectiveStage last found TargetActor in ACharacterRegistry, tried first next frame */
+	int32 TargetRegistryIndex;
+
 	// Reset objective to initial state
 	UFUNCTION(BlueprintCallable, Category = "Objective")
 	void Clear();
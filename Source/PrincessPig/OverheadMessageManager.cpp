@@ -0,0 +1,182 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "OverheadMessageManager.h"
+#include "PrincessPig.h"
+#include "Components/SceneComponent.h"
+#include "Components/TextRenderComponent.h"
+#include "Camera/PlayerCameraManager.h"
+#include "GameFramework/PlayerController.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "WorldActorCache.h"
+
+DECLARE_CYCLE_STAT(TEXT("Overhead Messages Tick"), STAT_PPOverheadMessagesTick, STATGROUP_PrincessPig);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Overhead Messages Active"), STAT_PPOverheadMessagesActive, STATGROUP_PrincessPig);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Overhead Message Billboards"), STAT_PPOverheadMessageBillboards, STATGROUP_PrincessPig);
+
+AOverheadMessageManager::AOverheadMessageManager()
+{
+	// Only ticks while a message is showing, and after everything has moved
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
+	PrimaryActorTick.TickGroup = TG_PostUpdateWork;
+
+	bReplicates = false;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>("Root");
+
+	InitialPoolSize = 8;
+	TextWorldSize = 100.f;
+}
+
+void AOverheadMessageManager::BeginPlay()
+{
+	Super::BeginPlay();
+
+	TPPWorldActorCache<AOverheadMessageManager>::Add(this);
+}
+
+void AOverheadMessageManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	TPPWorldActorCache<AOverheadMessageManager>::Remove(this);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+AOverheadMessageManager* AOverheadMessageManager::Get(const UObject* WorldContextObject)
+{
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::ReturnNull);
+	if (nullptr == World || World->GetNetMode() == NM_DedicatedServer)
+	{
+		return nullptr;
+	}
+
+	if (AOverheadMessageManager* Existing = TPPWorldActorCache<AOverheadMessageManager>::Find(World))
+	{
+		return Existing;
+	}
+
+	// Cached now as well as in BeginPlay, in case play hasn't begun yet
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.ObjectFlags |= RF_Transient;
+	AOverheadMessageManager* Manager = World->SpawnActor<AOverheadMessageManager>(SpawnParams);
+	if (Manager)
+	{
+		TPPWorldActorCache<AOverheadMessageManager>::Add(Manager);
+		for (int32 i = 0; i < Manager->InitialPoolSize; i++)
+		{
+			Manager->FreeBillboards.Add(Manager->AcquireBillboard());
+		}
+	}
+	return Manager;
+}
+
+AOverheadMessageManager* AOverheadMessageManager::Find(const UObject* WorldContextObject)
+{
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::ReturnNull);
+	return TPPWorldActorCache<AOverheadMessageManager>::Find(World);
+}
+
+UTextRenderComponent* AOverheadMessageManager::AcquireBillboard()
+{
+	if (FreeBillboards.Num() > 0)
+	{
+		return FreeBillboards.Pop(false);
+	}
+
+	UTextRenderComponent* Billboard = NewObject<UTextRenderComponent>(this);
+	Billboard->SetupAttachment(RootComponent);
+	Billboard->SetHorizontalAlignment(EHorizTextAligment::EHTA_Center);
+	Billboard->SetVerticalAlignment(EVerticalTextAligment::EVRTA_TextCenter);
+	Billboard->SetWorldSize(TextWorldSize);
+	Billboard->SetAbsolute(true, true, true);
+	Billboard->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Billboard->SetGenerateOverlapEvents(false);
+	Billboard->SetHiddenInGame(true);
+	Billboard->RegisterComponent();
+
+	INC_DWORD_STAT(STAT_PPOverheadMessageBillboards);
+	return Billboard;
+}
+
+void AOverheadMessageManager::ShowMessage(AActor* Speaker, const FText& Message, FColor Color, float Duration, FVector Offset)
+{
+	if (nullptr == Speaker)
+	{
+		return;
+	}
+
+	// A new message from the same speaker takes over its billboard
+	FPPOverheadMessage* Entry = ActiveMessages.FindByPredicate([Speaker](const FPPOverheadMessage& Active) { return Active.Speaker == Speaker; });
+	if (nullptr == Entry)
+	{
+		Entry = &ActiveMessages.AddDefaulted_GetRef();
+		Entry->Speaker = Speaker;
+		Entry->Billboard = AcquireBillboard();
+		INC_DWORD_STAT(STAT_PPOverheadMessagesActive);
+	}
+
+	Entry->Offset = Offset;
+	Entry->ExpireTime = GetWorld()->GetTimeSeconds() + Duration;
+	Entry->Billboard->SetText(Message);
+	Entry->Billboard->SetTextRenderColor(Color);
+	Entry->Billboard->SetWorldLocation(Speaker->GetActorLocation() + Offset);
+	Entry->Billboard->SetHiddenInGame(false);
+
+	SetActorTickEnabled(true);
+}
+
+void AOverheadMessageManager::HideMessage(AActor* Speaker)
+{
+	const int32 Index = ActiveMessages.IndexOfByPredicate([Speaker](const FPPOverheadMessage& Active) { return Active.Speaker == Speaker; });
+	if (Index != INDEX_NONE)
+	{
+		ReleaseMessage(Index);
+	}
+}
+
+void AOverheadMessageManager::ReleaseMessage(int32 Index)
+{
+	UTextRenderComponent* Billboard = ActiveMessages[Index].Billboard;
+	Billboard->SetHiddenInGame(true);
+	Billboard->SetText(FText::GetEmpty());
+	FreeBillboards.Add(Billboard);
+
+	ActiveMessages.RemoveAtSwap(Index, 1, false);
+	DEC_DWORD_STAT(STAT_PPOverheadMessagesActive);
+}
+
+void AOverheadMessageManager::Tick(float DeltaSeconds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PPOverheadMessagesTick);
+
+	Super::Tick(DeltaSeconds);
+
+	// One camera lookup for every billboard
+	float CameraYaw = 0.f;
+	APlayerController* PlayerController = GEngine->GetFirstLocalPlayerController(GetWorld());
+	if (PlayerController && PlayerController->PlayerCameraManager)
+	{
+		CameraYaw = PlayerController->PlayerCameraManager->GetCameraRotation().Yaw;
+	}
+	const FQuat FacingCamera = FRotator(0, CameraYaw + 180, 0).Quaternion();
+
+	const float Now = GetWorld()->GetTimeSeconds();
+	for (int32 i = ActiveMessages.Num() - 1; i >= 0; i--)
+	{
+		FPPOverheadMessage& Entry = ActiveMessages[i];
+		AActor* Speaker = Entry.Speaker.Get();
+		if (nullptr == Speaker || Now >= Entry.ExpireTime)
+		{
+			ReleaseMessage(i);
+			continue;
+		}
+
+		Entry.Billboard->SetWorldLocationAndRotation(Speaker->GetActorLocation() + Entry.Offset, FacingCamera);
+	}
+
+	if (ActiveMessages.Num() == 0)
+	{
+		SetActorTickEnabled(false);
+	}
+}
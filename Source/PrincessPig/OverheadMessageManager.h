@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "OverheadMessageManager.generated.h"
+
+class UTextRenderComponent;
+
+/** A billboard on loan to a character while its message is showing */
+USTRUCT()
+struct FPPOverheadMessage
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TWeakObjectPtr<AActor> Speaker;
+
+	UPROPERTY()
+	UTextRenderComponent* Billboard;
+
+	FVector Offset;
+	float ExpireTime;
+
+	FPPOverheadMessage()
+		: Billboard(nullptr)
+		, Offset(FVector::ZeroVector)
+		, ExpireTime(0.f)
+	{}
+};
+
+/**
+ * Client-side owner of every overhead message billboard.
+ *
+ * Characters don't keep a text component of their own. When a message arrives, a billboard
+ * is taken from a small pool, follows the speaker until the message expires, and goes back
+ * to the pool. All active billboards are turned to face the camera in one pass per frame,
+ * and the manager stops ticking when none are active.
+ *
+ * There is never a manager on a dedicated server.
+ */
+UCLASS(NotPlaceable, Transient)
+class PRINCESSPIG_API AOverheadMessageManager : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AOverheadMessageManager();
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Find or spawn the manager for this world. Returns null where nothing is rendered */
+	static AOverheadMessageManager* Get(const UObject* WorldContextObject);
+
+	/** The manager for this world if there is one. Never spawns, so it is safe during teardown */
+	static AOverheadMessageManager* Find(const UObject* WorldContextObject);
+
+	/** Show Message above Speaker for Duration seconds, replacing any message it is already showing */
+	void ShowMessage(AActor* Speaker, const FText& Message, FColor Color, float Duration, FVector Offset);
+
+	/** Take down Speaker's message early, e.g. when it is destroyed */
+	void HideMessage(AActor* Speaker);
+
+	/** Billboards made up front. The pool grows past this if more are needed at once */
+	UPROPERTY(EditDefaultsOnly, Category = "OverheadMessages")
+	int32 InitialPoolSize;
+
+	UPROPERTY(EditDefaultsOnly, Category = "OverheadMessages")
+	float TextWorldSize;
+
+protected:
+	UPROPERTY(Transient)
+	TArray<FPPOverheadMessage> ActiveMessages;
+
+	UPROPERTY(Transient)
+	TArray<UTextRenderComponent*> FreeBillboards;
+
+	UTextRenderComponent* AcquireBillboard();
+	void ReleaseMessage(int32 Index);
+};
@@ -0,0 +1,18 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "OverheadMessageTable.h"
+
+int32 UOverheadMessageTable::FindMessageId(FName Key) const
+{
+	return Lines.IndexOfByPredicate([Key](const FPPOverheadMessageLine& Line) { return Line.Key == Key; });
+}
+
+FText UOverheadMessageTable::GetMessage(int32 MessageId) const
+{
+	return Lines.IsValidIndex(MessageId) ? Lines[MessageId].Text : FText::GetEmpty();
+}
+
+FColor UOverheadMessageTable::GetColor(int32 PaletteIndex) const
+{
+	return Palette.IsValidIndex(PaletteIndex) ? Palette[PaletteIndex] : FColor::White;
+}
@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "OverheadMessageTable.generated.h"
+
+class APrincessPigCharacter;
+
+USTRUCT(BlueprintType)
+struct FPPOverheadMessageLine
+{
+	GENERATED_BODY()
+
+	/** Name Blueprints use to look the line up */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "OverheadMessages")
+	FName Key;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "OverheadMessages")
+	FText Text;
+};
+
+/** One shout, as sent over the network. Speaker is resolved by the receiving client, or null if it isn't relevant there */
+USTRUCT()
+struct FPPOverheadMessageEvent
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	APrincessPigCharacter* Speaker;
+
+	/** Index into the speaker's OverheadMessageTable */
+	UPROPERTY()
+	uint16 MessageId;
+
+	/** Index into the table's Palette */
+	UPROPERTY()
+	uint8 PaletteIndex;
+
+	/** Duration in tenths of a second, see UOverheadMessageTable::QuantizeDuration */
+	UPROPERTY()
+	uint8 QuantizedDuration;
+
+	FPPOverheadMessageEvent()
+		: Speaker(nullptr)
+		, MessageId(0)
+		, PaletteIndex(0)
+		, QuantizedDuration(0)
+	{}
+};
+
+/**
+ * Localized overhead lines and the colours they can be shown in.
+ *
+ * Shouts are sent as indices into this table instead of full text and colour,
+ * so that every client needs the same asset assigned on the speaking character.
+ */
+UCLASS(BlueprintType)
+class PRINCESSPIG_API UOverheadMessageTable : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "OverheadMessages")
+	TArray<FPPOverheadMessageLine> Lines;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "OverheadMessages")
+	TArray<FColor> Palette;
+
+	/** Index of the line with this key, or INDEX_NONE */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "OverheadMessages")
+	int32 FindMessageId(FName Key) const;
+
+	FText GetMessage(int32 MessageId) const;
+	FColor GetColor(int32 PaletteIndex) const;
+
+	/** Durations travel as tenths of a second, up to 25.5 seconds */
+	static uint8 QuantizeDuration(float Duration) { return (uint8)FMath::Clamp(FMath::RoundToInt(Duration * 10.f), 0, 255); }
+	static float DequantizeDuration(uint8 QuantizedDuration) { return QuantizedDuration * 0.1f; }
+};
@@ -0,0 +1,456 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PPCharacterMovementComponent.h"
+#include "PrincessPig.h"
+#include "PrincessPigCharacter.h"
+#include "AvoidanceSolver.h"
+#include "HingedDoor.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "TimerManager.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Movement Corrections"), STAT_PPMovementCorrections, STATGROUP_PrincessPig);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Nav Walking Characters"), STAT_PPNavWalkingCharacters, STATGROUP_PrincessPig);
+DECLARE_CYCLE_STAT(TEXT("Nav Walking Evaluation"), STAT_PPNavWalkingEvaluation, STATGROUP_PrincessPig);
+
+// Compressed flag layout for our custom move state
+// FLAG_Custom_0 is running, FLAG_Custom_1 and up are the status bits in EPPMovementStatus order
+static const uint8 RunFlag = FSavedMove_Character::FLAG_Custom_0;
+static const uint8 StatusFlagShift = 5; // FLAG_Custom_1 == 1 << 5
+static_assert(FSavedMove_Character::FLAG_Custom_1 == (1 << StatusFlagShift), "Status flags must start at FLAG_Custom_1");
+static_assert((uint8)EPPMovementStatus::Num <= 3, "Only FLAG_Custom_1 to FLAG_Custom_3 are free for status flags");
+
+UPPCharacterMovementComponent::UPPCharacterMovementComponent()
+{
+	StatusAcknowledgeTime = 0.5f;
+	NumCorrections = 0;
+
+	bWantsToRun = false;
+	StatusFlags = 0;
+	bMoveWantsToRun = false;
+	MoveStatusFlags = 0;
+	ClientStatusFlags = 0;
+
+	AvoidanceSolverIndex = INDEX_NONE;
+	DesiredAvoidanceVelocity = FVector::ZeroVector;
+
+	FullWalkingPlayerDistance = 600.f;
+	PushingPlayerDistanceScale = 2.f;
+	FullWalkingDoorDistance = 300.f;
+	NavWalkingEvaluationInterval = 0.25f;
+
+	for (float& OnsetTime : StatusOnsetTimes)
+	{
+		OnsetTime = 0.f;
+	}
+}
+
+APrincessPigCharacter* UPPCharacterMovementComponent::GetPPCharacterOwner() const
+{
+	return Cast<APrincessPigCharacter>(CharacterOwner);
+}
+
+
+#pragma region RequestedState
+
+void UPPCharacterMovementComponent::SetWantsToRun(bool bNewWantsToRun)
+{
+	bWantsToRun = bNewWantsToRun;
+
+	// Outside of a move, the move state follows the request straight away
+	// so that GetMaxSpeed() and friends are correct for anyone asking
+	if (!bClientUpdating)
+	{
+		bMoveWantsToRun = bWantsToRun;
+		ApplyMovementModifiers();
+	}
+}
+
+void UPPCharacterMovementComponent::SetStatus(EPPMovementStatus Status, bool bActive)
+{
+	const uint8 Bit = StatusBit(Status);
+	const bool bWasActive = (StatusFlags & Bit) != 0;
+	if (bActive == bWasActive)
+	{
+		return;
+	}
+
+	if (bActive)
+	{
+		StatusFlags |= Bit;
+		if (GetWorld())
+		{
+			StatusOnsetTimes[(uint8)Status] = GetWorld()->GetTimeSeconds();
+		}
+	}
+	else
+	{
+		StatusFlags &= ~Bit;
+	}
+
+	if (!bClientUpdating)
+	{
+		MoveStatusFlags = (CharacterOwner && CharacterOwner->Role == ROLE_Authority) ? GetServerMoveStatusFlags() : StatusFlags;
+		ApplyMovementModifiers();
+	}
+}
+
+bool UPPCharacterMovementComponent::HasStatus(EPPMovementStatus Status) const
+{
+	return (StatusFlags & StatusBit(Status)) != 0;
+}
+
+#pragma endregion RequestedState
+
+
+#pragma region Simulation
+
+void UPPCharacterMovementComponent::UpdateFromCompressedFlags(uint8 Flags)
+{
+	Super::UpdateFromCompressedFlags(Flags);
+
+	// Server receiving a move from the owning client
+	bMoveWantsToRun = (Flags & RunFlag) != 0;
+	ClientStatusFlags = (Flags >> StatusFlagShift) & ((1 << (uint8)EPPMovementStatus::Num) - 1);
+}
+
+uint8 UPPCharacterMovementComponent::GetServerMoveStatusFlags() const
+{
+	// AI and locally controlled characters have no one to wait for
+	if (!CharacterOwner ||
+		CharacterOwner->IsLocallyControlled() ||
+		CharacterOwner->GetRemoteRole() != ROLE_AutonomousProxy)
+	{
+		return StatusFlags;
+	}
+
+	// Trust whatever the client says is slowing it down,
+	// and enforce anything it has had plenty of time to hear about
+	uint8 Flags = ClientStatusFlags;
+	const float Now = GetWorld() ? GetWorld()->GetTimeSeconds() : 0.f;
+	for (uint8 i = 0; i < (uint8)EPPMovementStatus::Num; i++)
+	{
+		const uint8 Bit = 1 << i;
+		if ((StatusFlags & Bit) && Now - StatusOnsetTimes[i] > StatusAcknowledgeTime)
+		{
+			Flags |= Bit;
+		}
+	}
+	return Flags;
+}
+
+void UPPCharacterMovementComponent::UpdateCharacterStateBeforeMovement(float DeltaSeconds)
+{
+	Super::UpdateCharacterStateBeforeMovement(DeltaSeconds);
+
+	if (CharacterOwner)
+	{
+		if (CharacterOwner->Role == ROLE_Authority)
+		{
+			// Remote clients have already filled bMoveWantsToRun in UpdateFromCompressedFlags
+			if (CharacterOwner->IsLocallyControlled() || CharacterOwner->GetRemoteRole() != ROLE_AutonomousProxy)
+			{
+				bMoveWantsToRun = bWantsToRun;
+			}
+			MoveStatusFlags = GetServerMoveStatusFlags();
+		}
+		else if (!bClientUpdating)
+		{
+			// New move on the owning client. Replays get their state from PrepMoveFor
+			bMoveWantsToRun = bWantsToRun;
+			MoveStatusFlags = StatusFlags;
+		}
+	}
+
+	ApplyMovementModifiers();
+}
+
+void UPPCharacterMovementComponent::ApplyMovementModifiers()
+{
+	APrincessPigCharacter* PPCharacter = GetPPCharacterOwner();
+	if (nullptr == PPCharacter)
+	{
+		return;
+	}
+
+	// Acceleration
+	if (MoveStatusFlags & StatusBit(EPPMovementStatus::OffBalance))
+	{
+		MaxAcceleration = 0;
+		BrakingDecelerationWalking = 0;
+		BrakingFrictionFactor = 0.01;
+	}
+	else
+	{
+		MaxAcceleration = PPCharacter->NormalAcceleration;
+		BrakingDecelerationWalking = PPCharacter->NormalDeceleration;
+		BrakingFrictionFactor = 1;
+	}
+
+	// Max speed
+	if (MoveStatusFlags & StatusBit(EPPMovementStatus::Subdued))
+	{
+		MaxWalkSpeed = 0;
+	}
+	else
+	{
+		MaxWalkSpeed = bMoveWantsToRun ? PPCharacter->RunSpeed : PPCharacter->WalkSpeed;
+	}
+}
+
+void UPPCharacterMovementComponent::ClientAdjustPosition_Implementation(float TimeStamp, FVector NewLoc, FVector NewVel, UPrimitiveComponent* NewBase, FName NewBaseBoneName, bool bHasBase, bool bBaseRelativePosition, uint8 ServerMovementMode)
+{
+	NumCorrections++;
+	INC_DWORD_STAT(STAT_PPMovementCorrections);
+
+	Super::ClientAdjustPosition_Implementation(TimeStamp, NewLoc, NewVel, NewBase, NewBaseBoneName, bHasBase, bBaseRelativePosition, ServerMovementMode);
+}
+
+#pragma endregion Simulation
+
+
+#pragma region Avoidance
+
+void UPPCharacterMovementComponent::SetUseBatchedAvoidance(bool bUseBatched)
+{
+	if (AAvoidanceSolver* Solver = AvoidanceSolver.Get())
+	{
+		Solver->UnregisterAgent(this);
+		AvoidanceSolver = nullptr;
+	}
+
+	if (bUseBatched)
+	{
+		AvoidanceSolver = AAvoidanceSolver::GetAvoidanceSolver(this);
+		if (AvoidanceSolver.IsValid())
+		{
+			AvoidanceSolver->RegisterAgent(this);
+		}
+	}
+}
+
+void UPPCharacterMovementComponent::CalcAvoidanceVelocity(float DeltaTime)
+{
+	AAvoidanceSolver* Solver = AvoidanceSolver.Get();
+	if (nullptr == Solver)
+	{
+		Super::CalcAvoidanceVelocity(DeltaTime);
+		return;
+	}
+
+	// The next solve works from what we want now
+	DesiredAvoidanceVelocity = IsMovingOnGround() ? Velocity : FVector::ZeroVector;
+
+	FVector AvoidanceVelocity;
+	if (IsMovingOnGround() && Solver->GetAvoidanceVelocity(this, Velocity, AvoidanceVelocity))
+	{
+		Velocity = AvoidanceVelocity;
+		bWasAvoidanceUpdated = true;
+	}
+}
+
+#pragma endregion Avoidance
+
+
+#pragma region NavWalking
+
+void UPPCharacterMovementComponent::SetNavWalkingAllowed(bool bAllowed)
+{
+	if (nullptr == CharacterOwner || CharacterOwner->Role != ROLE_Authority || nullptr == GetWorld())
+	{
+		return;
+	}
+
+	FTimerManager& TimerManager = GetWorld()->GetTimerManager();
+	if (bAllowed)
+	{
+		if (!TimerManager.IsTimerActive(NavWalkingTimer))
+		{
+			// Spread the checks out so they don't all land on the same frame
+			TimerManager.SetTimer(NavWalkingTimer, this, &UPPCharacterMovementComponent::EvaluateNavWalking, NavWalkingEvaluationInterval, true, FMath::FRand() * NavWalkingEvaluationInterval);
+		}
+	}
+	else
+	{
+		TimerManager.ClearTimer(NavWalkingTimer);
+		if (DefaultLandMovementMode == MOVE_NavWalking)
+		{
+			DEC_DWORD_STAT(STAT_PPNavWalkingCharacters);
+		}
+		DefaultLandMovementMode = MOVE_Walking;
+		if (MovementMode == MOVE_NavWalking)
+		{
+			SetMovementMode(MOVE_Walking);
+		}
+	}
+}
+
+void UPPCharacterMovementComponent::EvaluateNavWalking()
+{
+	SCOPE_CYCLE_COUNTER(STAT_PPNavWalkingEvaluation);
+
+	// Leave falling, swimming and disabled movement alone, landing picks up DefaultLandMovementMode
+	if (!IsActive() || nullptr == CharacterOwner)
+	{
+		return;
+	}
+
+	const EMovementMode LandMode = NeedsFullWalking() ? MOVE_Walking : MOVE_NavWalking;
+	if (LandMode != DefaultLandMovementMode)
+	{
+		if (LandMode == MOVE_NavWalking)
+		{
+			INC_DWORD_STAT(STAT_PPNavWalkingCharacters);
+		}
+		else
+		{
+			DEC_DWORD_STAT(STAT_PPNavWalkingCharacters);
+		}
+		DefaultLandMovementMode = LandMode;
+	}
+
+	if (IsMovingOnGround() && MovementMode != LandMode)
+	{
+		SetMovementMode(LandMode);
+	}
+}
+
+void UPPCharacterMovementComponent::OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode)
+{
+	Super::OnMovementModeChanged(PreviousMovementMode, PreviousCustomMode);
+
+	// Leaving nav walking puts the capsule's WorldStatic and WorldDynamic responses back to the
+	// class defaults, which would undo whatever the character has been allowed to overlap
+	if (PreviousMovementMode == MOVE_NavWalking && MovementMode != MOVE_NavWalking)
+	{
+		if (APrincessPigCharacter* PPCharacter = GetPPCharacterOwner())
+		{
+			PPCharacter->OnRep_AllowOverlapPawns();
+			PPCharacter->OnRep_AllowOverlapDynamic();
+		}
+	}
+}
+
+bool UPPCharacterMovementComponent::NeedsFullWalking() const
+{
+	const FVector Location = CharacterOwner->GetActorLocation();
+
+	// Players bump into us, and push us about
+	for (FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator)
+	{
+		APlayerController* PlayerController = Iterator->Get();
+		APrincessPigCharacter* Player = PlayerController ? Cast<APrincessPigCharacter>(PlayerController->GetPawn()) : nullptr;
+		if (nullptr == Player || Player->Replicated_IsDead)
+		{
+			continue;
+		}
+
+		const float Distance = FullWalkingPlayerDistance * (Player->PlayerInputForce > 0.f ? PushingPlayerDistanceScale : 1.f);
+		if (FVector::DistSquared(Player->GetActorLocation(), Location) < FMath::Square(Distance))
+		{
+			return true;
+		}
+	}
+
+	// Doors are only in the way to collision, not to the navmesh
+	TArray<FOverlapResult> Overlaps;
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(NavWalkingDoors), false, CharacterOwner);
+	GetWorld()->OverlapMultiByObjectType(Overlaps, Location, FQuat::Identity, FCollisionObjectQueryParams(ECC_WorldDynamic), FCollisionShape::MakeSphere(FullWalkingDoorDistance), QueryParams);
+	for (const FOverlapResult& Overlap : Overlaps)
+	{
+		if (Cast<AHingedDoor>(Overlap.GetActor()))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+#pragma endregion NavWalking
+
+
+#pragma region NetworkPrediction
+
+FNetworkPredictionData_Client* UPPCharacterMovementComponent::GetPredictionData_Client() const
+{
+	check(PawnOwner != nullptr);
+
+	if (!ClientPredictionData)
+	{
+		UPPCharacterMovementComponent* MutableThis = const_cast<UPPCharacterMovementComponent*>(this);
+		MutableThis->ClientPredictionData = new FNetworkPredictionData_Client_PP(*this);
+	}
+
+	return ClientPredictionData;
+}
+
+void FSavedMove_PP::Clear()
+{
+	Super::Clear();
+
+	bSavedWantsToRun = false;
+	SavedStatusFlags = 0;
+}
+
+uint8 FSavedMove_PP::GetCompressedFlags() const
+{
+	uint8 Result = Super::GetCompressedFlags();
+
+	if (bSavedWantsToRun)
+	{
+		Result |= RunFlag;
+	}
+	Result |= SavedStatusFlags << StatusFlagShift;
+
+	return Result;
+}
+
+bool FSavedMove_PP::CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const
+{
+	const FSavedMove_PP* NewPPMove = static_cast<const FSavedMove_PP*>(NewMove.Get());
+	if (bSavedWantsToRun != NewPPMove->bSavedWantsToRun ||
+		SavedStatusFlags != NewPPMove->SavedStatusFlags)
+	{
+		return false;
+	}
+
+	return Super::CanCombineWith(NewMove, InCharacter, MaxDelta);
+}
+
+void FSavedMove_PP::SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData)
+{
+	Super::SetMoveFor(C, InDeltaTime, NewAccel, ClientData);
+
+	UPPCharacterMovementComponent* PPMovement = Cast<UPPCharacterMovementComponent>(C->GetCharacterMovement());
+	if (PPMovement)
+	{
+		bSavedWantsToRun = PPMovement->bWantsToRun;
+		SavedStatusFlags = PPMovement->StatusFlags;
+	}
+}
+
+void FSavedMove_PP::PrepMoveFor(ACharacter* C)
+{
+	Super::PrepMoveFor(C);
+
+	// Replay with the state the move was originally made with
+	UPPCharacterMovementComponent* PPMovement = Cast<UPPCharacterMovementComponent>(C->GetCharacterMovement());
+	if (PPMovement)
+	{
+		PPMovement->bMoveWantsToRun = bSavedWantsToRun;
+		PPMovement->MoveStatusFlags = SavedStatusFlags;
+	}
+}
+
+FNetworkPredictionData_Client_PP::FNetworkPredictionData_Client_PP(const UCharacterMovementComponent& ClientMovement)
+	: Super(ClientMovement)
+{
+}
+
+FSavedMovePtr FNetworkPredictionData_Client_PP::AllocateNewMove()
+{
+	return FSavedMovePtr(new FSavedMove_PP());
+}
+
+#pragma endregion NetworkPrediction
@@ -0,0 +1,159 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "PPCharacterMovementComponent.generated.h"
+
+class APrincessPigCharacter;
+class AAvoidanceSolver;
+
+/** Status effects that change how a character moves.
+* Stored as bits so that they can travel in the compressed flags of a saved move */
+UENUM(BlueprintType)
+enum class EPPMovementStatus : uint8
+{
+	OffBalance = 0 UMETA(DisplayName = "OffBalance"),
+	Subdued = 1 UMETA(DisplayName = "Subdued"),
+	Num UMETA(Hidden)
+};
+
+
+/**
+ * Character movement that predicts walk/run and status modifiers.
+ *
+ * The owning character only tells this component what it wants (running or not,
+ * which status effects are active). Max speed, acceleration and braking are derived
+ * from that state right before every move, so replayed moves use the same values
+ * the client had when it first made them.
+ */
+UCLASS()
+class PRINCESSPIG_API UPPCharacterMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+	friend class FSavedMove_PP;
+	friend class AAvoidanceSolver;
+
+public:
+	UPPCharacterMovementComponent();
+
+	// Begin UCharacterMovementComponent interface
+	virtual void UpdateFromCompressedFlags(uint8 Flags) override;
+	virtual class FNetworkPredictionData_Client* GetPredictionData_Client() const override;
+	virtual void UpdateCharacterStateBeforeMovement(float DeltaSeconds) override;
+	virtual void ClientAdjustPosition_Implementation(float TimeStamp, FVector NewLoc, FVector NewVel, UPrimitiveComponent* NewBase, FName NewBaseBoneName, bool bHasBase, bool bBaseRelativePosition, uint8 ServerMovementMode) override;
+	virtual void CalcAvoidanceVelocity(float DeltaTime) override;
+	virtual void OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode) override;
+	// End UCharacterMovementComponent interface
+
+	/** Server only. Have AAvoidanceSolver work out avoidance for this agent, if it is enabled */
+	void SetUseBatchedAvoidance(bool bUseBatched);
+
+	/**
+	 * Server only, for AI. Walk along the navmesh instead of sweeping against collision, switching
+	 * back to full walking whenever a player, a door or someone pushing is close enough to matter.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Movement")
+	void SetNavWalkingAllowed(bool bAllowed);
+
+	/** Players closer than this need full walking, so that they bump into us properly */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+	float FullWalkingPlayerDistance;
+
+	/** Players with PlayerInputForce can shove us, so count from this much further away */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+	float PushingPlayerDistanceScale;
+
+	/** Doors closer than this need full walking, as nav walking goes straight through them */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+	float FullWalkingDoorDistance;
+
+	/** Seconds between checks for what is nearby */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+	float NavWalkingEvaluationInterval;
+
+	UFUNCTION(BlueprintCallable, Category = "Movement")
+	void SetWantsToRun(bool bNewWantsToRun);
+
+	UFUNCTION(BlueprintCallable, Category = "Movement")
+	void SetStatus(EPPMovementStatus Status, bool bActive);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Movement")
+	bool HasStatus(EPPMovementStatus Status) const;
+
+	/** How long the server waits for an owning client to report a status change in its moves
+	* before enforcing it anyway. Should comfortably cover a round trip. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
+	float StatusAcknowledgeTime;
+
+	/** Number of position corrections received from the server (owning client only) */
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Movement")
+	int32 NumCorrections;
+
+protected:
+	/** Requested state, as set by the owning character */
+	uint8 bWantsToRun : 1;
+	uint8 StatusFlags;
+
+	/** State used while simulating the current move (may come from a saved or received move) */
+	uint8 bMoveWantsToRun : 1;
+	uint8 MoveStatusFlags;
+
+	/** Server only: status flags reported by the owning client in its last move */
+	uint8 ClientStatusFlags;
+
+	/** Server only: world time at which each status was last switched on */
+	float StatusOnsetTimes[(uint8)EPPMovementStatus::Num];
+
+	/** Status flags the server is prepared to simulate a remote client's move with */
+	uint8 GetServerMoveStatusFlags() const;
+
+	/** Write MaxWalkSpeed, acceleration and braking from the move state */
+	void ApplyMovementModifiers();
+
+	APrincessPigCharacter* GetPPCharacterOwner() const;
+
+	static uint8 StatusBit(EPPMovementStatus Status) { return 1 << (uint8)Status; }
+
+	/** Batched avoidance, if this agent is registered */
+	TWeakObjectPtr<AAvoidanceSolver> AvoidanceSolver;
+	int32 AvoidanceSolverIndex;
+
+	/** Velocity we wanted before avoidance on our last move, which the solver works from */
+	FVector DesiredAvoidanceVelocity;
+
+	FTimerHandle NavWalkingTimer;
+
+	/** Pick nav walking or full walking for what is nearby now */
+	void EvaluateNavWalking();
+	bool NeedsFullWalking() const;
+};
+
+
+class FSavedMove_PP : public FSavedMove_Character
+{
+public:
+	typedef FSavedMove_Character Super;
+
+	virtual void Clear() override;
+	virtual uint8 GetCompressedFlags() const override;
+	virtual bool CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const override;
+	virtual void SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel, class FNetworkPredictionData_Client_Character& ClientData) override;
+	virtual void PrepMoveFor(ACharacter* C) override;
+
+	uint8 bSavedWantsToRun : 1;
+	uint8 SavedStatusFlags;
+};
+
+
+class FNetworkPredictionData_Client_PP : public FNetworkPredictionData_Client_Character
+{
+public:
+	typedef FNetworkPredictionData_Client_Character Super;
+
+	FNetworkPredictionData_Client_PP(const UCharacterMovementComponent& ClientMovement);
+
+	virtual FSavedMovePtr AllocateNewMove() override;
+};
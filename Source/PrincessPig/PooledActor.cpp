@@ -0,0 +1,134 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PooledActor.h"
+#include "ActorPool.h"
+#include "Engine/World.h"
+#include "TimerManager.h"
+#include "Net/UnrealNetwork.h"
+
+APooledActor::APooledActor()
+{
+	SetReplicates(true);
+
+	OwningPool = nullptr;
+	Replicated_IsInUse = true;
+	bTickWhenInUse = true;
+	bCollisionWhenInUse = true;
+	bInUseStateApplied = true;
+}
+
+void APooledActor::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(APooledActor, Replicated_IsInUse);
+}
+
+void APooledActor::BeginPlay()
+{
+	bTickWhenInUse = PrimaryActorTick.bStartWithTickEnabled;
+
+	Super::BeginPlay();
+
+	// Spawned without a pool, or arriving on a client already in use: start up the same way
+	if (Replicated_IsInUse && (!HasAuthority() || nullptr == OwningPool))
+	{
+		BPEvent_OnAcquiredFromPool();
+	}
+
+	// Starting out in the pool. Ticking is only registered now, so turn it off again
+	if (!Replicated_IsInUse)
+	{
+		ApplyInUseState();
+	}
+}
+
+void APooledActor::InitReturnedToPool()
+{
+	Replicated_IsInUse = false;
+	ApplyInUseState();
+
+	// Goes out once in the hidden state, then stays quiet until it is handed out
+	NetDormancy = DORM_DormantAll;
+}
+
+void APooledActor::ReturnToPool()
+{
+	if (!HasAuthority())
+	{
+		return;
+	}
+
+	GetWorldTimerManager().ClearTimer(ReturnToPoolTimer);
+
+	if (OwningPool)
+	{
+		OwningPool->ReleaseActor(this);
+	}
+	else
+	{
+		Destroy();
+	}
+}
+
+void APooledActor::ReturnToPoolAfter(float Seconds)
+{
+	if (HasAuthority())
+	{
+		GetWorldTimerManager().SetTimer(ReturnToPoolTimer, this, &APooledActor::ReturnToPool, FMath::Max(Seconds, 0.01f), false);
+	}
+}
+
+void APooledActor::OnAcquiredFromPool()
+{
+	Replicated_IsInUse = true;
+	if (NetDormancy > DORM_Awake)
+	{
+		SetNetDormancy(DORM_Awake);
+	}
+	ForceNetUpdate();
+
+	ApplyInUseState();
+	BPEvent_OnAcquiredFromPool();
+}
+
+void APooledActor::OnReturnedToPool()
+{
+	GetWorldTimerManager().ClearTimer(ReturnToPoolTimer);
+	BPEvent_OnReturnedToPool();
+
+	Replicated_IsInUse = false;
+	ApplyInUseState();
+
+	// Send the hidden state, then stop replicating until it is needed again
+	FlushNetDormancy();
+	SetNetDormancy(DORM_DormantAll);
+}
+
+void APooledActor::OnRep_IsInUse()
+{
+	ApplyInUseState();
+
+	if (Replicated_IsInUse)
+	{
+		BPEvent_OnAcquiredFromPool();
+	}
+	else
+	{
+		BPEvent_OnReturnedToPool();
+	}
+}
+
+void APooledActor::ApplyInUseState()
+{
+	// Remember the collision it had in use, rather than assume it wants collision back
+	if (bInUseStateApplied && !Replicated_IsInUse)
+	{
+		bCollisionWhenInUse = GetActorEnableCollision();
+	}
+	bInUseStateApplied = Replicated_IsInUse;
+
+	SetActorHiddenInGame(!Replicated_IsInUse);
+	SetActorEnableCollision(Replicated_IsInUse && bCollisionWhenInUse);
+	SetActorTickEnabled(Replicated_IsInUse && bTickWhenInUse);
+}
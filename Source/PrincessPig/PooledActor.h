@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "PooledActor.generated.h"
+
+/**
+ * An actor that can be reused through AActorPool instead of being spawned and destroyed.
+ *
+ * While in the pool it is hidden, has no collision and doesn't tick, on every machine.
+ * Whether it is in use replicates, so clients follow along. Anything a Blueprint would do
+ * in BeginPlay should go in BPEvent_OnAcquiredFromPool, and be undone in BPEvent_OnReturnedToPool.
+ */
+UCLASS()
+class PRINCESSPIG_API APooledActor : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	APooledActor();
+
+	virtual void BeginPlay() override;
+
+	/** Server only. Give this actor back to its pool, or destroy it if it didn't come from one */
+	UFUNCTION(BlueprintCallable, Category = "Pool")
+	void ReturnToPool();
+
+	/** Server only. ReturnToPool after Seconds, the pooled equivalent of SetLifeSpan */
+	UFUNCTION(BlueprintCallable, Category = "Pool")
+	void ReturnToPoolAfter(float Seconds);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Pool")
+	bool IsInUse() const { return Replicated_IsInUse; }
+
+	/** Called by AActorPool */
+	virtual void OnAcquiredFromPool();
+	virtual void OnReturnedToPool();
+
+	/** Called by AActorPool between SpawnActorDeferred and FinishSpawning, for an actor that starts out in the pool */
+	void InitReturnedToPool();
+
+	/** Reset and start up here, this runs every time the actor is handed out */
+	UFUNCTION(BlueprintImplementableEvent, Category = "Pool")
+	void BPEvent_OnAcquiredFromPool();
+
+	/** Stop effects and clear state here, the actor is about to be hidden and reused later */
+	UFUNCTION(BlueprintImplementableEvent, Category = "Pool")
+	void BPEvent_OnReturnedToPool();
+
+	/** Set by the pool that made this actor */
+	UPROPERTY(Transient)
+	class AActorPool* OwningPool;
+
+protected:
+	UPROPERTY(ReplicatedUsing = OnRep_IsInUse)
+	bool Replicated_IsInUse;
+
+	UFUNCTION()
+	virtual void OnRep_IsInUse();
+
+	/** Hide or show, and turn collision and ticking on or off */
+	void ApplyInUseState();
+
+	/** Whether this actor ticks when in use */
+	bool bTickWhenInUse;
+
+	/** Whether this actor had collision when it was last in use, so subclasses that turn it off keep it off */
+	bool bCollisionWhenInUse;
+
+	/** Whether ApplyInUseState last left the actor in use */
+	bool bInUseStateApplied;
+
+	FTimerHandle ReturnToPoolTimer;
+};
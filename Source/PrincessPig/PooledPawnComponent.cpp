@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PooledPawnComponent.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PawnMovementComponent.h"
+#include "Net/UnrealNetwork.h"
+
+UPooledPawnComponent::UPooledPawnComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+
+	bReplicates = true;
+
+	Replicated_IsInUse = true;
+}
+
+void UPooledPawnComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(UPooledPawnComponent, Replicated_IsInUse);
+}
+
+void UPooledPawnComponent::SetInUse(bool bInUse)
+{
+	AActor* Owner = GetOwner();
+	if (nullptr == Owner || !Owner->HasAuthority())
+	{
+		return;
+	}
+
+	Replicated_IsInUse = bInUse;
+	ApplyInUseState();
+}
+
+void UPooledPawnComponent::OnRep_IsInUse()
+{
+	ApplyInUseState();
+}
+
+void UPooledPawnComponent::ApplyInUseState()
+{
+	APawn* Pawn = Cast<APawn>(GetOwner());
+	if (nullptr == Pawn)
+	{
+		return;
+	}
+
+	// Only hidden replicates on its own, collision and ticking have to be set on each machine
+	Pawn->SetActorHiddenInGame(!Replicated_IsInUse);
+	Pawn->SetActorEnableCollision(Replicated_IsInUse);
+	Pawn->SetActorTickEnabled(Replicated_IsInUse);
+	if (Pawn->GetMovementComponent())
+	{
+		Pawn->GetMovementComponent()->SetComponentTickEnabled(Replicated_IsInUse);
+	}
+}
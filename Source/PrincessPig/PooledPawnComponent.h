@@ -0,0 +1,38 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "PooledPawnComponent.generated.h"
+
+/**
+ * Lets a pawn be kept hidden and reused, for pawns that can't derive from APooledActor.
+ *
+ * While not in use the owner is hidden, has no collision and neither it nor its movement
+ * component ticks, on every machine. Whether it is in use replicates, so clients follow along.
+ * The game mode adds one to each ghost it pools.
+ */
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class PRINCESSPIG_API UPooledPawnComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UPooledPawnComponent();
+
+	/** Server only. Show or hide the owner and turn its collision and ticking on or off */
+	void SetInUse(bool bInUse);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Pool")
+	bool IsInUse() const { return Replicated_IsInUse; }
+
+protected:
+	UPROPERTY(ReplicatedUsing = OnRep_IsInUse)
+	bool Replicated_IsInUse;
+
+	UFUNCTION()
+	void OnRep_IsInUse();
+
+	void ApplyInUseState();
+};
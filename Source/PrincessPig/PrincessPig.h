@@ -3,6 +3,10 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Stats/Stats.h"
 
 DECLARE_LOG_CATEGORY_EXTERN(LogPrincessPig, Log, All);
 DECLARE_LOG_CATEGORY_EXTERN(LogNetwork, Log, All);
+
+/** Gameplay stats, view in game with 'stat PrincessPig' */
+DECLARE_STATS_GROUP(TEXT("PrincessPig"), STATGROUP_PrincessPig, STATCAT_Advanced);
@@ -3,17 +3,23 @@
 #include "PrincessPigCharacter.h"
 #include "PrincessPigPlayerController.h"
 #include "InteractionComponent.h"
+#include "PPCharacterMovementComponent.h"
+#include "LagCompensationComponent.h"
+#include "HitboxProxyComponent.h"
+#include "LeaderTrailComponent.h"
+#include "FormationComponent.h"
 #include "Follow.h"
+#include "CharacterRegistry.h"
 #include "UObject/ConstructorHelpers.h"
 #include "Components/CapsuleComponent.h"
 #include "Components/SphereComponent.h"
 #include "Components/SkeletalMeshComponent.h"
-#include "Components/TextRenderComponent.h"
 #include "Camera/CameraComponent.h"
 #include "GameFramework/Actor.h"
 #include "GameFramework/SpringArmComponent.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/PlayerController.h"
+#include "GameFramework/GameStateBase.h"
 #include "Materials/Material.h"
 #include "Engine/World.h"
 #include "Perception/AIPerceptionStimuliSourceComponent.h"
@@ -22,10 +28,22 @@
 #include "Perception/AISense_Hearing.h"
 #include "Net/UnrealNetwork.h"
 #include "Item.h"
+#include "OverheadMessageManager.h"
+#include "OverheadMessageTable.h"
+#include "PrincessPigGameState.h"
 
 #include "DrawDebugHelpers.h"
+#include "PrincessPig.h"
 
-APrincessPigCharacter::APrincessPigCharacter()
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Net Active Characters"), STAT_PPNetActiveCharacters, STATGROUP_PrincessPig);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Net Idle Characters"), STAT_PPNetIdleCharacters, STATGROUP_PrincessPig);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Net Distant Characters"), STAT_PPNetDistantCharacters, STATGROUP_PrincessPig);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Net Dormant Characters"), STAT_PPNetDormantCharacters, STATGROUP_PrincessPig);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Character Net Update Rate (total Hz)"), STAT_PPCharacterNetUpdateRate, STATGROUP_PrincessPig);
+DECLARE_CYCLE_STAT(TEXT("Character Death"), STAT_PPCharacterDeath, STATGROUP_PrincessPig);
+
+APrincessPigCharacter::APrincessPigCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UPPCharacterMovementComponent>(ACharacter::CharacterMovementComponentName))
 {
 	// Probable already set as default in Super, but...
 	bReplicates = true;
@@ -42,6 +60,13 @@ APrincessPigCharacter::APrincessPigCharacter()
 	InteractionComponent->OnComponentBeginOverlap.AddDynamic(this, &APrincessPigCharacter::RespondToInteractionBeginOverlap);
 	InteractionComponent->OnComponentEndOverlap.AddDynamic(this, &APrincessPigCharacter::RespondToInteractionEndOverlap);
 
+	// Record where we have been, so hits from laggy clients can be checked against what they saw
+	LagCompensation = CreateDefaultSubobject<ULagCompensationComponent>("LagCompensation");
+
+	// Leave a trail for followers to walk along
+	LeaderTrail = CreateDefaultSubobject<ULeaderTrailComponent>("LeaderTrail");
+	Formation = CreateDefaultSubobject<UFormationComponent>("Formation");
+
 	// Create item handle for non-stowable items
 	ItemHandle = CreateDefaultSubobject<USceneComponent>("ItemHandle");
 	//if (nullptr != GetMesh() && nullptr != GetMesh()->GetSocketByName(FName("ItemSocket")))
@@ -58,12 +83,9 @@ APrincessPigCharacter::APrincessPigCharacter()
 		ItemHandle->SetRelativeRotation(FRotator(0, 0, -25));
 	}
 
-	// Animate bones even when offscreen, so that server can handle all the bone-attached hitboxes
-	if (GetMesh() && HasAuthority())
-	{
-		GetMesh()->MeshComponentUpdateFlag = EMeshComponentUpdateFlag::AlwaysTickPoseAndRefreshBones;
-		// If this becomes too expensive, then static hitboxes in front of the mesh should be used.
-	}
+	// Bones only refresh when rendered (the Character default). The server uses cheap hitbox proxies instead,
+	// and opens a hit window to refresh bones only while a strike or interaction is in progress
+	HitboxProxies = CreateDefaultSubobject<UHitboxProxyComponent>("HitboxProxies");
 
 	// Don't rotate character to control rotation (this doesn't make use of RotationRate!)
 	bUseControllerRotationPitch = false;
@@ -104,27 +126,33 @@ APrincessPigCharacter::APrincessPigCharacter()
 	TopDownCameraComponent->bUsePawnControlRotation = false; // Camera does not rotate relative to arm
 	TopDownCameraComponent->SetupAttachment(CameraBoom, USpringArmComponent::SocketName);
 
-	// Activate ticking in order to update the cursor every frame.
-	PrimaryActorTick.bCanEverTick = true;
-	PrimaryActorTick.bStartWithTickEnabled = true;
+	// Nothing native needs to tick. Blueprints that implement Tick turn it back on
+	PrimaryActorTick.bCanEverTick = false;
 
 	// Create perception stimuli source
 	PerceptionStimuliSource = CreateDefaultSubobject<UAIPerceptionStimuliSourceComponent>(TEXT("PerceptionStimuliSource"));
 
+	// Configure strikes
+	StrikeReach = 120.f;
+	StrikeRadius = 40.f;
+	StrikeSubdueDuration = 2.f;
+	StrikeDamage = 0.f;
+	HitWindowDuration = 0.5f;
+
 	// Configure Health
 	Replicated_MaxHealth = 1.f;
 	Replicated_CurrentHealth = Replicated_MaxHealth;
 	Replicated_IsDead = false;
 
 	// Overhead messages
-	OverheadText = CreateDefaultSubobject<UTextRenderComponent>("OverheadText");
-	OverheadText->SetupAttachment(RootComponent);
-	OverheadText->SetRelativeLocation(FVector(0, 0, 156));
-	OverheadText->SetHorizontalAlignment(EHorizTextAligment::EHTA_Center);
-	OverheadText->SetVerticalAlignment(EVerticalTextAligment::EVRTA_TextCenter);
-	OverheadText->SetWorldSize(100);
-	OverheadText->SetText(FText::FromString(""));
+	OverheadMessageOffset = FVector(0, 0, 156);
+	OverheadMessageTable = nullptr;
 
+	// Net update policy, evaluated on the server once play begins
+	NetUpdateTier = EPPNetUpdateTier::None;
+	LastNetActivityTime = 0.f;
+
+	CharacterRegistryIndex = INDEX_NONE;
 }
 
 void APrincessPigCharacter::BeginPlay()
@@ -135,28 +163,56 @@ void APrincessPigCharacter::BeginPlay()
 	Replicated_IsDead = false;
 
 	UpdateMovementModifiers();
+
+	if (HasAuthority())
+	{
+		LastNetActivityTime = GetWorld()->GetTimeSeconds();
+		SetNetUpdateTier(EPPNetUpdateTier::Active);
+
+		// Stagger the first evaluation so characters spawned together don't all evaluate on the same frame
+		GetWorld()->GetTimerManager().SetTimer(NetUpdatePolicyTimer, this, &APrincessPigCharacter::EvaluateNetUpdatePolicy, NetUpdatePolicy.EvaluationInterval, true, FMath::FRand() * NetUpdatePolicy.EvaluationInterval);
+
+		// Pack our state for the AI
+		if (ACharacterRegistry* Registry = ACharacterRegistry::GetCharacterRegistry(this))
+		{
+			Registry->RegisterCharacter(this);
+		}
+	}
 }
 
-void APrincessPigCharacter::Tick(float DeltaSeconds)
+void APrincessPigCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-    Super::Tick(DeltaSeconds);
+	// Take this character out of the stats
+	SetNetUpdateTier(EPPNetUpdateTier::None);
 
+	if (ACharacterRegistry* Registry = CharacterRegistry.Get())
+	{
+		Registry->UnregisterCharacter(this);
+	}
 
-	// Sets overhead Text Rotation to face camera
-	FVector CameraLocation;
-	FRotator CameraRotation;
-	GEngine->GetFirstLocalPlayerController(GetWorld())->PlayerCameraManager->GetCameraViewPoint(CameraLocation, CameraRotation);
-	OverheadText->SetWorldRotation(FRotator(0, CameraRotation.Yaw + 180, 0));
+	// Find, not Get: no point spawning a manager on the way out
+	if (AOverheadMessageManager* MessageManager = AOverheadMessageManager::Find(this))
+	{
+		MessageManager->HideMessage(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 
 
 #pragma region CollisionAvoidance
 
-// Just enables RVOA avoidance on the character movement component
+// Enables RVO avoidance on the character movement component, solved in one batch with every other AI if possible
 void APrincessPigCharacter::SetCollisionAvoidanceEnabled(bool Enable)
 {
 	GetCharacterMovement()->SetAvoidanceEnabled(Enable);
+
+	UPPCharacterMovementComponent* PPMovement = Cast<UPPCharacterMovementComponent>(GetCharacterMovement());
+	if (PPMovement && HasAuthority())
+	{
+		PPMovement->SetUseBatchedAvoidance(Enable);
+	}
 }
 
 #pragma endregion CollisionAvoidance
@@ -172,6 +228,11 @@ void APrincessPigCharacter::Server_SetPlayerInputForce_Implementation(float Valu
 }
 
 
+UPPCharacterMovementComponent* APrincessPigCharacter::GetPPCharacterMovement() const
+{
+	return Cast<UPPCharacterMovementComponent>(GetCharacterMovement());
+}
+
 bool APrincessPigCharacter::IsAcceptingPlayerInput()
 {
 	return !Replicated_IsSubdued;
@@ -181,6 +242,7 @@ void APrincessPigCharacter::SetMovementMode(EPPMovementMode NewMovementMode)
 {
 	MovementMode = NewMovementMode;
 	UpdateMovementModifiers();
+	MarkNetStateChanged();
 }
 
 bool APrincessPigCharacter::Server_SetMovementMode_Validate(EPPMovementMode NewMovementMode) { return true; }
@@ -190,40 +252,22 @@ void APrincessPigCharacter::Server_SetMovementMode_Implementation(EPPMovementMod
 }
 
 
-void APrincessPigCharacter::UpdateMovementModifiers()
+void APrincessPigCharacter::OnRep_MovementMode()
 {
-	// Acceleration
-	if (Replicated_IsOffBalance)
-	{
-		GetCharacterMovement()->MaxAcceleration = 0;
-		GetCharacterMovement()->BrakingDecelerationWalking = 0;
-		GetCharacterMovement()->BrakingFrictionFactor = 0.01;
-	}
-	else
-	{
-		GetCharacterMovement()->MaxAcceleration = NormalAcceleration;
-		GetCharacterMovement()->BrakingDecelerationWalking = NormalDeceleration;
-		GetCharacterMovement()->BrakingFrictionFactor = 1;
-	}
+	UpdateMovementModifiers();
+}
 
-	// Max speed
-	if (Replicated_IsSubdued)
+void APrincessPigCharacter::UpdateMovementModifiers()
+{
+	// CharacterMovement turns these into speed, acceleration and braking before each move,
+	// and remembers them in saved moves so that client replays match what the server did
+	UPPCharacterMovementComponent* PPMovement = GetPPCharacterMovement();
+	if (PPMovement)
 	{
-		GetCharacterMovement()->MaxWalkSpeed = 0;
+		PPMovement->SetWantsToRun(MovementMode == EPPMovementMode::Running);
+		PPMovement->SetStatus(EPPMovementStatus::OffBalance, Replicated_IsOffBalance);
+		PPMovement->SetStatus(EPPMovementStatus::Subdued, Replicated_IsSubdued);
 	}
-	else
-	{
-		switch (MovementMode)
-		{
-		case EPPMovementMode::Walking:
-			GetCharacterMovement()->MaxWalkSpeed = WalkSpeed;
-			break;
-		case EPPMovementMode::Running:
-			GetCharacterMovement()->MaxWalkSpeed = RunSpeed;
-			break;
-		}
-	}
-
 }
 
 
@@ -239,6 +283,7 @@ void APrincessPigCharacter::Server_SetSubduedDirectly_Implementation(bool Subdue
 	GetWorld()->GetTimerManager().ClearTimer(SubdueTimer);
 	Replicated_IsSubdued = Subdued;
 	OnRep_IsSubdued();
+	MarkNetStateChanged();
 }
 
 bool APrincessPigCharacter::Server_SetSubduedFor_Validate(float Duration) { return Duration > 0; }
@@ -247,6 +292,7 @@ void APrincessPigCharacter::Server_SetSubduedFor_Implementation(float Duration)
 	GetWorld()->GetTimerManager().SetTimer(SubdueTimer, this, &APrincessPigCharacter::OnSubdueTimerExpired, Duration);
 	Replicated_IsSubdued = true;
 	OnRep_IsSubdued();
+	MarkNetStateChanged();
 }
 
 void APrincessPigCharacter::OnRep_IsSubdued()
@@ -263,12 +309,76 @@ void APrincessPigCharacter::OnRep_IsSubdued()
 
 	// Being subdued can affect movement capabilities
 	UpdateMovementModifiers();
+
+	UpdateRegistryStatus();
 }
 
 void APrincessPigCharacter::OnSubdueTimerExpired()
 {
 	Replicated_IsSubdued = false;
 	OnRep_IsSubdued();
+	MarkNetStateChanged();
+}
+
+void APrincessPigCharacter::Strike(APrincessPigCharacter* Target)
+{
+	if (nullptr == Target)
+	{
+		return;
+	}
+
+	// Tell the server when we saw the target, in its own clock
+	AGameStateBase* GameState = GetWorld()->GetGameState();
+	const float ClientTime = GameState ? GameState->GetServerWorldTimeSeconds() : GetWorld()->GetTimeSeconds();
+	Server_Strike(Target, ClientTime);
+}
+
+bool APrincessPigCharacter::Server_Strike_Validate(APrincessPigCharacter* Target, float ClientTime) { return true; }
+void APrincessPigCharacter::Server_Strike_Implementation(APrincessPigCharacter* Target, float ClientTime)
+{
+	if (nullptr == Target || Target == this || Replicated_IsDead || Replicated_IsSubdued || Target->Replicated_IsDead)
+	{
+		return;
+	}
+
+	const FVector Start = GetActorLocation();
+	const FVector End = Start + GetActorForwardVector() * StrikeReach;
+
+	if (HitboxProxies)
+	{
+		HitboxProxies->OpenHitWindow(HitWindowDuration);
+	}
+
+	// Rewind the target to when the striker saw it (bounded by the target's history)
+	bool bHit = false;
+	if (Target->LagCompensation)
+	{
+		bHit = Target->LagCompensation->SweepHitsAtTime(Start, End, StrikeRadius, ClientTime);
+	}
+	else
+	{
+		const FVector Closest = FMath::ClosestPointOnSegment(Target->GetActorLocation(), Start, End);
+		bHit = FVector::Distance(Closest, Target->GetActorLocation()) <= StrikeRadius + Target->GetCapsuleComponent()->GetScaledCapsuleRadius();
+	}
+
+	if (bHit)
+	{
+		// Follow-up checks in Blueprint want animated bones for a moment
+		if (Target->HitboxProxies)
+		{
+			Target->HitboxProxies->OpenHitWindow(HitWindowDuration);
+		}
+
+		if (StrikeSubdueDuration > 0)
+		{
+			Target->Server_SetSubduedFor(StrikeSubdueDuration);
+		}
+		if (StrikeDamage > 0)
+		{
+			Target->Server_TakeDamage(StrikeDamage);
+		}
+		BPEvent_OnStrikeHit(Target);
+	}
 }
 
 #pragma endregion Subdue
@@ -283,6 +393,7 @@ void APrincessPigCharacter::Server_SetOffBalanceDirectly_Implementation(bool Off
 	GetWorld()->GetTimerManager().ClearTimer(OffBalanceTimer);
 	Replicated_IsOffBalance = OffBalance;
 	OnRep_IsOffBalance();
+	MarkNetStateChanged();
 }
 
 bool APrincessPigCharacter::Server_SetOffBalanceFor_Validate(float Duration) { return Duration > 0; }
@@ -291,6 +402,7 @@ void APrincessPigCharacter::Server_SetOffBalanceFor_Implementation(float Duratio
 	GetWorld()->GetTimerManager().SetTimer(OffBalanceTimer, this, &APrincessPigCharacter::OnOffBalanceTimerExpired, Duration);
 	Replicated_IsOffBalance = true;
 	OnRep_IsOffBalance();
+	MarkNetStateChanged();
 }
 
 void APrincessPigCharacter::OnRep_IsOffBalance()
@@ -306,12 +418,15 @@ void APrincessPigCharacter::OnRep_IsOffBalance()
 
 	// OffBalance affects movement capabilities
 	UpdateMovementModifiers();
+
+	UpdateRegistryStatus();
 }
 
 void APrincessPigCharacter::OnOffBalanceTimerExpired()
 {
 	Replicated_IsOffBalance = false;
 	OnRep_IsOffBalance();
+	MarkNetStateChanged();
 }
 
 #pragma endregion OffBalance
@@ -326,6 +441,7 @@ void APrincessPigCharacter::Server_SetBlindedDirectly_Implementation(bool Blinde
 	GetWorld()->GetTimerManager().ClearTimer(BlindedTimer);
 	Replicated_IsBlinded = Blinded;
 	OnRep_IsBlinded();
+	MarkNetStateChanged();
 }
 
 bool APrincessPigCharacter::Server_SetBlindedFor_Validate(float Duration) { return Duration > 0; }
@@ -334,6 +450,7 @@ void APrincessPigCharacter::Server_SetBlindedFor_Implementation(float Duration)
 	GetWorld()->GetTimerManager().SetTimer(BlindedTimer, this, &APrincessPigCharacter::OnBlindedTimerExpired, Duration);
 	Replicated_IsBlinded = true;
 	OnRep_IsBlinded();
+	MarkNetStateChanged();
 }
 
 void APrincessPigCharacter::OnRep_IsBlinded()
@@ -349,12 +466,15 @@ void APrincessPigCharacter::OnRep_IsBlinded()
 
 	// OffBalance affects movement capabilities
 	UpdateMovementModifiers();
+
+	UpdateRegistryStatus();
 }
 
 void APrincessPigCharacter::OnBlindedTimerExpired()
 {
 	Replicated_IsBlinded = false;
 	OnRep_IsBlinded();
+	MarkNetStateChanged();
 }
 
 #pragma endregion Blinded
@@ -369,6 +489,7 @@ void APrincessPigCharacter::Server_SetDistractedDirectly_Implementation(bool Dis
 	GetWorld()->GetTimerManager().ClearTimer(DistractedTimer);
 	Replicated_IsDistracted = Distracted;
 	OnRep_IsDistracted();
+	MarkNetStateChanged();
 }
 
 bool APrincessPigCharacter::Server_SetDistractedFor_Validate(float Duration) { return Duration > 0; }
@@ -377,6 +498,7 @@ void APrincessPigCharacter::Server_SetDistractedFor_Implementation(float Duratio
 	GetWorld()->GetTimerManager().SetTimer(DistractedTimer, this, &APrincessPigCharacter::OnDistractedTimerExpired, Duration);
 	Replicated_IsDistracted = true;
 	OnRep_IsDistracted();
+	MarkNetStateChanged();
 }
 
 void APrincessPigCharacter::OnRep_IsDistracted()
@@ -392,12 +514,15 @@ void APrincessPigCharacter::OnRep_IsDistracted()
 
 	// OffBalance affects movement capabilities
 	UpdateMovementModifiers();
+
+	UpdateRegistryStatus();
 }
 
 void APrincessPigCharacter::OnDistractedTimerExpired()
 {
 	Replicated_IsDistracted = false;
 	OnRep_IsDistracted();
+	MarkNetStateChanged();
 }
 
 #pragma endregion Distracted
@@ -410,33 +535,89 @@ bool APrincessPigCharacter::Server_TakeDamage_Validate(float Damage) { return tr
 void APrincessPigCharacter::Server_TakeDamage_Implementation(float Damage)
 {
 	Replicated_CurrentHealth = Replicated_CurrentHealth - Damage;
-	if (Replicated_CurrentHealth <= 0)
+	MarkNetStateChanged();
+	if (Replicated_CurrentHealth <= 0 && !Replicated_IsDead)
 	{
+		SCOPE_CYCLE_COUNTER(STAT_PPCharacterDeath);
+
 		Replicated_IsDead = true;
+		UpdateRegistryStatus();
 
 		// Drop any held item
 		Server_DropHeldItem();
 
+		// Off the navmesh first, as leaving nav walking resets the capsule's responses
+		GetPPCharacterMovement()->SetNavWalkingAllowed(false);
+
 		// Disable collision with doors and other pawns on death
 		Server_SetAllowOverlapPawns(true);
 		Server_SetAllowOverlapDynamic(true);
 
-		// Disable movement and collision avoidance
-		GetCharacterMovement()->DisableMovement();
-		GetCharacterMovement()->SetAvoidanceEnabled(false);
+		// Disable movement, perception and interaction
+		EnterCorpseState();
 
 		// Call the blueprint event for blueprint effects
 		BPEvent_OnDie();
 
-		// Do the same for the player controller, if applicable
+		// Do the same for the player controller, if applicable, which takes over a ghost first
 		APrincessPigPlayerController* PPPController = Cast<APrincessPigPlayerController>(GetController());
 		if (PPPController)
 		{
+			PPPController->PossessGhost();
 			PPPController->BPEvent_OnCharacterDeath();
 		}
 	}
 }
 
+void APrincessPigCharacter::OnRep_IsDead()
+{
+	if (Replicated_IsDead)
+	{
+		EnterCorpseState();
+	}
+}
+
+void APrincessPigCharacter::UpdateRegistryStatus()
+{
+	if (ACharacterRegistry* Registry = CharacterRegistry.Get())
+	{
+		Registry->UpdateStatus(this);
+	}
+}
+
+void APrincessPigCharacter::EnterCorpseState()
+{
+	GetPPCharacterMovement()->SetNavWalkingAllowed(false);
+
+	UCharacterMovementComponent* Movement = GetCharacterMovement();
+	Movement->StopMovementImmediately();
+	Movement->DisableMovement();
+	SetCollisionAvoidanceEnabled(false);
+	Movement->SetComponentTickEnabled(false);
+	Movement->Deactivate();
+
+	// Guards ignore the dead anyway, so don't make them sense us
+	if (HasAuthority())
+	{
+		PerceptionStimuliSource->UnregisterFromPerceptionSystem();
+	}
+
+	// The dead don't interact with anything
+	InteractionComponent->StopSensing();
+	AvailableInteractions.Reset();
+	InteractionIndex.MarkDirty();
+
+	if (HitboxProxies)
+	{
+		HitboxProxies->CloseHitWindow();
+	}
+
+	// Only animate the body when someone can see it
+	GetMesh()->MeshComponentUpdateFlag = EMeshComponentUpdateFlag::OnlyTickPoseWhenRendered;
+
+	SetActorTickEnabled(false);
+}
+
 #pragma endregion Health
 
 
@@ -451,6 +632,7 @@ void APrincessPigCharacter::RespondToInteractionBeginOverlap(UPrimitiveComponent
 		if (OtherActor != this)
 		{
 			AvailableInteractions.Add(OtherActor);
+			InteractionIndex.MarkDirty();
 		}
 
 	}
@@ -463,16 +645,32 @@ void APrincessPigCharacter::RespondToInteractionEndOverlap(UPrimitiveComponent*
 		if (OtherActor != this)
 		{
 			AvailableInteractions.Remove(OtherActor);
+			InteractionIndex.MarkDirty();
 		}
 
 	}
 }
 
+void APrincessPigCharacter::OnRep_AvailableInteractions()
+{
+	InteractionIndex.MarkDirty();
+}
+
+AActor* APrincessPigCharacter::GetTopInteraction()
+{
+	return InteractionIndex.GetTop(this, AvailableInteractions);
+}
+
 bool APrincessPigCharacter::Server_Interact_Validate(AActor* InteractTarget) { return true; }
 void APrincessPigCharacter::Server_Interact_Implementation(AActor* InteractTarget)
 {
 	if (InteractTarget && AvailableInteractions.Contains(InteractTarget))
 	{
+		if (HitboxProxies)
+		{
+			HitboxProxies->OpenHitWindow(HitWindowDuration);
+		}
+
 		GEngine->AddOnScreenDebugMessage(123445, 6.f, FColor::White, FString("Interacting with ") + InteractTarget->GetName());
 		if (InteractTarget->ActorHasTag("Item"))
 		{
@@ -508,7 +706,8 @@ void APrincessPigCharacter::Server_PickUpItem_Implementation(AActor* ItemActor)
 			if (!HeldItem)
 			{
 				HeldItem = Item;
-				HeldItem->BPEvent_OnPickedUp(this);
+				MarkNetStateChanged();
+				HeldItem->PickedUp(this);
 			}
 			else
 			{
@@ -534,8 +733,9 @@ void APrincessPigCharacter::Server_DropHeldItem_Implementation()
 {
 	if (HeldItem)
 	{
-		HeldItem->BPEvent_OnDropped();
+		HeldItem->Dropped();
 		HeldItem = nullptr;
+		MarkNetStateChanged();
 	}
 }
 
@@ -569,6 +769,7 @@ void APrincessPigCharacter::BeginFollowing(APrincessPigCharacter* NewLeader)
 	}
 
 	Leader = NewLeader;
+	MarkNetStateChanged();
 	
 	// Notify new leader
 	Leader->UpdateFollowerStatus(this, true);
@@ -599,6 +800,7 @@ void APrincessPigCharacter::StopFollowing(APrincessPigCharacter* ThisLeader)
 		}
 
 		Leader = nullptr;
+		MarkNetStateChanged();
 
 		// Set new leader (nullptr) in controller
 		IFollow* FollowInterface = Cast<IFollow>(GetController());
@@ -645,6 +847,25 @@ void APrincessPigCharacter::UpdateFollowerStatus(APrincessPigCharacter* Follower
 	{
 		Followers.Remove(Follower);
 	}
+
+	// Only leave a trail while someone is following it
+	LeaderTrail->SetRecording(Followers.Num() > 0);
+	Formation->NotifyFollowersChanged();
+
+	FPPInteractionIndex::NotifyFollowerStatusChanged();
+	MarkNetStateChanged();
+}
+
+void APrincessPigCharacter::SetCanBecomeFollower(bool bCanBecomeFollower)
+{
+	Replicated_CanBecomeFollower = bCanBecomeFollower;
+	FPPInteractionIndex::NotifyFollowerStatusChanged();
+	MarkNetStateChanged();
+}
+
+void APrincessPigCharacter::OnRep_FollowerStatus()
+{
+	FPPInteractionIndex::NotifyFollowerStatusChanged();
 }
 
 #pragma endregion FollowAndLead
@@ -662,14 +883,73 @@ void APrincessPigCharacter::Server_BroadcastOverheadMessage_Implementation(float
 bool APrincessPigCharacter::Multicast_ShowOverheadMessage_Validate(float Duration, FColor Color, const FText& Message) { return true; }
 void APrincessPigCharacter::Multicast_ShowOverheadMessage_Implementation(float Duration, FColor Color, const FText& Message)
 {
-	OverheadText->SetText(Message);
-	OverheadText->SetTextRenderColor(Color);
-	GetWorld()->GetTimerManager().SetTimer(OverheadMessageTimerHandle, this, &APrincessPigCharacter::OnMessageTimerExpired, Duration, false);
+	// The manager owns the billboard, and doesn't exist on a dedicated server
+	if (AOverheadMessageManager* MessageManager = AOverheadMessageManager::Get(this))
+	{
+		MessageManager->ShowMessage(this, Message, Color, Duration, OverheadMessageOffset);
+	}
+}
+
+void APrincessPigCharacter::BroadcastOverheadMessageById(int32 MessageId, uint8 PaletteIndex, float Duration)
+{
+	if (MessageId < 0 || MessageId > MAX_uint16)
+	{
+		UE_LOG(LogPrincessPig, Warning, TEXT("%s: overhead message id %d out of range"), *GetName(), MessageId);
+		return;
+	}
+
+	Server_BroadcastOverheadMessageById((uint16)MessageId, PaletteIndex, UOverheadMessageTable::QuantizeDuration(Duration));
+}
+
+void APrincessPigCharacter::BroadcastOverheadMessageByKey(FName Key, uint8 PaletteIndex, float Duration)
+{
+	const int32 MessageId = OverheadMessageTable ? OverheadMessageTable->FindMessageId(Key) : INDEX_NONE;
+	if (MessageId == INDEX_NONE)
+	{
+		UE_LOG(LogPrincessPig, Warning, TEXT("%s: no overhead message with key %s"), *GetName(), *Key.ToString());
+		return;
+	}
+
+	BroadcastOverheadMessageById(MessageId, PaletteIndex, Duration);
+}
+
+bool APrincessPigCharacter::Server_BroadcastOverheadMessageById_Validate(uint16 MessageId, uint8 PaletteIndex, uint8 QuantizedDuration) { return true; }
+void APrincessPigCharacter::Server_BroadcastOverheadMessageById_Implementation(uint16 MessageId, uint8 PaletteIndex, uint8 QuantizedDuration)
+{
+	// Batch with everyone else shouting this frame
+	APrincessPigGameState* PPGameState = GetWorld()->GetGameState<APrincessPigGameState>();
+	if (PPGameState)
+	{
+		FPPOverheadMessageEvent Message;
+		Message.Speaker = this;
+		Message.MessageId = MessageId;
+		Message.PaletteIndex = PaletteIndex;
+		Message.QuantizedDuration = QuantizedDuration;
+		PPGameState->QueueOverheadMessage(Message);
+	}
+	else
+	{
+		Multicast_ShowOverheadMessageById(MessageId, PaletteIndex, QuantizedDuration);
+	}
+}
+
+bool APrincessPigCharacter::Multicast_ShowOverheadMessageById_Validate(uint16 MessageId, uint8 PaletteIndex, uint8 QuantizedDuration) { return true; }
+void APrincessPigCharacter::Multicast_ShowOverheadMessageById_Implementation(uint16 MessageId, uint8 PaletteIndex, uint8 QuantizedDuration)
+{
+	ShowOverheadMessageById(MessageId, PaletteIndex, UOverheadMessageTable::DequantizeDuration(QuantizedDuration));
 }
 
-void APrincessPigCharacter::OnMessageTimerExpired()
+void APrincessPigCharacter::ShowOverheadMessageById(int32 MessageId, uint8 PaletteIndex, float Duration)
 {
-	OverheadText->SetText(FText::FromString(""));
+	if (nullptr == OverheadMessageTable)
+	{
+		return;
+	}
+
+	if (AOverheadMessageManager* MessageManager = AOverheadMessageManager::Get(this))
+	{
+		MessageManager->ShowMessage(this, OverheadMessageTable->GetMessage(MessageId), OverheadMessageTable->GetColor(PaletteIndex), Duration, OverheadMessageOffset);
+	}
 }
 
 #pragma endregion OverheadMessages
@@ -727,6 +1007,7 @@ bool APrincessPigCharacter::Server_SetAllowOverlapPawns_Validate(bool AllowOverl
 void APrincessPigCharacter::Server_SetAllowOverlapPawns_Implementation(bool AllowOverlapPawns)
 {
 	Replicated_AllowOverlapPawns = AllowOverlapPawns;
+	MarkNetStateChanged();
 	OnRep_AllowOverlapPawns();
 }
 
@@ -748,6 +1029,7 @@ bool APrincessPigCharacter::Server_SetAllowOverlapDynamic_Validate(bool AllowOve
 void APrincessPigCharacter::Server_SetAllowOverlapDynamic_Implementation(bool AllowOverlapDynamic)
 {
 	Replicated_AllowOverlapDynamic = AllowOverlapDynamic;
+	MarkNetStateChanged();
 	OnRep_AllowOverlapDynamic();
 }
 
@@ -766,3 +1048,175 @@ void APrincessPigCharacter::OnRep_AllowOverlapDynamic()
 
 #pragma endregion Replication
 
+
+
+#pragma region NetUpdatePolicy
+
+void APrincessPigCharacter::EvaluateNetUpdatePolicy()
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+	const bool bIsMoving = GetVelocity().SizeSquared() > FMath::Square(NetUpdatePolicy.IdleSpeed);
+
+	// Dead and at rest for a while: nothing left to replicate
+	if (Replicated_IsDead)
+	{
+		if (NetUpdatePolicy.bDormantWhenDead && !bIsMoving && Now - LastNetActivityTime > 1.f)
+		{
+			SetNetUpdateTier(EPPNetUpdateTier::Dormant);
+		}
+		else
+		{
+			SetNetUpdateTier(EPPNetUpdateTier::Idle);
+		}
+		return;
+	}
+
+	// Players always get the full rate
+	if (IsPlayerControlled())
+	{
+		SetNetUpdateTier(EPPNetUpdateTier::Active);
+		return;
+	}
+
+	// Is any player close enough to care?
+	bool bNearPlayer = false;
+	const float NearDistanceSquared = FMath::Square(NetUpdatePolicy.NearPlayerDistance);
+	for (FConstPlayerControllerIterator Iterator = GetWorld()->GetPlayerControllerIterator(); Iterator; ++Iterator)
+	{
+		APlayerController* PlayerController = Iterator->Get();
+		AActor* ViewTarget = PlayerController ? PlayerController->GetViewTarget() : nullptr;
+		if (ViewTarget && FVector::DistSquared(ViewTarget->GetActorLocation(), GetActorLocation()) < NearDistanceSquared)
+		{
+			bNearPlayer = true;
+			break;
+		}
+	}
+
+	if (!bNearPlayer)
+	{
+		SetNetUpdateTier(EPPNetUpdateTier::Distant);
+	}
+	else if (bIsMoving || Leader)
+	{
+		SetNetUpdateTier(EPPNetUpdateTier::Active);
+	}
+	else
+	{
+		SetNetUpdateTier(EPPNetUpdateTier::Idle);
+	}
+}
+
+void APrincessPigCharacter::SetNetUpdateTier(EPPNetUpdateTier NewTier)
+{
+	if (NewTier == NetUpdateTier)
+	{
+		return;
+	}
+
+	// Remove the old tier from the stats
+	switch (NetUpdateTier)
+	{
+	case EPPNetUpdateTier::Active: DEC_DWORD_STAT(STAT_PPNetActiveCharacters); break;
+	case EPPNetUpdateTier::Idle: DEC_DWORD_STAT(STAT_PPNetIdleCharacters); break;
+	case EPPNetUpdateTier::Distant: DEC_DWORD_STAT(STAT_PPNetDistantCharacters); break;
+	case EPPNetUpdateTier::Dormant: DEC_DWORD_STAT(STAT_PPNetDormantCharacters); break;
+	default: break;
+	}
+	if (NetUpdateTier != EPPNetUpdateTier::None && NetUpdateTier != EPPNetUpdateTier::Dormant)
+	{
+		DEC_FLOAT_STAT_BY(STAT_PPCharacterNetUpdateRate, NetUpdateFrequency);
+	}
+
+	const EPPNetUpdateTier OldTier = NetUpdateTier;
+	NetUpdateTier = NewTier;
+
+	switch (NewTier)
+	{
+	case EPPNetUpdateTier::Active:
+		NetUpdateFrequency = NetUpdatePolicy.ActiveFrequency;
+		INC_DWORD_STAT(STAT_PPNetActiveCharacters);
+		break;
+	case EPPNetUpdateTier::Idle:
+		NetUpdateFrequency = NetUpdatePolicy.IdleFrequency;
+		INC_DWORD_STAT(STAT_PPNetIdleCharacters);
+		break;
+	case EPPNetUpdateTier::Distant:
+		NetUpdateFrequency = NetUpdatePolicy.DistantFrequency;
+		INC_DWORD_STAT(STAT_PPNetDistantCharacters);
+		break;
+	case EPPNetUpdateTier::Dormant:
+		INC_DWORD_STAT(STAT_PPNetDormantCharacters);
+		break;
+	default:
+		break;
+	}
+	if (NewTier != EPPNetUpdateTier::None && NewTier != EPPNetUpdateTier::Dormant)
+	{
+		INC_FLOAT_STAT_BY(STAT_PPCharacterNetUpdateRate, NetUpdateFrequency);
+	}
+
+	// Dormancy
+	if (NewTier == EPPNetUpdateTier::Dormant)
+	{
+		SetNetDormancy(DORM_DormantAll);
+	}
+	else if (OldTier == EPPNetUpdateTier::Dormant && NewTier != EPPNetUpdateTier::None)
+	{
+		SetNetDormancy(DORM_Awake);
+	}
+
+	// Don't wait out a long interval from the old rate
+	if (NewTier == EPPNetUpdateTier::Active && HasAuthority())
+	{
+		ForceNetUpdate();
+	}
+}
+
+void APrincessPigCharacter::MarkNetStateChanged()
+{
+	if (!HasAuthority() || !GetWorld())
+	{
+		return;
+	}
+
+	LastNetActivityTime = GetWorld()->GetTimeSeconds();
+
+	// Wake up straight away, the next evaluation will settle on the right tier
+	if (NetUpdateTier != EPPNetUpdateTier::None)
+	{
+		SetNetUpdateTier(EPPNetUpdateTier::Active);
+	}
+}
+
+#pragma endregion NetUpdatePolicy
+
+
+
+#pragma region Relevancy
+
+bool APrincessPigCharacter::IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const
+{
+	// Owners, attachments, etc. follow the default rules
+	if (!CameraRelevancy.bEnabled ||
+		bAlwaysRelevant ||
+		bOnlyRelevantToOwner ||
+		IsOwnedBy(ViewTarget) ||
+		IsOwnedBy(RealViewer) ||
+		this == ViewTarget ||
+		ViewTarget == Instigator ||
+		GetAttachParentActor())
+	{
+		return Super::IsNetRelevantFor(RealViewer, ViewTarget, SrcLocation);
+	}
+
+	// A leader always knows where their followers are, and vice versa
+	if (ViewTarget && (ViewTarget == Leader || Followers.Contains(ViewTarget)))
+	{
+		return true;
+	}
+
+	return CameraRelevancy.IsRelevant(GetActorLocation(), RealViewer, SrcLocation);
+}
+
+#pragma endregion Relevancy
+
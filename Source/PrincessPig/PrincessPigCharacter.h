@@ -6,12 +6,15 @@
 #include "GameFramework/Character.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GenericTeamAgentInterface.h"
+#include "CameraRelevancy.h"
+#include "InteractionIndex.h"
 #include "PrincessPigCharacter.generated.h"
 
-class UTextRenderComponent;
 class UBehaviorTree;
 class APatrolRoute;
 class AItem;
+class UPPCharacterMovementComponent;
+class ACharacterRegistry;
 
 UENUM(BlueprintType)
 enum class EPPMovementMode : uint8
@@ -20,6 +23,60 @@ enum class EPPMovementMode : uint8
 	Running UMETA(DisplayName = "Running")
 };
 
+UENUM(BlueprintType)
+enum class EPPNetUpdateTier : uint8
+{
+	None UMETA(DisplayName = "None"),
+	Active UMETA(DisplayName = "Active"),
+	Idle UMETA(DisplayName = "Idle"),
+	Distant UMETA(DisplayName = "Distant"),
+	Dormant UMETA(DisplayName = "Dormant")
+};
+
+/** How often a character should replicate, depending on what it is doing */
+USTRUCT(BlueprintType)
+struct FPPNetUpdatePolicy
+{
+	GENERATED_BODY()
+
+	/** Update rate while moving near a player, or while player controlled */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Replication")
+	float ActiveFrequency;
+
+	/** Update rate while standing still near a player */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Replication")
+	float IdleFrequency;
+
+	/** Update rate when no player is within NearPlayerDistance */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Replication")
+	float DistantFrequency;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Replication")
+	float NearPlayerDistance;
+
+	/** Below this speed a character counts as idle */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Replication")
+	float IdleSpeed;
+
+	/** Seconds between re-evaluating the tier */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Replication")
+	float EvaluationInterval;
+
+	/** Dead characters stop replicating once they have come to rest, and wake on any state change */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Replication")
+	bool bDormantWhenDead;
+
+	FPPNetUpdatePolicy()
+		: ActiveFrequency(30.f)
+		, IdleFrequency(5.f)
+		, DistantFrequency(2.f)
+		, NearPlayerDistance(3000.f)
+		, IdleSpeed(10.f)
+		, EvaluationInterval(0.25f)
+		, bDormantWhenDead(true)
+	{}
+};
+
 
 UCLASS(Blueprintable)
 class APrincessPigCharacter : public ACharacter, public IGenericTeamAgentInterface
@@ -27,16 +84,19 @@ class APrincessPigCharacter : public ACharacter, public IGenericTeamAgentInterfa
 	GENERATED_BODY()
 
 public:
-	APrincessPigCharacter();
+	APrincessPigCharacter(const FObjectInitializer& ObjectInitializer);
 
-	virtual void Tick(float DeltaSeconds) override;
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 	FORCEINLINE class UCameraComponent* GetTopDownCameraComponent() const { return TopDownCameraComponent; }
 	FORCEINLINE class USpringArmComponent* GetCameraBoom() const { return CameraBoom; }
 	FORCEINLINE class UAIPerceptionStimuliSourceComponent* GetPerceptionStimuliSource() { return PerceptionStimuliSource; }
 	FORCEINLINE class UInteractionComponent* GetInteractionComponent() { return InteractionComponent; }
 
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Movement")
+	UPPCharacterMovementComponent* GetPPCharacterMovement() const;
+
 private:
 	/** Top down camera */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
@@ -55,6 +115,22 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Interaction")
 	class UInteractionComponent* InteractionComponent;
 
+	/** Server-side history of where this character was, for validating hits from laggy clients */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Subdue")
+	class ULagCompensationComponent* LagCompensation;
+
+	/** Simple bone-following shapes the server uses instead of refreshing every skeleton every frame */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Subdue")
+	class UHitboxProxyComponent* HitboxProxies;
+
+	/** Breadcrumbs followers walk along, recorded while this character has followers */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Follow")
+	class ULeaderTrailComponent* LeaderTrail;
+
+	/** Hands out a spot along the trail to each follower */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Follow")
+	class UFormationComponent* Formation;
+
 	/** Scene component for held items to attach to */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Items")
 	class USceneComponent* ItemHandle;
@@ -101,9 +177,12 @@ public:
 	UFUNCTION(Server, Reliable, WithValidation, BlueprintCallable, Category = "Movement")
 	void Server_SetPlayerInputForce(float Value);
 
-	UPROPERTY(Replicated, Transient, BlueprintReadWrite, Category = "Movement")
+	UPROPERTY(ReplicatedUsing = OnRep_MovementMode, Transient, BlueprintReadWrite, Category = "Movement")
 	EPPMovementMode MovementMode;
 
+	UFUNCTION(Category = "Movement")
+	virtual void OnRep_MovementMode();
+
 	/** Max speed while walking
 	* This value is written to MaxWalkSpeed in Character Movement */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Movement")
@@ -132,7 +211,7 @@ public:
 	UFUNCTION(Server, Reliable, WithValidation, BlueprintCallable, Category = "Movement")
 	void Server_SetMovementMode(EPPMovementMode NewMovementMode);
 
-	/* Updates CharacterMovement variables to reflect movement mode and status effects */
+	/* Passes movement mode and status effects on to CharacterMovement, which predicts them */
 	UFUNCTION(BlueprintCallable, Category = "Movement")
 		virtual void UpdateMovementModifiers();
 
@@ -163,9 +242,19 @@ public:
 
 #pragma region Interaction
 
-	UPROPERTY(Replicated, BlueprintReadWrite, Category = "Interaction")
+	UPROPERTY(ReplicatedUsing = OnRep_AvailableInteractions, BlueprintReadWrite, Category = "Interaction")
 		TArray<AActor*> AvailableInteractions;
 
+	UFUNCTION()
+		void OnRep_AvailableInteractions();
+
+	/** AvailableInteractions sorted by priority, only rescored when they or follower status change */
+	FPPInteractionIndex InteractionIndex;
+
+	/** The interaction the player would get by pressing interact now */
+	UFUNCTION(BlueprintCallable, Category = "Interaction")
+		AActor* GetTopInteraction();
+
 	UPROPERTY(Replicated, BlueprintReadWrite, Category = "Interaction")
 		AActor* HighestPriorityInteraction;
 
@@ -237,6 +326,38 @@ public:
 	UFUNCTION(BlueprintImplementableEvent, Category = "Subdue")
 		void BPEvent_OnEndSubdued();
 
+	/** How far in front of us a strike reaches */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Subdue")
+		float StrikeReach;
+
+	/** Thickness of the strike sweep */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Subdue")
+		float StrikeRadius;
+
+	/** How long a target stays subdued after being struck (0 for none) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Subdue")
+		float StrikeSubdueDuration;
+
+	/** Damage dealt to a struck target (0 for none) */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Subdue")
+		float StrikeDamage;
+
+	/** How long bones keep refreshing on the server after a strike or interaction */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Subdue")
+		float HitWindowDuration;
+
+	/** Strike Target as it appears on this machine right now. Hits are validated on the server */
+	UFUNCTION(BlueprintCallable, Category = "Subdue")
+		void Strike(APrincessPigCharacter* Target);
+
+	/** ClientTime is the server world time the client saw when striking, see AGameStateBase::GetServerWorldTimeSeconds */
+	UFUNCTION(Server, Reliable, WithValidation, Category = "Subdue")
+		void Server_Strike(APrincessPigCharacter* Target, float ClientTime);
+
+	/** Called on the server when a strike lands */
+	UFUNCTION(BlueprintImplementableEvent, Category = "Subdue")
+		void BPEvent_OnStrikeHit(APrincessPigCharacter* Target);
+
 #pragma endregion Subdue
 
 
@@ -346,9 +467,15 @@ public:
 	UPROPERTY(Replicated, EditAnywhere, BlueprintReadWrite, Category = "Health")
 		float Replicated_CurrentHealth;
 
-	UPROPERTY(Replicated, EditAnywhere, BlueprintReadWrite, Category = "Health")
+	UPROPERTY(ReplicatedUsing = OnRep_IsDead, EditAnywhere, BlueprintReadWrite, Category = "Health")
 		bool Replicated_IsDead;
 
+	UFUNCTION()
+		virtual void OnRep_IsDead();
+
+	/** Strip the character down to a body on the floor: no movement, perception, interaction or ticking */
+	virtual void EnterCorpseState();
+
 	UFUNCTION(Server, Reliable, WithValidation, BlueprintCallable, Category = "Health")
 		void Server_TakeDamage(float Damage);
 
@@ -364,11 +491,18 @@ public:
 	UPROPERTY(Replicated, BlueprintReadOnly)
 	APrincessPigCharacter* Leader;
 	
-	UPROPERTY(Replicated)
+	UPROPERTY(ReplicatedUsing = OnRep_FollowerStatus)
 	TArray<APrincessPigCharacter*> Followers;
 	
-	UPROPERTY(Replicated, EditAnywhere, BlueprintReadWrite, Category = "Follow")
+	UPROPERTY(ReplicatedUsing = OnRep_FollowerStatus, EditAnywhere, BlueprintReadWrite, Category = "Follow")
 	bool Replicated_CanBecomeFollower;
+
+	/** Set Replicated_CanBecomeFollower and let interaction indices know. Server only */
+	UFUNCTION(BlueprintCallable, Category = "Follow")
+	void SetCanBecomeFollower(bool bCanBecomeFollower);
+
+	UFUNCTION()
+	void OnRep_FollowerStatus();
 	
 	UFUNCTION(BlueprintCallable, Category = "Follow")
 	virtual void BeginFollowing(APrincessPigCharacter* NewLeader);
@@ -391,10 +525,13 @@ public:
 
 #pragma region OverheadMessages
 
+	/**
+	 * Where messages appear, relative to the actor location. Billboards come from AOverheadMessageManager.
+	 * This replaces the OverheadText component: move messages with this, and show them with
+	 * Multicast_ShowOverheadMessage or BroadcastOverheadMessageById rather than setting text directly.
+	 */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "OverheadMessages")
-	UTextRenderComponent* OverheadText;
-
-	FTimerHandle OverheadMessageTimerHandle;
+	FVector OverheadMessageOffset;
 
 	UFUNCTION(Server, Unreliable, WithValidation, BlueprintCallable, Category = "OverheadMessages")
 	void Server_BroadcastOverheadMessage(float Duration, FColor Color, const FText& Message);
@@ -402,8 +539,26 @@ public:
 	UFUNCTION(NetMulticast, Unreliable, WithValidation, BlueprintCallable, Category = "OverheadMessages")
 	void Multicast_ShowOverheadMessage(float Duration, FColor Color, const FText& Message);
 
-	UFUNCTION()
-	void OnMessageTimerExpired();
+	/** Lines this character can shout by ID. Must be the same asset on every machine */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "OverheadMessages")
+	class UOverheadMessageTable* OverheadMessageTable;
+
+	/** Shout a line from OverheadMessageTable. Much cheaper to send than Server_BroadcastOverheadMessage */
+	UFUNCTION(BlueprintCallable, Category = "OverheadMessages")
+	void BroadcastOverheadMessageById(int32 MessageId, uint8 PaletteIndex, float Duration);
+
+	UFUNCTION(BlueprintCallable, Category = "OverheadMessages")
+	void BroadcastOverheadMessageByKey(FName Key, uint8 PaletteIndex, float Duration);
+
+	UFUNCTION(Server, Unreliable, WithValidation)
+	void Server_BroadcastOverheadMessageById(uint16 MessageId, uint8 PaletteIndex, uint8 QuantizedDuration);
+
+	/** Used instead of the batched game state multicast if the game mode doesn't use APrincessPigGameState */
+	UFUNCTION(NetMulticast, Unreliable, WithValidation)
+	void Multicast_ShowOverheadMessageById(uint16 MessageId, uint8 PaletteIndex, uint8 QuantizedDuration);
+
+	/** Display a line from OverheadMessageTable on this machine only */
+	void ShowOverheadMessageById(int32 MessageId, uint8 PaletteIndex, float Duration);
 
 #pragma endregion OverheadMessages
 
@@ -442,5 +597,58 @@ public:
 	void Server_SetAllowOverlapDynamic(bool AllowOverlapDynamic);
 
 #pragma endregion Replication
+
+
+
+#pragma region NetUpdatePolicy
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Replication")
+	FPPNetUpdatePolicy NetUpdatePolicy;
+
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "Replication")
+	EPPNetUpdateTier NetUpdateTier;
+
+	FTimerHandle NetUpdatePolicyTimer;
+
+	/** Last time replicated state changed on the server */
+	float LastNetActivityTime;
+
+	/** Picks a tier from activity and player proximity (server only) */
+	UFUNCTION()
+	void EvaluateNetUpdatePolicy();
+
+	void SetNetUpdateTier(EPPNetUpdateTier NewTier);
+
+	/** Call on the server after changing replicated state, so a dormant character gets woken up */
+	void MarkNetStateChanged();
+
+#pragma endregion NetUpdatePolicy
+
+
+
+#pragma region Relevancy
+
+	/** Only relevant to clients whose camera can (nearly) see us */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Replication")
+	FPPCameraRelevancy CameraRelevancy;
+
+	virtual bool IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const override;
+
+#pragma endregion Relevancy
+
+
+
+#pragma region CharacterRegistry
+
+	/** Server only. Where this character's state is packed for AI queries, see ACharacterRegistry */
+	TWeakObjectPtr<ACharacterRegistry> CharacterRegistry;
+
+	/** Index into the registry's arrays, INDEX_NONE until the first snapshot after registering */
+	int32 CharacterRegistryIndex;
+
+	/** Let the registry know a status changed. Call on the server after setting any of the status flags */
+	void UpdateRegistryStatus();
+
+#pragma endregion CharacterRegistry
 };
 
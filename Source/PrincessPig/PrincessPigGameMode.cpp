@@ -3,17 +3,167 @@
 #include "PrincessPigGameMode.h"
 #include "PrincessPigPlayerController.h"
 #include "PrincessPigCharacter.h"
+#include "PrincessPigGameState.h"
+#include "ActorPool.h"
+#include "DangerMap.h"
+#include "PooledPawnComponent.h"
+#include "PrincessPig.h"
+#include "Engine/World.h"
 #include "UObject/ConstructorHelpers.h"
 
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ghost Pool Misses"), STAT_PPGhostPoolMisses, STATGROUP_PrincessPig);
+DECLARE_CYCLE_STAT(TEXT("Ghost Acquire"), STAT_PPGhostAcquire, STATGROUP_PrincessPig);
+
 APrincessPigGameMode::APrincessPigGameMode()
 {
 	// use our custom PlayerController class
 	PlayerControllerClass = APrincessPigPlayerController::StaticClass();
 
+	// batches overhead messages
+	GameStateClass = APrincessPigGameState::StaticClass();
+
 	// set default pawn class to our Blueprinted character
 	static ConstructorHelpers::FClassFinder<APawn> PlayerPawnBPClass(TEXT("/Game/Characters/BP_Grey"));
 	if (PlayerPawnBPClass.Class != NULL)
 	{
 		DefaultPawnClass = PlayerPawnBPClass.Class;
 	}
-}
\ No newline at end of file
+
+	// dead players become ghosts
+	static ConstructorHelpers::FClassFinder<APawn> GhostPawnBPClass(TEXT("/Game/Characters/BP_Ghost"));
+	if (GhostPawnBPClass.Class != NULL)
+	{
+		GhostPawnClass = GhostPawnBPClass.Class;
+	}
+	GhostPoolSize = 4;
+}
+
+void APrincessPigGameMode::StartPlay()
+{
+	// Prewarm pooled actors at map load, rather than on first use
+	AActorPool::GetActorPool(this);
+
+	// Escapees only look the danger map up, so it has to exist before they start wandering
+	ADangerMap::GetDangerMap(this);
+
+	// Same for ghosts, which can't go in the actor pool as they are pawns
+	if (GhostPawnClass)
+	{
+		const FTransform Hidden(FVector::ZeroVector);
+		while (FreeGhostPawns.Num() < GhostPoolSize)
+		{
+			APawn* Ghost = SpawnGhostPawn(Hidden);
+			if (nullptr == Ghost)
+			{
+				break;
+			}
+			SetGhostPawnActive(Ghost, false);
+			FreeGhostPawns.Add(Ghost);
+		}
+	}
+
+	Super::StartPlay();
+}
+
+#pragma region Ghosts
+
+APawn* APrincessPigGameMode::SpawnGhostPawn(const FTransform& Transform)
+{
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	APawn* Ghost = GetWorld()->SpawnActor<APawn>(GhostPawnClass, Transform, SpawnParams);
+
+	// Replicates whether the ghost is in use, so clients hide it and turn off its collision too
+	if (Ghost && nullptr == Ghost->FindComponentByClass<UPooledPawnComponent>())
+	{
+		UPooledPawnComponent* Pooled = NewObject<UPooledPawnComponent>(Ghost, TEXT("PooledPawn"));
+		Pooled->RegisterComponent();
+	}
+	return Ghost;
+}
+
+APawn* APrincessPigGameMode::AcquireGhostPawn(const FTransform& Transform)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PPGhostAcquire);
+
+	if (nullptr == *GhostPawnClass)
+	{
+		return nullptr;
+	}
+
+	APawn* Ghost = nullptr;
+	while (FreeGhostPawns.Num() > 0 && nullptr == Ghost)
+	{
+		Ghost = FreeGhostPawns.Pop(false);
+		if (Ghost && Ghost->IsPendingKillPending())
+		{
+			Ghost = nullptr;
+		}
+	}
+
+	if (Ghost)
+	{
+		Ghost->SetActorTransform(Transform, false, nullptr, ETeleportType::TeleportPhysics);
+		SetGhostPawnActive(Ghost, true);
+	}
+	else
+	{
+		INC_DWORD_STAT(STAT_PPGhostPoolMisses);
+		Ghost = SpawnGhostPawn(Transform);
+	}
+
+	return Ghost;
+}
+
+void APrincessPigGameMode::ReleaseGhostPawn(APawn* Ghost)
+{
+	if (nullptr == Ghost || FreeGhostPawns.Contains(Ghost))
+	{
+		return;
+	}
+
+	if (Ghost->GetController())
+	{
+		Ghost->GetController()->UnPossess();
+	}
+
+	if (FreeGhostPawns.Num() >= GhostPoolSize)
+	{
+		Ghost->Destroy();
+		return;
+	}
+
+	SetGhostPawnActive(Ghost, false);
+	FreeGhostPawns.Add(Ghost);
+}
+
+bool APrincessPigGameMode::IsGhostPawn(APawn* Pawn) const
+{
+	return Pawn && GhostPawnClass && Pawn->IsA(GhostPawnClass);
+}
+
+void APrincessPigGameMode::SetGhostPawnActive(APawn* Ghost, bool bActive)
+{
+	if (bActive && Ghost->NetDormancy > DORM_Awake)
+	{
+		Ghost->SetNetDormancy(DORM_Awake);
+	}
+
+	if (UPooledPawnComponent* Pooled = Ghost->FindComponentByClass<UPooledPawnComponent>())
+	{
+		Pooled->SetInUse(bActive);
+	}
+
+	if (bActive)
+	{
+		Ghost->ForceNetUpdate();
+	}
+	else
+	{
+		// Send the hidden state, then stop replicating until it is needed again
+		Ghost->FlushNetDormancy();
+		Ghost->SetNetDormancy(DORM_DormantAll);
+	}
+}
+
+#pragma endregion Ghosts
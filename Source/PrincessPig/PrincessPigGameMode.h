@@ -13,6 +13,40 @@ class APrincessPigGameMode : public AGameModeBase
 
 public:
 	APrincessPigGameMode();
+
+	virtual void StartPlay() override;
+
+#pragma region Ghosts
+
+	/** Pawn a player takes over when their character dies */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ghosts")
+	TSubclassOf<APawn> GhostPawnClass;
+
+	/** Ghosts spawned and hidden when play starts, so a death doesn't have to spawn one */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ghosts")
+	int32 GhostPoolSize;
+
+	/** Take a ghost from the pool, or spawn one if none are free */
+	UFUNCTION(BlueprintCallable, Category = "Ghosts")
+	APawn* AcquireGhostPawn(const FTransform& Transform);
+
+	/** Hide a ghost and keep it for the next death */
+	UFUNCTION(BlueprintCallable, Category = "Ghosts")
+	void ReleaseGhostPawn(APawn* Ghost);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Ghosts")
+	bool IsGhostPawn(APawn* Pawn) const;
+
+protected:
+	UPROPERTY(Transient)
+	TArray<APawn*> FreeGhostPawns;
+
+	APawn* SpawnGhostPawn(const FTransform& Transform);
+
+	/** Show or hide a ghost, and turn its collision, ticking and replication on or off */
+	void SetGhostPawnActive(APawn* Ghost, bool bActive);
+
+#pragma endregion Ghosts
 };
 
 
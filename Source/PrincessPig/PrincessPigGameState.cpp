@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "PrincessPigGameState.h"
+#include "PrincessPig.h"
+#include "PrincessPigCharacter.h"
+#include "PrincessPigPlayerController.h"
+#include "Engine/World.h"
+#include "TimerManager.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Overhead Messages Sent"), STAT_PPOverheadMessagesSent, STATGROUP_PrincessPig);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Overhead Message RPCs"), STAT_PPOverheadMessageRPCs, STATGROUP_PrincessPig);
+
+APrincessPigGameState::APrincessPigGameState()
+{
+	MaxOverheadMessagesPerBatch = 32;
+}
+
+#pragma region OverheadMessages
+
+void APrincessPigGameState::QueueOverheadMessage(const FPPOverheadMessageEvent& Message)
+{
+	// The first message of a frame schedules the flush, the rest join it
+	if (PendingOverheadMessages.Num() == 0)
+	{
+		GetWorldTimerManager().SetTimerForNextTick(this, &APrincessPigGameState::FlushOverheadMessages);
+	}
+	PendingOverheadMessages.Add(Message);
+}
+
+void APrincessPigGameState::FlushOverheadMessages()
+{
+	const int32 BatchSize = FMath::Min(PendingOverheadMessages.Num(), FMath::Max(MaxOverheadMessagesPerBatch, 1));
+	if (BatchSize == 0)
+	{
+		return;
+	}
+
+	TArray<FPPOverheadMessageEvent> Batch(PendingOverheadMessages.GetData(), BatchSize);
+	PendingOverheadMessages.RemoveAt(0, BatchSize, false);
+
+	// Filtered per player the way the net driver would, from the player's view point
+	TArray<FPPOverheadMessageEvent> Relevant;
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		APrincessPigPlayerController* PlayerController = Cast<APrincessPigPlayerController>(It->Get());
+		if (nullptr == PlayerController)
+		{
+			continue;
+		}
+
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+		const AActor* ViewTarget = PlayerController->GetViewTarget();
+
+		Relevant.Reset();
+		for (const FPPOverheadMessageEvent& Message : Batch)
+		{
+			if (Message.Speaker && Message.Speaker->IsNetRelevantFor(PlayerController, ViewTarget, ViewLocation))
+			{
+				Relevant.Add(Message);
+			}
+		}
+
+		if (Relevant.Num() > 0)
+		{
+			PlayerController->Client_ShowOverheadMessages(Relevant);
+			INC_DWORD_STAT_BY(STAT_PPOverheadMessagesSent, Relevant.Num());
+			INC_DWORD_STAT(STAT_PPOverheadMessageRPCs);
+		}
+	}
+
+	if (PendingOverheadMessages.Num() > 0)
+	{
+		GetWorldTimerManager().SetTimerForNextTick(this, &APrincessPigGameState::FlushOverheadMessages);
+	}
+}
+
+#pragma endregion OverheadMessages
@@ -0,0 +1,39 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/GameStateBase.h"
+#include "OverheadMessageTable.h"
+#include "PrincessPigGameState.generated.h"
+
+UCLASS()
+class PRINCESSPIG_API APrincessPigGameState : public AGameStateBase
+{
+	GENERATED_BODY()
+
+public:
+	APrincessPigGameState();
+
+#pragma region OverheadMessages
+
+	/** Messages taken off the queue per flush. Anything over this goes in the next one */
+	UPROPERTY(EditDefaultsOnly, Category = "OverheadMessages")
+	int32 MaxOverheadMessagesPerBatch;
+
+	/**
+	 * Server only. Queue a message to go out with everything else shouted this frame. Each player
+	 * gets one RPC holding only the messages whose speakers are net relevant to them, so camera
+	 * relevancy culls shouts the same way it culls the speakers.
+	 */
+	void QueueOverheadMessage(const FPPOverheadMessageEvent& Message);
+
+protected:
+	/** A UPROPERTY so speakers destroyed before the flush are nulled rather than left dangling */
+	UPROPERTY(Transient)
+	TArray<FPPOverheadMessageEvent> PendingOverheadMessages;
+
+	void FlushOverheadMessages();
+
+#pragma endregion OverheadMessages
+};
@@ -9,6 +9,7 @@
 #include "GameFramework/CharacterMovementComponent.h"
 #include "Components/SphereComponent.h"
 #include "Item.h"
+#include "PrincessPigGameMode.h"
 
 #include "DrawDebugHelpers.h"
 
@@ -45,13 +46,19 @@ void APrincessPigPlayerController::PlayerTick(float DeltaTime)
 		SetAudioListenerOverride((USceneComponent*)PPCharacter->GetCapsuleComponent(), FVector(0, 0, 0), PPCharacter->GetActorRotation().GetInverse());
 	}
 
-	// Print the current interaction
+	// Print the current interaction, the prompt only changes when the top candidate does
 	if (IsLocalController())
 	{
-		if (GetHighestPriorityInteraction())
+		AActor* TopInteraction = GetHighestPriorityInteraction();
+		if (TopInteraction != PromptedInteraction.Get())
 		{
-			GEngine->AddOnScreenDebugMessage((uint64)GetUniqueID(), 0.1f, FColor::Cyan, FString("(E) ") + GetHighestPriorityInteraction()->GetName());
-			DrawDebugDirectionalArrow(GetWorld(), GetPawn()->GetActorLocation(), GetHighestPriorityInteraction()->GetActorLocation(), 1000, FColor::Cyan, false, 0, 0, 6.f);
+			PromptedInteraction = TopInteraction;
+			UpdateInteractionPrompt(TopInteraction);
+		}
+
+		if (TopInteraction)
+		{
+			DrawDebugDirectionalArrow(GetWorld(), GetPawn()->GetActorLocation(), TopInteraction->GetActorLocation(), 1000, FColor::Cyan, false, 0, 0, 6.f);
 		}
 	}
 
@@ -101,15 +108,23 @@ void APrincessPigPlayerController::SetupInputComponent()
 
 void APrincessPigPlayerController::Possess(APawn* Pawn)
 {
+	// Moving on from a ghost: put it back for the next death
+	APawn* PreviousPawn = GetPawn();
+	APrincessPigGameMode* GameMode = GetWorld()->GetAuthGameMode<APrincessPigGameMode>();
+	if (PreviousPawn && PreviousPawn != Pawn && GameMode && GameMode->IsGhostPawn(PreviousPawn))
+	{
+		GameMode->ReleaseGhostPawn(PreviousPawn);
+	}
+
 	Super::Possess(Pawn);
 	
-	Pawn->Tags.Add("Leader");
+	Pawn->Tags.AddUnique("Leader");
 
 	APrincessPigCharacter* PPCharacter = Cast<APrincessPigCharacter>(Pawn);
 	if (PPCharacter)
 	{
 		// We don't want players to become followers just yet
-		PPCharacter->Replicated_CanBecomeFollower = false;
+		PPCharacter->SetCanBecomeFollower(false);
 
 		// By default, players should be running - maybe later I'll add some shift+WASD or sensitive thumbstick controls
 		PPCharacter->SetMovementMode(EPPMovementMode::Running);	
@@ -216,68 +231,28 @@ void APrincessPigPlayerController::OnDismissPressed()
 
 AActor* APrincessPigPlayerController::GetHighestPriorityInteraction()
 {
-	// TODO: Maybe change this function to SortInteractions()
-
-	/* Priority ranking */
-	const float HoldableItemPriority = 4.f;
-	const float EscapeePriority = 2.f;
-	const float StaticInteractivePriority = 1.5f;
-	const float FollowerPriority = 1.f;
-
 	APrincessPigCharacter* PPCharacter = Cast<APrincessPigCharacter>(GetPawn());
 	if (PPCharacter)
 	{
-		AActor * HighestPriorityActor = nullptr;
-		float HighestPriority = 0;
-		for (auto & Actor : PPCharacter->AvailableInteractions)
-		{
-			if (!Actor)
-				continue;
-
-			if (Actor->ActorHasTag("Item"))
-			{
-				AItem* Item = Cast<AItem>(Actor);
-				if (Item)
-				{
-					if (HighestPriority < HoldableItemPriority)
-					{
-						HighestPriorityActor = Actor;
-						HighestPriority = HoldableItemPriority;
-					}
-				}
-			}
-
-			else if (Actor->ActorHasTag("Escapee"))
-			{
-				APrincessPigCharacter* Escapee = Cast<APrincessPigCharacter>(Actor);
-				if (Escapee && Escapee->Replicated_CanBecomeFollower)
-				{
-					if (PPCharacter->Followers.Contains(Escapee))
-					{
-						if (HighestPriority < FollowerPriority)
-						{
-							HighestPriorityActor = Actor;
-							HighestPriority = FollowerPriority;
-						}
-					}
-					else
-					{
-						if (HighestPriority < EscapeePriority)
-						{
-							HighestPriorityActor = Actor;
-							HighestPriority = EscapeePriority;
-						}
-					}
-				}
-			}
-
-		}
-		return HighestPriorityActor;
-
+		return PPCharacter->GetTopInteraction();
 	}
 	return nullptr;
 }
 
+void APrincessPigPlayerController::UpdateInteractionPrompt(AActor* TopInteraction)
+{
+	if (TopInteraction)
+	{
+		GEngine->AddOnScreenDebugMessage((uint64)GetUniqueID(), MAX_FLT, FColor::Cyan, FString("(E) ") + TopInteraction->GetName());
+	}
+	else
+	{
+		GEngine->AddOnScreenDebugMessage((uint64)GetUniqueID(), 0.f, FColor::Cyan, FString());
+	}
+
+	BPEvent_OnInteractionPromptChanged(TopInteraction);
+}
+
 #pragma endregion Interaction
 
 
@@ -290,3 +265,43 @@ void APrincessPigPlayerController::SetLeader_Implementation(APrincessPigCharacte
 
 #pragma endregion Followers
 
+
+
+#pragma region GameplayEvents
+
+APawn* APrincessPigPlayerController::PossessGhost()
+{
+	APrincessPigGameMode* GameMode = GetWorld()->GetAuthGameMode<APrincessPigGameMode>();
+	APawn* DeadPawn = GetPawn();
+	if (nullptr == GameMode || nullptr == DeadPawn)
+	{
+		return nullptr;
+	}
+
+	APawn* Ghost = GameMode->AcquireGhostPawn(DeadPawn->GetActorTransform());
+	if (Ghost)
+	{
+		Possess(Ghost);
+	}
+	return Ghost;
+}
+
+#pragma endregion GameplayEvents
+
+
+
+#pragma region OverheadMessages
+
+void APrincessPigPlayerController::Client_ShowOverheadMessages_Implementation(const TArray<FPPOverheadMessageEvent>& Messages)
+{
+	for (const FPPOverheadMessageEvent& Message : Messages)
+	{
+		// Relevant when sent, but it may not have replicated here yet
+		if (Message.Speaker)
+		{
+			Message.Speaker->ShowOverheadMessageById(Message.MessageId, Message.PaletteIndex, UOverheadMessageTable::DequantizeDuration(Message.QuantizedDuration));
+		}
+	}
+}
+
+#pragma endregion OverheadMessages
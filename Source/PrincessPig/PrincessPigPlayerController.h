@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "GameFramework/PlayerController.h"
 #include "Follow.h"
+#include "OverheadMessageTable.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "PrincessPigPlayerController.generated.h"
 
@@ -64,6 +65,15 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Interaction")
 	AActor* GetHighestPriorityInteraction();
 
+	/** Interaction currently shown in the prompt */
+	TWeakObjectPtr<AActor> PromptedInteraction;
+
+	void UpdateInteractionPrompt(AActor* TopInteraction);
+
+	/** Called when the top interaction changes, or becomes null */
+	UFUNCTION(BlueprintImplementableEvent, Category = "Interaction")
+	void BPEvent_OnInteractionPromptChanged(AActor* TopInteraction);
+
 #pragma endregion Interaction
 
 
@@ -80,13 +90,27 @@ public:
 
 #pragma region GameplayEvents
 
-	/** Called when the player's character dies. Maybe use this to spawn a ghost! */
+	/** Called when the player's character dies, after PossessGhost. Use it for effects */
 	UFUNCTION(BlueprintImplementableEvent, BlueprintCallable, Category = "GameplayEvents")
 	void BPEvent_OnCharacterDeath();
 
+	/** Server only. Take over a pooled ghost where the current pawn is. Returns null if there is no ghost class */
+	UFUNCTION(BlueprintCallable, Category = "GameplayEvents")
+	APawn* PossessGhost();
+
 #pragma endregion GameplayEvents
 
 
+
+#pragma region OverheadMessages
+
+	/** This frame's shouts from speakers relevant to this player, see APrincessPigGameState::QueueOverheadMessage */
+	UFUNCTION(Client, Unreliable)
+	void Client_ShowOverheadMessages(const TArray<FPPOverheadMessageEvent>& Messages);
+
+#pragma endregion OverheadMessages
+
+
 };
 
 
@@ -0,0 +1,317 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "ProximityService.h"
+#include "PrincessPig.h"
+#include "InteractionComponent.h"
+#include "Components/SceneComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "TimerManager.h"
+#include "WorldActorCache.h"
+
+DECLARE_CYCLE_STAT(TEXT("Proximity Update"), STAT_PPProximityUpdate, STATGROUP_PrincessPig);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Proximity Pair Tests"), STAT_PPProximityPairTests, STATGROUP_PrincessPig);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Proximity Sensors"), STAT_PPProximitySensors, STATGROUP_PrincessPig);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Proximity Targets"), STAT_PPProximityTargets, STATGROUP_PrincessPig);
+
+AProximityService::AProximityService()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = true;
+	PrimaryActorTick.TickGroup = TG_PostPhysics;
+
+	bReplicates = false;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>("Root");
+
+	UpdateInterval = 0.1f;
+	CellSize = 400.f;
+}
+
+void AProximityService::BeginPlay()
+{
+	Super::BeginPlay();
+
+	TPPWorldActorCache<AProximityService>::Add(this);
+
+	SetActorTickInterval(UpdateInterval);
+
+#if !UE_BUILD_SHIPPING
+	// Whatever is in the level already, then anything spawned later
+	for (TActorIterator<AActor> It(GetWorld()); It; ++It)
+	{
+		UncheckedActors.Add(*It);
+	}
+	GetWorldTimerManager().SetTimerForNextTick(this, &AProximityService::CheckUnregisteredTargets);
+	ActorSpawnedHandle = GetWorld()->AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &AProximityService::OnActorSpawned));
+#endif
+}
+
+void AProximityService::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+#if !UE_BUILD_SHIPPING
+	GetWorld()->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+#endif
+
+	TPPWorldActorCache<AProximityService>::Remove(this);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+#if !UE_BUILD_SHIPPING
+void AProximityService::OnActorSpawned(AActor* Actor)
+{
+	if (UncheckedActors.Num() == 0)
+	{
+		GetWorldTimerManager().SetTimerForNextTick(this, &AProximityService::CheckUnregisteredTargets);
+	}
+	UncheckedActors.Add(Actor);
+}
+
+void AProximityService::CheckUnregisteredTargets()
+{
+	// Would an interaction sphere have overlapped it?
+	const UInteractionComponent* SensorDefaults = GetDefault<UInteractionComponent>();
+	TInlineComponentArray<UPrimitiveComponent*> Primitives;
+	for (const TWeakObjectPtr<AActor>& Unchecked : UncheckedActors)
+	{
+		AActor* Actor = Unchecked.Get();
+		if (nullptr == Actor || WarnedClasses.Contains(Actor->GetClass()) || TargetIndices.Contains(Actor))
+		{
+			continue;
+		}
+
+		Actor->GetComponents(Primitives);
+		for (const UPrimitiveComponent* Primitive : Primitives)
+		{
+			if (Primitive->GetGenerateOverlapEvents() &&
+				Primitive->IsQueryCollisionEnabled() &&
+				!Primitive->IsA<UInteractionComponent>() &&
+				SensorDefaults->GetCollisionResponseToChannel(Primitive->GetCollisionObjectType()) == ECR_Overlap)
+			{
+				UE_LOG(LogPrincessPig, Warning, TEXT("%s overlaps interaction sensors but isn't registered with the proximity service, so sensors won't see it. Call AProximityService::RegisterTarget, or turn off bUseProximityService"), *Actor->GetClass()->GetName());
+				WarnedClasses.Add(Actor->GetClass());
+				break;
+			}
+		}
+	}
+	UncheckedActors.Reset();
+}
+#endif
+
+AProximityService* AProximityService::FindProximityService(const UObject* WorldContextObject)
+{
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::ReturnNull);
+	return TPPWorldActorCache<AProximityService>::Find(World);
+}
+
+AProximityService* AProximityService::GetProximityService(const UObject* WorldContextObject)
+{
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::ReturnNull);
+	if (nullptr == World || World->IsNetMode(NM_Client))
+	{
+		return nullptr;
+	}
+
+	if (AProximityService* Existing = TPPWorldActorCache<AProximityService>::Find(World))
+	{
+		return Existing;
+	}
+
+	// Cached now as well as in BeginPlay, in case play hasn't begun yet
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.ObjectFlags |= RF_Transient;
+	AProximityService* Service = World->SpawnActor<AProximityService>(SpawnParams);
+	if (Service)
+	{
+		TPPWorldActorCache<AProximityService>::Add(Service);
+	}
+	return Service;
+}
+
+void AProximityService::RegisterTarget(AActor* Actor)
+{
+	if (Actor && !TargetIndices.Contains(Actor))
+	{
+		TargetIndices.Add(Actor, Targets.Add(Actor));
+		INC_DWORD_STAT(STAT_PPProximityTargets);
+	}
+}
+
+void AProximityService::UnregisterTarget(AActor* Actor)
+{
+	// Cleared rather than removed, the grid holds indices until the next rebuild
+	int32 Index;
+	if (!TargetIndices.RemoveAndCopyValue(Actor, Index))
+	{
+		return;
+	}
+	Targets[Index] = nullptr;
+
+	// Anyone who could see it gets an end notification now, same as when an overlapping actor is destroyed
+	for (FPPProximitySensor& Sensor : Sensors)
+	{
+		if (Sensor.Nearby.Remove(Actor) > 0 && Sensor.Component.IsValid())
+		{
+			Sensor.Component->NotifyProximityEnd(Actor);
+		}
+	}
+}
+
+void AProximityService::RegisterSensor(UInteractionComponent* Sensor)
+{
+	if (Sensor && !Sensors.ContainsByPredicate([Sensor](const FPPProximitySensor& Existing) { return Existing.Component == Sensor; }))
+	{
+		FPPProximitySensor& NewSensor = Sensors.AddDefaulted_GetRef();
+		NewSensor.Component = Sensor;
+		INC_DWORD_STAT(STAT_PPProximitySensors);
+	}
+}
+
+void AProximityService::UnregisterSensor(UInteractionComponent* Sensor)
+{
+	// Cleared rather than removed, this may be called while sensors are being updated
+	for (FPPProximitySensor& Existing : Sensors)
+	{
+		if (Existing.Component == Sensor)
+		{
+			Existing.Component = nullptr;
+			Existing.Nearby.Reset();
+		}
+	}
+}
+
+FIntPoint AProximityService::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
+
+void AProximityService::RebuildGrid()
+{
+	for (auto& Cell : Grid)
+	{
+		Cell.Value.Reset();
+	}
+
+	for (int32 i = Targets.Num() - 1; i >= 0; i--)
+	{
+		if (!Targets[i].IsValid())
+		{
+			// Destroyed without unregistering still leaves a key behind
+			TargetIndices.Remove(Targets[i]);
+			Targets.RemoveAtSwap(i);
+			if (Targets.IsValidIndex(i))
+			{
+				TargetIndices.Add(Targets[i], i);
+			}
+			DEC_DWORD_STAT(STAT_PPProximityTargets);
+		}
+	}
+
+	for (int32 i = 0; i < Targets.Num(); i++)
+	{
+		Grid.FindOrAdd(GetCell(Targets[i]->GetActorLocation())).Add(i);
+	}
+}
+
+void AProximityService::UpdateSensor(FPPProximitySensor& Sensor)
+{
+	UInteractionComponent* Component = Sensor.Component.Get();
+	AActor* Owner = Component->GetOwner();
+	const FVector Centre = Component->GetComponentLocation();
+	const float Radius = Component->GetScaledSphereRadius();
+
+	// Same test the sphere made against the target's bounds, flattened to a cylinder
+	TArray<TWeakObjectPtr<AActor>, TInlineAllocator<8>> NowNearby;
+	const FIntPoint CentreCell = GetCell(Centre);
+	for (int32 X = CentreCell.X - 1; X <= CentreCell.X + 1; X++)
+	{
+		for (int32 Y = CentreCell.Y - 1; Y <= CentreCell.Y + 1; Y++)
+		{
+			const TArray<int32, TInlineAllocator<8>>* Cell = Grid.Find(FIntPoint(X, Y));
+			if (nullptr == Cell)
+			{
+				continue;
+			}
+
+			for (int32 TargetIndex : *Cell)
+			{
+				AActor* Target = Targets[TargetIndex].Get();
+				if (nullptr == Target || Target == Owner)
+				{
+					continue;
+				}
+
+				INC_DWORD_STAT(STAT_PPProximityPairTests);
+
+				const USceneComponent* TargetRoot = Target->GetRootComponent();
+				const FVector Extent = TargetRoot ? TargetRoot->Bounds.BoxExtent : FVector::ZeroVector;
+				const FVector ToTarget = Target->GetActorLocation() - Centre;
+				const float Reach = Radius + FMath::Max(Extent.X, Extent.Y);
+				if (ToTarget.SizeSquared2D() <= Reach * Reach && FMath::Abs(ToTarget.Z) <= Radius + Extent.Z)
+				{
+					NowNearby.Add(Target);
+				}
+			}
+		}
+	}
+
+	// Diff against last update. Notifications may change the sets, so collect first
+	TArray<AActor*, TInlineAllocator<8>> Ended;
+	for (const TWeakObjectPtr<AActor>& Previous : Sensor.Nearby)
+	{
+		if (Previous.IsValid() && !NowNearby.Contains(Previous))
+		{
+			Ended.Add(Previous.Get());
+		}
+	}
+
+	TArray<AActor*, TInlineAllocator<8>> Began;
+	for (const TWeakObjectPtr<AActor>& Current : NowNearby)
+	{
+		if (!Sensor.Nearby.Contains(Current))
+		{
+			Began.Add(Current.Get());
+		}
+	}
+
+	Sensor.Nearby = MoveTemp(NowNearby);
+
+	for (AActor* Actor : Ended)
+	{
+		Component->NotifyProximityEnd(Actor);
+	}
+	for (AActor* Actor : Began)
+	{
+		Component->NotifyProximityBegin(Actor);
+	}
+}
+
+void AProximityService::Tick(float DeltaSeconds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PPProximityUpdate);
+
+	Super::Tick(DeltaSeconds);
+
+	RebuildGrid();
+
+	for (int32 i = Sensors.Num() - 1; i >= 0; i--)
+	{
+		if (!Sensors[i].Component.IsValid())
+		{
+			Sensors.RemoveAtSwap(i);
+			DEC_DWORD_STAT(STAT_PPProximitySensors);
+		}
+	}
+
+	// Notifications may register sensors, so don't hold on to elements across them
+	const int32 NumSensors = Sensors.Num();
+	for (int32 i = 0; i < NumSensors; i++)
+	{
+		if (Sensors[i].Component.IsValid())
+		{
+			UpdateSensor(Sensors[i]);
+		}
+	}
+}
@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "ProximityService.generated.h"
+
+class UInteractionComponent;
+
+struct FPPProximitySensor
+{
+	TWeakObjectPtr<UInteractionComponent> Component;
+
+	/** Targets inside the sensor as of the last update */
+	TArray<TWeakObjectPtr<AActor>, TInlineAllocator<8>> Nearby;
+};
+
+/**
+ * Server-side replacement for interaction overlap spheres.
+ *
+ * Interactable actors register as targets and are binned into a 2D grid every update.
+ * Each registered UInteractionComponent then only tests the targets in the cells around
+ * it, and gets the same begin/end overlap notifications its sphere would have sent.
+ * Updates run at a fixed rate instead of on every physics move.
+ *
+ * Anything that isn't registered is invisible to sensors, even if the sphere would have overlapped
+ * it. Outside shipping builds, actors that a sensor sphere would overlap but that haven't
+ * registered a frame after spawning are logged, once per class.
+ *
+ * Spawned on first use. Settings can be changed in DefaultGame.ini under
+ * [/Script/PrincessPig.ProximityService].
+ */
+UCLASS(NotPlaceable, Transient, Config = Game)
+class PRINCESSPIG_API AProximityService : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AProximityService();
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Find or spawn the service for this world. Returns null on clients */
+	UFUNCTION(BlueprintCallable, Category = "Interaction", meta = (WorldContext = "WorldContextObject"))
+	static AProximityService* GetProximityService(const UObject* WorldContextObject);
+
+	/** Like GetProximityService, but never spawns one. Use when tearing down */
+	static AProximityService* FindProximityService(const UObject* WorldContextObject);
+
+	/** Seconds between updates */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Interaction")
+	float UpdateInterval;
+
+	/** Grid cell size. Should be at least a sensor diameter plus the largest target, so only neighbouring cells need checking */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Interaction")
+	float CellSize;
+
+	/** Make Actor detectable by interaction sensors */
+	UFUNCTION(BlueprintCallable, Category = "Interaction")
+	void RegisterTarget(AActor* Actor);
+
+	UFUNCTION(BlueprintCallable, Category = "Interaction")
+	void UnregisterTarget(AActor* Actor);
+
+	void RegisterSensor(UInteractionComponent* Sensor);
+	void UnregisterSensor(UInteractionComponent* Sensor);
+
+protected:
+	TArray<TWeakObjectPtr<AActor>> Targets;
+	TArray<FPPProximitySensor> Sensors;
+
+	/** Where each registered target is in Targets, kept in step with it */
+	TMap<TWeakObjectPtr<AActor>, int32> TargetIndices;
+
+	/** Target indices by cell, rebuilt every update */
+	TMap<FIntPoint, TArray<int32, TInlineAllocator<8>>> Grid;
+
+	FIntPoint GetCell(const FVector& Location) const;
+	void RebuildGrid();
+	void UpdateSensor(FPPProximitySensor& Sensor);
+
+#if !UE_BUILD_SHIPPING
+	/** Spawned since the last check, looked at a frame later once they have had a chance to register */
+	TArray<TWeakObjectPtr<AActor>> UncheckedActors;
+	TSet<const UClass*> WarnedClasses;
+	FDelegateHandle ActorSpawnedHandle;
+
+	void OnActorSpawned(AActor* Actor);
+	void CheckUnregisteredTargets();
+#endif
+};
@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SmokeCloud.h"
+#include "SmokeGrid.h"
+#include "Engine/World.h"
+#include "TimerManager.h"
+
+ASmokeCloud::ASmokeCloud()
+{
+	SmokeRadius = 300.f;
+	SmokeDensity = 1.f;
+	StampInterval = 0.5f;
+}
+
+void ASmokeCloud::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Spawned without a pool
+	if (HasAuthority() && nullptr == OwningPool && IsInUse())
+	{
+		StartStampingSmoke();
+	}
+}
+
+void ASmokeCloud::OnAcquiredFromPool()
+{
+	Super::OnAcquiredFromPool();
+
+	StartStampingSmoke();
+}
+
+void ASmokeCloud::OnReturnedToPool()
+{
+	StopStampingSmoke();
+
+	Super::OnReturnedToPool();
+}
+
+void ASmokeCloud::StartStampingSmoke()
+{
+	StampSmoke();
+	GetWorldTimerManager().SetTimer(StampTimer, this, &ASmokeCloud::StampSmoke, FMath::Max(StampInterval, 0.05f), true);
+}
+
+void ASmokeCloud::StopStampingSmoke()
+{
+	GetWorldTimerManager().ClearTimer(StampTimer);
+}
+
+void ASmokeCloud::StampSmoke()
+{
+	ASmokeGrid* SmokeGrid = ASmokeGrid::GetSmokeGrid(this);
+	if (SmokeGrid)
+	{
+		SmokeGrid->StampSmoke(GetActorLocation(), SmokeRadius, SmokeDensity);
+	}
+}
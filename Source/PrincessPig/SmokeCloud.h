@@ -0,0 +1,46 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PooledActor.h"
+#include "SmokeCloud.generated.h"
+
+/**
+ * Base for smoke clouds. While in use, the server keeps stamping the cloud into the
+ * ASmokeGrid so guards can't see through it. The grid fades it out once the cloud is gone.
+ */
+UCLASS()
+class PRINCESSPIG_API ASmokeCloud : public APooledActor
+{
+	GENERATED_BODY()
+
+public:
+	ASmokeCloud();
+
+	virtual void BeginPlay() override;
+
+	virtual void OnAcquiredFromPool() override;
+	virtual void OnReturnedToPool() override;
+
+	/** Radius of the thick part of the cloud */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Smoke")
+	float SmokeRadius;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Smoke")
+	float SmokeDensity;
+
+	/** Seconds between stamps. Should be well under the grid's DecayTime */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Smoke")
+	float StampInterval;
+
+	/** Stop stamping, e.g. when the cloud starts to thin out. The grid fades what is left */
+	UFUNCTION(BlueprintCallable, Category = "Smoke")
+	void StopStampingSmoke();
+
+protected:
+	void StartStampingSmoke();
+	void StampSmoke();
+
+	FTimerHandle StampTimer;
+};
@@ -0,0 +1,202 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "SmokeGrid.h"
+#include "PrincessPig.h"
+#include "Components/SceneComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "WorldActorCache.h"
+
+DECLARE_CYCLE_STAT(TEXT("Smoke Grid March"), STAT_PPSmokeGridMarch, STATGROUP_PrincessPig);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Smoke Grid Marches"), STAT_PPSmokeGridMarches, STATGROUP_PrincessPig);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Smoke Grid Cells"), STAT_PPSmokeGridCells, STATGROUP_PrincessPig);
+
+/** Below this a cell is treated as clear and dropped */
+static const float SmokeGridMinDensity = 0.01f;
+
+ASmokeGrid::ASmokeGrid()
+{
+	// Decay is worked out when cells are read, nothing to tick
+	PrimaryActorTick.bCanEverTick = false;
+
+	bReplicates = false;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>("Root");
+
+	CellSize = 100.f;
+	DecayTime = 4.f;
+	BlockingDepth = 1.5f;
+}
+
+void ASmokeGrid::BeginPlay()
+{
+	Super::BeginPlay();
+
+	TPPWorldActorCache<ASmokeGrid>::Add(this);
+}
+
+void ASmokeGrid::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	TPPWorldActorCache<ASmokeGrid>::Remove(this);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+ASmokeGrid* ASmokeGrid::GetSmokeGrid(const UObject* WorldContextObject)
+{
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::ReturnNull);
+	if (nullptr == World || World->IsNetMode(NM_Client))
+	{
+		return nullptr;
+	}
+
+	if (ASmokeGrid* Existing = TPPWorldActorCache<ASmokeGrid>::Find(World))
+	{
+		return Existing;
+	}
+
+	// Cached now as well as in BeginPlay, in case play hasn't begun yet
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.ObjectFlags |= RF_Transient;
+	ASmokeGrid* Grid = World->SpawnActor<ASmokeGrid>(SpawnParams);
+	if (Grid)
+	{
+		TPPWorldActorCache<ASmokeGrid>::Add(Grid);
+	}
+	return Grid;
+}
+
+bool ASmokeGrid::IsSightBlockedBySmoke(const UObject* WorldContextObject, FVector Start, FVector End)
+{
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::ReturnNull);
+	if (nullptr == World)
+	{
+		return false;
+	}
+
+	// Don't spawn a grid just to find out there is no smoke
+	const ASmokeGrid* Grid = TPPWorldActorCache<ASmokeGrid>::Find(World);
+	return Grid && Grid->Cells.Num() > 0 && Grid->GetSmokeDepth(Start, End) >= Grid->BlockingDepth;
+}
+
+float ASmokeGrid::GetCellDensity(const FIntPoint& Cell, float Now) const
+{
+	const FPPSmokeCell* Found = Cells.Find(Cell);
+	if (nullptr == Found)
+	{
+		return 0.f;
+	}
+	return Found->Density * FMath::Exp(-(Now - Found->StampTime) / FMath::Max(DecayTime, KINDA_SMALL_NUMBER));
+}
+
+void ASmokeGrid::StampSmoke(FVector Location, float Radius, float Density)
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	// Old cells are cleared out now and then, rather than on a tick
+	if (Cells.Num() > 0)
+	{
+		RemoveClearCells();
+	}
+
+	const int32 MinX = FMath::FloorToInt((Location.X - Radius) / CellSize);
+	const int32 MaxX = FMath::FloorToInt((Location.X + Radius) / CellSize);
+	const int32 MinY = FMath::FloorToInt((Location.Y - Radius) / CellSize);
+	const int32 MaxY = FMath::FloorToInt((Location.Y + Radius) / CellSize);
+	const float RadiusSquared = FMath::Square(Radius + CellSize * 0.5f);
+
+	for (int32 X = MinX; X <= MaxX; X++)
+	{
+		for (int32 Y = MinY; Y <= MaxY; Y++)
+		{
+			const FVector2D CellCentre((X + 0.5f) * CellSize, (Y + 0.5f) * CellSize);
+			if ((CellCentre - FVector2D(Location)).SizeSquared() > RadiusSquared)
+			{
+				continue;
+			}
+
+			const FIntPoint Cell(X, Y);
+			if (GetCellDensity(Cell, Now) < Density)
+			{
+				FPPSmokeCell& Stamped = Cells.FindOrAdd(Cell);
+				Stamped.Density = Density;
+				Stamped.StampTime = Now;
+			}
+		}
+	}
+
+	SET_DWORD_STAT(STAT_PPSmokeGridCells, Cells.Num());
+}
+
+void ASmokeGrid::RemoveClearCells()
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+	for (auto It = Cells.CreateIterator(); It; ++It)
+	{
+		if (GetCellDensity(It.Key(), Now) < SmokeGridMinDensity)
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+float ASmokeGrid::GetDensityAt(FVector Location) const
+{
+	const FIntPoint Cell(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+	return GetCellDensity(Cell, GetWorld()->GetTimeSeconds());
+}
+
+float ASmokeGrid::GetSmokeDepth(FVector Start, FVector End) const
+{
+	if (Cells.Num() == 0)
+	{
+		return 0.f;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_PPSmokeGridMarch);
+	INC_DWORD_STAT(STAT_PPSmokeGridMarches);
+
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	// Walk the cells the line crosses in order, in cell units (Amanatides & Woo)
+	const FVector2D From = FVector2D(Start) / CellSize;
+	const FVector2D Delta = FVector2D(End) / CellSize - From;
+	const float Length = Delta.Size();
+	if (Length < KINDA_SMALL_NUMBER)
+	{
+		return 0.f;
+	}
+
+	FIntPoint Cell(FMath::FloorToInt(From.X), FMath::FloorToInt(From.Y));
+	const FIntPoint Step(Delta.X >= 0.f ? 1 : -1, Delta.Y >= 0.f ? 1 : -1);
+
+	// Distance along the line (0 to 1) to cross one cell, and to reach the first boundary
+	const FVector2D TDelta(
+		Delta.X != 0.f ? FMath::Abs(1.f / Delta.X) : BIG_NUMBER,
+		Delta.Y != 0.f ? FMath::Abs(1.f / Delta.Y) : BIG_NUMBER);
+	FVector2D TMax(
+		Delta.X != 0.f ? ((Step.X > 0 ? (Cell.X + 1 - From.X) : (From.X - Cell.X)) * TDelta.X) : BIG_NUMBER,
+		Delta.Y != 0.f ? ((Step.Y > 0 ? (Cell.Y + 1 - From.Y) : (From.Y - Cell.Y)) * TDelta.Y) : BIG_NUMBER);
+
+	float Depth = 0.f;
+	float T = 0.f;
+	while (T < 1.f)
+	{
+		const float NextT = FMath::Min3(TMax.X, TMax.Y, 1.f);
+		Depth += GetCellDensity(Cell, Now) * (NextT - T) * Length;
+		T = NextT;
+
+		if (TMax.X < TMax.Y)
+		{
+			Cell.X += Step.X;
+			TMax.X += TDelta.X;
+		}
+		else
+		{
+			Cell.Y += Step.Y;
+			TMax.Y += TDelta.Y;
+		}
+	}
+
+	return Depth;
+}
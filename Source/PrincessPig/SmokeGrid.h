@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "SmokeGrid.generated.h"
+
+struct FPPSmokeCell
+{
+	/** Density when last stamped */
+	float Density;
+	float StampTime;
+};
+
+/**
+ * Server-side 2D map of how smoky the level is.
+ *
+ * Smoke actors stamp density into cells around them, which then fades over DecayTime.
+ * Sight checks march along the line between two points one cell at a time and add up the
+ * smoke they pass through, which costs a few map lookups instead of a physics trace, and
+ * nothing at all when there is no smoke.
+ *
+ * Spawned on first use. Settings can be changed in DefaultGame.ini under
+ * [/Script/PrincessPig.SmokeGrid].
+ */
+UCLASS(NotPlaceable, Transient, Config = Game)
+class PRINCESSPIG_API ASmokeGrid : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ASmokeGrid();
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/** Find or spawn the grid for this world. Returns null on clients */
+	UFUNCTION(BlueprintCallable, Category = "Smoke", meta = (WorldContext = "WorldContextObject"))
+	static ASmokeGrid* GetSmokeGrid(const UObject* WorldContextObject);
+
+	/** Is the line from Start to End blocked by smoke? False if there is no grid */
+	UFUNCTION(BlueprintCallable, Category = "Smoke", meta = (WorldContext = "WorldContextObject"))
+	static bool IsSightBlockedBySmoke(const UObject* WorldContextObject, FVector Start, FVector End);
+
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Smoke")
+	float CellSize;
+
+	/** Seconds for stamped density to fade to about a third */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Smoke")
+	float DecayTime;
+
+	/** Total smoke (density times distance in cells) a sightline can pass through before it is blocked */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Smoke")
+	float BlockingDepth;
+
+	/** Fill a disc of cells with at least Density. Call this from smoke actors while they are thick */
+	UFUNCTION(BlueprintCallable, Category = "Smoke")
+	void StampSmoke(FVector Location, float Radius, float Density = 1.f);
+
+	/** Current density at Location */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Smoke")
+	float GetDensityAt(FVector Location) const;
+
+	/** Smoke passed through between Start and End, in density times cells */
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "Smoke")
+	float GetSmokeDepth(FVector Start, FVector End) const;
+
+protected:
+	TMap<FIntPoint, FPPSmokeCell> Cells;
+
+	float GetCellDensity(const FIntPoint& Cell, float Now) const;
+	void RemoveClearCells();
+};
@@ -0,0 +1,378 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "WanderPointCache.h"
+#include "PrincessPig.h"
+#include "Components/SceneComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "NavigationSystem.h"
+#include "NavMesh/RecastNavMesh.h"
+#include "WorldActorCache.h"
+
+DECLARE_CYCLE_STAT(TEXT("Wander Cache Build"), STAT_PPWanderCacheBuild, STATGROUP_PrincessPig);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Wander Cache Triangles"), STAT_PPWanderCacheTriangles, STATGROUP_PrincessPig);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Wander Samples Rejected"), STAT_PPWanderSamplesRejected, STATGROUP_PrincessPig);
+
+/** Draws per sample before giving up on landing inside the radius and on the right island */
+static const int32 WanderMaxSampleAttempts = 8;
+
+/** Cut Polygon down to the part where Location[Axis] * Sign <= Bound * Sign */
+static void ClipToAxis(TArray<FVector, TInlineAllocator<8>>& Polygon, int32 Axis, float Bound, float Sign)
+{
+	TArray<FVector, TInlineAllocator<8>> Clipped;
+	for (int32 i = 0; i < Polygon.Num(); i++)
+	{
+		const FVector& From = Polygon[i];
+		const FVector& To = Polygon[(i + 1) % Polygon.Num()];
+		const float FromOutside = (From[Axis] - Bound) * Sign;
+		const float ToOutside = (To[Axis] - Bound) * Sign;
+		if (FromOutside <= 0.f)
+		{
+			Clipped.Add(From);
+		}
+		if ((FromOutside < 0.f && ToOutside > 0.f) || (FromOutside > 0.f && ToOutside < 0.f))
+		{
+			Clipped.Add(FMath::Lerp(From, To, FromOutside / (FromOutside - ToOutside)));
+		}
+	}
+	Polygon = Clipped;
+}
+
+void FPPWanderAliasTable::Build(const TArray<float>& Weights)
+{
+	// Every slot holds its own index with some probability, or else its alias
+	const int32 Num = Weights.Num();
+	float Total = 0.f;
+	for (float Weight : Weights)
+	{
+		Total += Weight;
+	}
+
+	TArray<float> Scaled;
+	Scaled.SetNumUninitialized(Num);
+	Probability.Init(1.f, Num);
+	Alias.SetNumUninitialized(Num);
+	TArray<int32> Small;
+	TArray<int32> Large;
+	for (int32 i = 0; i < Num; i++)
+	{
+		Alias[i] = i;
+		Scaled[i] = Total > 0.f ? Weights[i] * Num / Total : 1.f;
+		(Scaled[i] < 1.f ? Small : Large).Add(i);
+	}
+
+	while (Small.Num() > 0 && Large.Num() > 0)
+	{
+		const int32 Less = Small.Pop(false);
+		const int32 More = Large.Pop(false);
+		Probability[Less] = Scaled[Less];
+		Alias[Less] = More;
+		Scaled[More] += Scaled[Less] - 1.f;
+		(Scaled[More] < 1.f ? Small : Large).Add(More);
+	}
+}
+
+int32 FPPWanderAliasTable::Pick() const
+{
+	const int32 Slot = FMath::RandHelper(Probability.Num());
+	return FMath::FRand() < Probability[Slot] ? Slot : Alias[Slot];
+}
+
+AWanderPointCache::AWanderPointCache()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	bReplicates = false;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>("Root");
+
+	CellSize = 500.f;
+	MaxSampleRadius = 1000.f;
+	NumNeighbourhoods = 0;
+	bDirty = true;
+}
+
+void AWanderPointCache::BeginPlay()
+{
+	Super::BeginPlay();
+
+	TPPWorldActorCache<AWanderPointCache>::Add(this);
+
+	UNavigationSystemV1* NavSys = UNavigationSystemV1::GetNavigationSystem(this);
+	if (NavSys)
+	{
+		NavSys->OnNavigationGenerationFinishedDelegate.AddDynamic(this, &AWanderPointCache::OnNavigationGenerationFinished);
+	}
+}
+
+void AWanderPointCache::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	UNavigationSystemV1* NavSys = UNavigationSystemV1::GetNavigationSystem(this);
+	if (NavSys)
+	{
+		NavSys->OnNavigationGenerationFinishedDelegate.RemoveDynamic(this, &AWanderPointCache::OnNavigationGenerationFinished);
+	}
+
+	TPPWorldActorCache<AWanderPointCache>::Remove(this);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+AWanderPointCache* AWanderPointCache::GetWanderPointCache(const UObject* WorldContextObject)
+{
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::ReturnNull);
+	if (nullptr == World || World->IsNetMode(NM_Client))
+	{
+		return nullptr;
+	}
+
+	if (AWanderPointCache* Existing = TPPWorldActorCache<AWanderPointCache>::Find(World))
+	{
+		return Existing;
+	}
+
+	// Cached now as well as in BeginPlay, in case play hasn't begun yet
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.ObjectFlags |= RF_Transient;
+	AWanderPointCache* Cache = World->SpawnActor<AWanderPointCache>(SpawnParams);
+	if (Cache)
+	{
+		TPPWorldActorCache<AWanderPointCache>::Add(Cache);
+	}
+	return Cache;
+}
+
+void AWanderPointCache::OnNavigationGenerationFinished(ANavigationData* NavData)
+{
+	// Rebuilt when next needed, so several tiles finishing together only cost one build
+	bDirty = true;
+}
+
+FIntPoint AWanderPointCache::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
+
+bool AWanderPointCache::HasTriangles()
+{
+	if (bDirty)
+	{
+		BuildCache();
+	}
+	return Triangles.Num() > 0;
+}
+
+void AWanderPointCache::BuildCache()
+{
+	SCOPE_CYCLE_COUNTER(STAT_PPWanderCacheBuild);
+
+	bDirty = false;
+	Triangles.Reset();
+	Cells.Reset();
+	CellIndices.Reset();
+	PolyIslands.Reset();
+	NumNeighbourhoods = FMath::Max(1, FMath::CeilToInt(MaxSampleRadius / CellSize));
+
+	UNavigationSystemV1* NavSys = UNavigationSystemV1::GetNavigationSystem(this);
+	const ARecastNavMesh* NavMesh = NavSys ? Cast<ARecastNavMesh>(NavSys->GetDefaultNavDataInstance(FNavigationSystem::DontCreate)) : nullptr;
+	if (nullptr == NavMesh)
+	{
+		return;
+	}
+
+	TArray<NavNodeRef> Polys;
+	TArray<FNavPoly> TilePolys;
+	for (int32 Tile = 0; Tile < NavMesh->GetNavMeshTilesCount(); Tile++)
+	{
+		TilePolys.Reset();
+		NavMesh->GetPolysInTile(Tile, TilePolys);
+		for (const FNavPoly& Poly : TilePolys)
+		{
+			Polys.Add(Poly.Ref);
+		}
+	}
+
+	// Flood fill connected polygons into islands
+	PolyIslands.Reserve(Polys.Num());
+	int32 NumIslands = 0;
+	TArray<NavNodeRef> Open;
+	TArray<NavNodeRef> Neighbours;
+	for (NavNodeRef Poly : Polys)
+	{
+		if (PolyIslands.Contains(Poly))
+		{
+			continue;
+		}
+
+		PolyIslands.Add(Poly, NumIslands);
+		Open.Add(Poly);
+		while (Open.Num() > 0)
+		{
+			Neighbours.Reset();
+			NavMesh->GetPolyNeighbors(Open.Pop(false), Neighbours);
+			for (NavNodeRef Neighbour : Neighbours)
+			{
+				if (!PolyIslands.Contains(Neighbour))
+				{
+					PolyIslands.Add(Neighbour, NumIslands);
+					Open.Add(Neighbour);
+				}
+			}
+		}
+		NumIslands++;
+	}
+
+	// Fan each polygon into triangles and clip them to the grid
+	TArray<FVector> Verts;
+	for (NavNodeRef Poly : Polys)
+	{
+		Verts.Reset();
+		if (!NavMesh->GetPolyVerts(Poly, Verts))
+		{
+			continue;
+		}
+
+		for (int32 i = 2; i < Verts.Num(); i++)
+		{
+			AddClippedTriangle(Verts[0], Verts[i - 1], Verts[i], PolyIslands[Poly]);
+		}
+	}
+
+	TArray<float> Areas;
+	for (FPPWanderCell& Cell : Cells)
+	{
+		Areas.Reset();
+		for (int32 Index : Cell.Triangles)
+		{
+			const FPPWanderTriangle& Triangle = Triangles[Index];
+			Areas.Add(0.5f * FVector::CrossProduct(Triangle.B - Triangle.A, Triangle.C - Triangle.A).Size());
+			Cell.Area += Areas.Last();
+		}
+		Cell.TriangleTable.Build(Areas);
+	}
+
+	for (const auto& Pair : CellIndices)
+	{
+		BuildNeighbourhoods(Cells[Pair.Value], Pair.Key);
+	}
+
+	SET_DWORD_STAT(STAT_PPWanderCacheTriangles, Triangles.Num());
+}
+
+void AWanderPointCache::AddClippedTriangle(const FVector& A, const FVector& B, const FVector& C, int32 Island)
+{
+	const FIntPoint MinCell = GetCell(FVector(FMath::Min3(A.X, B.X, C.X), FMath::Min3(A.Y, B.Y, C.Y), 0.f));
+	const FIntPoint MaxCell = GetCell(FVector(FMath::Max3(A.X, B.X, C.X), FMath::Max3(A.Y, B.Y, C.Y), 0.f));
+	TArray<FVector, TInlineAllocator<8>> Piece;
+	for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+		{
+			Piece.Reset();
+			Piece.Add(A);
+			Piece.Add(B);
+			Piece.Add(C);
+			ClipToAxis(Piece, 0, X * CellSize, -1.f);
+			ClipToAxis(Piece, 0, (X + 1) * CellSize, 1.f);
+			ClipToAxis(Piece, 1, Y * CellSize, -1.f);
+			ClipToAxis(Piece, 1, (Y + 1) * CellSize, 1.f);
+
+			// What is left is convex, so fan it back into triangles
+			for (int32 i = 2; i < Piece.Num(); i++)
+			{
+				FPPWanderTriangle Triangle;
+				Triangle.A = Piece[0];
+				Triangle.B = Piece[i - 1];
+				Triangle.C = Piece[i];
+				Triangle.Island = Island;
+				if (FVector::CrossProduct(Triangle.B - Triangle.A, Triangle.C - Triangle.A).SizeSquared() <= KINDA_SMALL_NUMBER)
+				{
+					continue;
+				}
+
+				const FIntPoint Coord(X, Y);
+				int32* CellIndex = CellIndices.Find(Coord);
+				if (nullptr == CellIndex)
+				{
+					CellIndex = &CellIndices.Add(Coord, Cells.AddDefaulted());
+				}
+				Cells[*CellIndex].Triangles.Add(Triangles.Add(Triangle));
+			}
+		}
+	}
+}
+
+void AWanderPointCache::BuildNeighbourhoods(FPPWanderCell& Cell, const FIntPoint& Coord)
+{
+	Cell.Neighbourhoods.SetNum(NumNeighbourhoods);
+	Cell.NeighbourhoodTables.SetNum(NumNeighbourhoods);
+	TArray<float> Areas;
+	for (int32 Rings = 1; Rings <= NumNeighbourhoods; Rings++)
+	{
+		TArray<int32>& Neighbourhood = Cell.Neighbourhoods[Rings - 1];
+		Areas.Reset();
+		for (int32 X = Coord.X - Rings; X <= Coord.X + Rings; X++)
+		{
+			for (int32 Y = Coord.Y - Rings; Y <= Coord.Y + Rings; Y++)
+			{
+				if (const int32* Neighbour = CellIndices.Find(FIntPoint(X, Y)))
+				{
+					Neighbourhood.Add(*Neighbour);
+					Areas.Add(Cells[*Neighbour].Area);
+				}
+			}
+		}
+		Cell.NeighbourhoodTables[Rings - 1].Build(Areas);
+	}
+}
+
+bool AWanderPointCache::SampleWanderPoint(const FVector& Origin, float Radius, NavNodeRef OriginPoly, FVector& OutLocation)
+{
+	if (!HasTriangles() || !CanSampleRadius(Radius))
+	{
+		return false;
+	}
+
+	// The smallest square of cells around ours that the circle fits in
+	const int32* OriginCell = CellIndices.Find(GetCell(Origin));
+	if (nullptr == OriginCell)
+	{
+		return false;
+	}
+	const int32 Rings = FMath::Clamp(FMath::CeilToInt(Radius / CellSize), 1, NumNeighbourhoods);
+	const TArray<int32>& Neighbourhood = Cells[*OriginCell].Neighbourhoods[Rings - 1];
+	const FPPWanderAliasTable& NeighbourhoodTable = Cells[*OriginCell].NeighbourhoodTables[Rings - 1];
+
+	const int32* OriginIsland = OriginPoly != INVALID_NAVNODEREF ? PolyIslands.Find(OriginPoly) : nullptr;
+
+	// Even over the walkable area of those cells, so even over the part inside the circle once the rest is thrown away
+	for (int32 Attempt = 0; Attempt < WanderMaxSampleAttempts; Attempt++)
+	{
+		const FPPWanderCell& Cell = Cells[Neighbourhood[NeighbourhoodTable.Pick()]];
+		const FPPWanderTriangle& Triangle = Triangles[Cell.Triangles[Cell.TriangleTable.Pick()]];
+		if (OriginIsland && *OriginIsland != Triangle.Island)
+		{
+			INC_DWORD_STAT(STAT_PPWanderSamplesRejected);
+			continue;
+		}
+
+		// Uniform point in the triangle
+		float U = FMath::FRand();
+		float V = FMath::FRand();
+		if (U + V > 1.f)
+		{
+			U = 1.f - U;
+			V = 1.f - V;
+		}
+		const FVector Location = Triangle.A + (Triangle.B - Triangle.A) * U + (Triangle.C - Triangle.A) * V;
+		if (FVector::DistSquared2D(Location, Origin) > FMath::Square(Radius))
+		{
+			INC_DWORD_STAT(STAT_PPWanderSamplesRejected);
+			continue;
+		}
+
+		OutLocation = Location;
+		return true;
+	}
+	return false;
+}
@@ -0,0 +1,118 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "AI/Navigation/NavigationTypes.h"
+#include "WanderPointCache.generated.h"
+
+class ANavigationData;
+
+struct FPPWanderTriangle
+{
+	FVector A;
+	FVector B;
+	FVector C;
+
+	/** Which connected piece of the navmesh this is on */
+	int32 Island;
+};
+
+/** Picks an index weighted by area in constant time, using Vose's alias method */
+struct FPPWanderAliasTable
+{
+	TArray<float> Probability;
+	TArray<int32> Alias;
+
+	void Build(const TArray<float>& Weights);
+	int32 Pick() const;
+};
+
+/** Triangles clipped to one cell, and the cells around it */
+struct FPPWanderCell
+{
+	TArray<int32> Triangles;
+	FPPWanderAliasTable TriangleTable;
+
+	/** Walkable area of all the triangles, for picking between cells */
+	float Area;
+
+	/** Cells within 1, 2, ... rings of this one, each with a table to pick one of them by area */
+	TArray<TArray<int32>> Neighbourhoods;
+	TArray<FPPWanderAliasTable> NeighbourhoodTables;
+
+	FPPWanderCell()
+		: Area(0.f)
+	{}
+};
+
+/**
+ * Server-side copy of the navmesh as triangles, for picking random points to walk to without a
+ * navmesh query each time.
+ *
+ * The navmesh polygons are split into triangles and clipped to a 2D grid, so every triangle lies
+ * inside one cell. Each cell keeps alias tables over the cells in the rings around it, one per
+ * ring count up to MaxSampleRadius. A sample takes the table for the smallest square of cells
+ * that covers the circle around the origin, picks a cell from it and then a triangle from that
+ * cell, both weighted by area, so each draw costs the same however big the radius or navmesh is.
+ * Points that land outside the radius are thrown away and drawn again, so what is left is spread
+ * evenly over the walkable surface inside the circle. Polygons are grouped into islands of
+ * connected navmesh, so points that can't be reached are thrown out without pathfinding.
+ *
+ * Built on first use and again whenever navigation finishes rebuilding. Needs a Recast navmesh.
+ * Settings can be changed in DefaultGame.ini under [/Script/PrincessPig.WanderPointCache].
+ */
+UCLASS(NotPlaceable, Transient, Config = Game)
+class PRINCESSPIG_API AWanderPointCache : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AWanderPointCache();
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/** Find or spawn the cache for this world. Returns null on clients */
+	UFUNCTION(BlueprintCallable, Category = "Navigation", meta = (WorldContext = "WorldContextObject"))
+	static AWanderPointCache* GetWanderPointCache(const UObject* WorldContextObject);
+
+	/** Grid cell size. Samples draw from the square of whole cells around the circle, so radii just under a multiple of this waste the fewest draws */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Navigation")
+	float CellSize;
+
+	/** Largest radius that can be sampled. Each cell keeps a table for every ring of cells out to here */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Navigation")
+	float MaxSampleRadius;
+
+	/** Pick a random point on the navmesh within Radius of Origin (in 2D), on the same island as OriginPoly if it is set */
+	bool SampleWanderPoint(const FVector& Origin, float Radius, NavNodeRef OriginPoly, FVector& OutLocation);
+
+	/** False without a Recast navmesh, in which case callers should fall back to a navmesh query */
+	bool HasTriangles();
+
+	bool CanSampleRadius(float Radius) const { return Radius <= MaxSampleRadius; }
+
+protected:
+	TArray<FPPWanderTriangle> Triangles;
+	TArray<FPPWanderCell> Cells;
+	TMap<FIntPoint, int32> CellIndices;
+	TMap<NavNodeRef, int32> PolyIslands;
+
+	/** Ring counts each cell has a neighbourhood table for */
+	int32 NumNeighbourhoods;
+
+	/** Navigation changed since the last build */
+	bool bDirty;
+
+	UFUNCTION()
+	void OnNavigationGenerationFinished(ANavigationData* NavData);
+
+	FIntPoint GetCell(const FVector& Location) const;
+	void BuildCache();
+
+	/** Add the part of a triangle inside each cell it crosses to that cell */
+	void AddClippedTriangle(const FVector& A, const FVector& B, const FVector& C, int32 Island);
+	void BuildNeighbourhoods(FPPWanderCell& Cell, const FIntPoint& Coord);
+};
@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/World.h"
+
+/**
+ * The one actor of type T in each world, for service actors that are looked up far more often
+ * than they are spawned. Actors add themselves in BeginPlay and remove themselves in EndPlay, so
+ * a lookup is a map find instead of an actor iterator, and finding nothing costs no more.
+ */
+template<typename T>
+class TPPWorldActorCache
+{
+public:
+	static T* Find(const UWorld* World)
+	{
+		const TWeakObjectPtr<T>* Found = World ? GetActors().Find(World) : nullptr;
+		T* Actor = Found ? Found->Get() : nullptr;
+		return (Actor && !Actor->IsPendingKill()) ? Actor : nullptr;
+	}
+
+	static void Add(T* Actor)
+	{
+		TMap<TWeakObjectPtr<const UWorld>, TWeakObjectPtr<T>>& Actors = GetActors();
+
+		// Drop worlds that have gone away while we're here
+		for (auto It = Actors.CreateIterator(); It; ++It)
+		{
+			if (!It.Key().IsValid() || !It.Value().IsValid())
+			{
+				It.RemoveCurrent();
+			}
+		}
+
+		Actors.Add(Actor->GetWorld(), Actor);
+	}
+
+	static void Remove(T* Actor)
+	{
+		TMap<TWeakObjectPtr<const UWorld>, TWeakObjectPtr<T>>& Actors = GetActors();
+		const TWeakObjectPtr<T>* Found = Actors.Find(Actor->GetWorld());
+		if (Found && Found->Get() == Actor)
+		{
+			Actors.Remove(Actor->GetWorld());
+		}
+	}
+
+private:
+	static TMap<TWeakObjectPtr<const UWorld>, TWeakObjectPtr<T>>& GetActors()
+	{
+		static TMap<TWeakObjectPtr<const UWorld>, TWeakObjectPtr<T>> Actors;
+		return Actors;
+	}
+};